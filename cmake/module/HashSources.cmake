@@ -0,0 +1,23 @@
+# Write a header that defines DMC_BUILD_ID as the hash of a list of sources.
+# Run as a script at build time:
+#
+#   cmake -DSOURCES=a.cpp|b.cpp -DOUTPUT=BuildId.h -P HashSources.cmake
+#
+# The sources are separated by `|`. The header is only rewritten if the hash
+# changes, so that its dependents are not rebuilt needlessly.
+string(REPLACE "|" ";" SOURCES "${SOURCES}")
+list(SORT SOURCES)
+set(HASHES "")
+foreach(SOURCE IN LISTS SOURCES)
+  file(SHA256 ${SOURCE} HASH)
+  string(APPEND HASHES "${HASH}\n")
+endforeach()
+string(SHA256 BUILD_ID "${HASHES}")
+
+set(CONTENT "#define DMC_BUILD_ID \"${BUILD_ID}\"\n")
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} OLD_CONTENT)
+endif()
+if(NOT "${CONTENT}" STREQUAL "${OLD_CONTENT}")
+  file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
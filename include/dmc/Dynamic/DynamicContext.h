@@ -6,6 +6,7 @@
 #include <mlir/IR/Types.h>
 #include <mlir/IR/Attributes.h>
 #include <mlir/IR/Dialect.h>
+#include <mlir/IR/PatternMatch.h>
 
 namespace dmc {
 
@@ -28,6 +29,9 @@ public:
   /// Create a DynamicDialect and return an instance registered with
   /// the MLIRContext.
   DynamicDialect *createDynamicDialect(llvm::StringRef name);
+  /// Lookup a dynamic dialect by namespace. Returns null if the dialect does
+  /// not exist or is not a dynamic dialect.
+  DynamicDialect *lookupDialect(llvm::StringRef name);
   /// Lookup the dynamic dialect belonging to a dynamic MLIR object. This is
   /// necessary since aliased types and attributes do subclass a generic class.
   ///
@@ -42,6 +46,11 @@ public:
   mlir::LogicalResult registerDialectSymbol(DynamicDialect *dialect,
                                             mlir::OperationName opName);
 
+  /// Add the declarative patterns of all dynamic dialects to a list. The
+  /// canonicalizer queries the patterns of each registered op, but all
+  /// dynamic ops share the hook, so the patterns are only added once per list.
+  void getCanonicalizationPatterns(mlir::OwningRewritePatternList &patterns);
+
 private:
   class Impl;
   TypeIDAllocator *typeIdAlloc;
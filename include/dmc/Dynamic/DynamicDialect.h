@@ -2,8 +2,10 @@
 
 #include "DynamicObject.h"
 #include "dmc/Spec/ParameterList.h"
+#include "dmc/Embed/FormatBackend.h"
 
 #include <mlir/IR/Dialect.h>
+#include <mlir/IR/PatternMatch.h>
 
 namespace dmc {
 
@@ -16,6 +18,9 @@ class TypeAlias;
 class AttributeAlias;
 class TypeMetadata;
 class AttributeMetadata;
+namespace py {
+class NativePattern;
+} // end namespace py
 
 /// Dynamic dialect underlying class. This class hooks Dialect methods
 /// into user-specified functions.
@@ -47,6 +52,17 @@ public:
     Dialect::allowUnknownTypes(allow);
   }
 
+  /// Set the backend used for the declarative formats of this dialect.
+  inline void setFormatBackend(py::FormatBackend backend) {
+    formatBackend = backend;
+  }
+  inline py::FormatBackend getFormatBackend() const { return formatBackend; }
+
+  /// Set a fingerprint of the spec that defined this dialect. Serialized
+  /// modules record it to check that they are read against the same spec.
+  inline void setSpecHash(uint64_t hash) { specHash = hash; }
+  inline uint64_t getSpecHash() const { return specHash; }
+
   /// Printing and parsing for dynamic types.
   mlir::Type parseType(mlir::DialectAsmParser &parser) const override;
   void printType(mlir::Type type,
@@ -59,6 +75,13 @@ public:
   void printAttribute(mlir::Attribute attr,
                       mlir::DialectAsmPrinter &printer) const override;
 
+  /// Materialize a folded constant with the first constant-like op of the
+  /// dialect that accepts the value and type. Builtin integers and floats
+  /// fall back to `std.constant`, if it is registered.
+  mlir::Operation *materializeConstant(mlir::OpBuilder &builder,
+                                       mlir::Attribute value, mlir::Type type,
+                                       mlir::Location loc) override;
+
   /// Register a DynamicOperation with this dialect so its config
   /// is stored for later use. The dialect takes ownership.
   mlir::LogicalResult registerDynamicOp(std::unique_ptr<DynamicOperation> op);
@@ -90,6 +113,12 @@ public:
   /// Lookup an attribute alias. Returns nullptr if not found.
   AttributeAlias *lookupAttrAlias(llvm::StringRef name) const;
 
+  /// Add a compiled declarative pattern. The dialect takes ownership.
+  void addPattern(std::unique_ptr<py::NativePattern> pattern);
+  /// Add the declarative patterns of the dialect to a list.
+  void getCanonicalizationPatterns(
+      mlir::OwningRewritePatternList &patterns) const;
+
   /// Lookup dynamic type metadata associated with a type, if any.
   TypeMetadata *lookupTypeData(mlir::Type type);
   /// Lookup dynamic attribute metadata associated with an attribute, if any.
@@ -105,6 +134,8 @@ public:
 private:
   class Impl;
   std::unique_ptr<Impl> impl;
+  py::FormatBackend formatBackend{py::FormatBackend::Python};
+  uint64_t specHash{};
 
   friend class DynamicOperation;
 };
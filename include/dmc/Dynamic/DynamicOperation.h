@@ -1,7 +1,12 @@
 #pragma once
 
 #include "DynamicObject.h"
+#include "TypeIDAllocator.h"
+#include "dmc/Embed/FoldCompiler.h"
+#include "dmc/Embed/NativeOpFormat.h"
+#include "dmc/Embed/ParserPrinter.h"
 
+#include <llvm/ADT/BitVector.h>
 #include <llvm/ADT/StringMap.h>
 #include <mlir/IR/OperationSupport.h>
 #include <mlir/IR/OpDefinition.h>
@@ -17,20 +22,53 @@ class DynamicDialect;
 class DynamicTrait {
 public:
   virtual ~DynamicTrait() = default;
+  /// Verify the invariant on an op. Different ops may be verified
+  /// concurrently, so the verifier must not modify the trait.
   virtual mlir::LogicalResult verifyOp(mlir::Operation *op) const {
     return mlir::success();
   }
+  /// Whether verifyOp may enter the Python interpreter. Ops whose traits
+  /// all verify natively are verified without the GIL.
+  virtual bool verifiesInPython() const { return false; }
   virtual mlir::AbstractOperation::OperationProperties
   getTraitProperties() const {
     return mlir::AbstractOperation::OperationProperties{};
   }
 };
 
+/// Dynamic traits are identified by small, dense integer IDs assigned to trait
+/// names. Traits registered with the TraitRegistry are assigned IDs on
+/// registration; other traits are assigned IDs on first use.
+unsigned getTraitID(llvm::StringRef name);
+/// Lookup the ID of a trait name without assigning one. Returns None if the
+/// trait has not been assigned an ID.
+llvm::Optional<unsigned> lookupTraitID(llvm::StringRef name);
+
+/// Get the ID of a trait class. The ID is cached after the first call.
+template <typename TraitT> unsigned getTraitID() {
+  static const unsigned id = getTraitID(TraitT::getName());
+  return id;
+}
+
+/// A memory effect of a dynamic op, precomputed from its memory effect traits.
+/// The effect applies either to the whole op or to each value of an operand or
+/// result group, referred to by index.
+struct DynamicMemoryEffect {
+  enum Target { Op, Operand, Result };
+
+  mlir::MemoryEffects::Effect *effect;
+  Target target;
+  unsigned groupIdx;
+};
+
 /// This class dynamically captures properties of an Operation.
 class DynamicOperation : public DynamicObject {
 public:
-  /// Lookup the DynamicOperation backing an Operation.
-  static DynamicOperation *of(mlir::Operation *op);
+  /// Lookup the DynamicOperation backing an Operation. The DynamicOperation
+  /// is bound to the TypeID of its AbstractOperation when it is finalized, so
+  /// the lookup is a single load.
+  static inline DynamicOperation *of(mlir::Operation *op);
+  static inline DynamicOperation *of(const mlir::AbstractOperation *opInfo);
 
   DynamicOperation(llvm::StringRef name, DynamicDialect *dialect);
 
@@ -53,8 +91,28 @@ public:
   template <typename TraitT, typename... Args>
   mlir::LogicalResult addOpTrait(Args &&... args);
 
-  /// Set a custom parser and printer.
-  void setOpFormat(std::string parserName, std::string printerName);
+  /// Set a custom parser and printer. Fails if the functions are not
+  /// defined in the internal scope.
+  mlir::LogicalResult setOpFormat(mlir::Location loc, std::string parserName,
+                                  std::string printerName);
+  /// Set a natively compiled format. The native format is used instead of
+  /// the Python functions while it is enabled.
+  void setNativeOpFormat(std::unique_ptr<py::NativeOpFormat> format);
+  inline bool hasNativeOpFormat() const { return nativeFormat != nullptr; }
+  inline void useNativeOpFormat(bool enable) {
+    useNative = enable && hasNativeOpFormat();
+  }
+
+  /// Set the fold hook: a natively compiled fold, if present, and the name of
+  /// a Python fold function in the main scope, which is tried if the native
+  /// fold fails. An op with a constant fold is marked ConstantLike.
+  void setFold(std::unique_ptr<py::NativeFold> fold, std::string pyFoldName);
+  inline llvm::Optional<llvm::StringRef> getConstantAttrName() const {
+    return nativeFold ? nativeFold->getConstantAttrName() : llvm::None;
+  }
+  inline bool isConstantLike() const {
+    return getConstantAttrName().hasValue();
+  }
 
   /// DynamicOperation creation: define the Base Operation, add properties,
   /// traits, custom functions, hooks, etc, then register with Dialect.
@@ -64,46 +122,104 @@ public:
 
   /// Delegate function to verify each OpTrait.
   mlir::LogicalResult verifyOpTraits(mlir::Operation *op) const;
+  /// Whether verifying the Op may enter Python, computed during finalize().
+  inline bool verifiesInPython() const { return pythonVerifier; }
   /// Get amalgamated Operation properties from traits.
   mlir::AbstractOperation::OperationProperties getOpProperties() const;
+  /// Get the memory effects of the Operation, computed during finalize().
+  inline llvm::ArrayRef<DynamicMemoryEffect> getMemoryEffects() const {
+    return effects;
+  }
+
+  /// Get the operand or result group at an index, accounting for variadic
+  /// size traits.
+  mlir::ValueRange getOperandGroup(mlir::Operation *op, unsigned idx);
+  mlir::ValueRange getResultGroup(mlir::Operation *op, unsigned idx);
 
   /// Higher-level DynamicOperation specification info is made
-  /// available to traits and other verifiers through traits.
+  /// available to traits and other verifiers through traits. Lookups by trait
+  /// ID are a bit test and a load.
   template <typename TraitT> TraitT *getTrait();
-  DynamicTrait *getTrait(llvm::StringRef);
+  DynamicTrait *getTrait(llvm::StringRef name);
+  inline DynamicTrait *getTrait(unsigned id) const {
+    return hasTrait(id) ? traitSlots[id] : nullptr;
+  }
+
+  /// Query whether the Op has a trait.
+  template <typename TraitT> bool hasTrait() const {
+    return hasTrait(getTraitID<TraitT>());
+  }
+  inline bool hasTrait(unsigned id) const {
+    return id < traitBits.size() && traitBits.test(id);
+  }
 
   /// Parse or print an operation.
   mlir::ParseResult parseOperation(mlir::OpAsmParser &parser,
                                    mlir::OperationState &result);
   void printOperation(mlir::OpAsmPrinter &printer, mlir::Operation *op);
+  /// Fold an operation with the native fold, then the Python fold.
+  mlir::LogicalResult foldOperation(
+      mlir::Operation *op, llvm::ArrayRef<mlir::Attribute> operands,
+      llvm::SmallVectorImpl<mlir::OpFoldResult> &results);
 
 private:
+  /// Compile the memory effect traits into a list of effects.
+  void buildMemoryEffects();
+
   /// Full operation name: `dialect`.`opName`.
   const std::string name;
   /// Associated Dialect.
   DynamicDialect * const dialect;
 
-  /// A list of dynamic OpTraits. Lookups and insertions are linear time as
-  /// there are assumed to be few traits. Using a vector also guarantees that
-  /// the traits are checked in insertion order.
-  std::vector<std::pair<llvm::StringRef, std::unique_ptr<DynamicTrait>>> traits;
+  /// A list of dynamic OpTraits, keyed by trait ID. Using a vector guarantees
+  /// that the traits are checked in insertion order.
+  std::vector<std::pair<unsigned, std::unique_ptr<DynamicTrait>>> traits;
+  /// The set of trait IDs of this Op, and the traits indexed by ID.
+  llvm::BitVector traitBits;
+  std::vector<DynamicTrait *> traitSlots;
 
-  /// The function names of the custom parser and printers, if present.
-  llvm::Optional<std::string> parserFcn, printerFcn;
+  /// The resolved custom parser and printer functions, if present.
+  py::PythonFunction parserFcn, printerFcn;
+  /// The natively compiled format, if present, and whether it is used.
+  std::unique_ptr<py::NativeOpFormat> nativeFormat;
+  bool useNative{};
+  /// The fold hooks, if present.
+  std::unique_ptr<py::NativeFold> nativeFold;
+  std::string pyFoldName;
+
+  /// Memory effects in the order they are reported by getEffects().
+  std::vector<DynamicMemoryEffect> effects;
+  /// Whether any trait verifies in Python.
+  bool pythonVerifier{};
 
   // Operation info
   const mlir::AbstractOperation *opInfo;
 };
 
 /// Out-of-line definitions
+DynamicOperation *DynamicOperation::of(mlir::Operation *op) {
+  auto *opInfo = op->getAbstractOperation();
+  assert(opInfo && "Dynamic operation is not registered");
+  return of(opInfo);
+}
+
+DynamicOperation *
+DynamicOperation::of(const mlir::AbstractOperation *opInfo) {
+  auto *dynOp = static_cast<DynamicOperation *>(
+      lookupTypeIDObject(opInfo->typeID));
+  assert(dynOp && "Operation is not a finalized dynamic operation");
+  return dynOp;
+}
+
 template <typename TraitT, typename... Args>
 mlir::LogicalResult DynamicOperation::addOpTrait(Args &&... args) {
   return addOpTrait(TraitT::getName(), std::make_unique<TraitT>(
       std::forward<Args>(args)...));
 }
 
+/// A trait ID is only ever assigned to one trait class, so the cast is safe.
 template <typename TraitT> TraitT *DynamicOperation::getTrait() {
-  return dynamic_cast<TraitT *>(getTrait(TraitT::getName()));
+  return static_cast<TraitT *>(getTrait(getTraitID<TraitT>()));
 }
 
 /// Mark dynamic operations with this OpTrait. Also, Op requires at least one
@@ -144,9 +260,13 @@ public:
   static mlir::LogicalResult foldHook(
       mlir::Operation *op, llvm::ArrayRef<mlir::Attribute> operands,
       llvm::SmallVectorImpl<mlir::OpFoldResult> &results) {
-    // TODO custom fold hooks
-    return mlir::failure();
+    return DynamicOperation::of(op)->foldOperation(op, operands, results);
   }
+  /// Trait query of constant-like ops, which are recognized by m_Constant.
+  static bool hasConstantLikeTrait(mlir::TypeID traitID);
+  /// Add the declarative patterns of all dynamic dialects.
+  static void getCanonicalizationPatterns(
+      mlir::OwningRewritePatternList &results, mlir::MLIRContext *ctx);
 
   // MemoryEffectOpInterface
   void getEffects(llvm::SmallVectorImpl<mlir::SideEffects::EffectInstance<
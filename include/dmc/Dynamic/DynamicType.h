@@ -4,6 +4,8 @@
 #include "DynamicObject.h"
 #include "dmc/Kind.h"
 #include "dmc/Spec/ParameterList.h"
+#include "dmc/Embed/NativeTypeFormat.h"
+#include "dmc/Embed/ParserPrinter.h"
 
 #include <mlir/IR/DialectImplementation.h>
 
@@ -32,7 +34,19 @@ public:
   /// Delegate parser and printer.
   mlir::Type parseType(mlir::Location loc, mlir::DialectAsmParser &parser);
   void printType(mlir::Type type, mlir::DialectAsmPrinter &printer);
-  void setFormat(std::string parserName, std::string printerName);
+  /// Set the custom parser and printer. Fails if the functions are not
+  /// defined in the internal scope.
+  mlir::LogicalResult setFormat(mlir::Location loc, std::string parserName,
+                                std::string printerName);
+  /// Set a natively compiled format. The native format is used instead of
+  /// the Python functions while it is enabled.
+  void setNativeFormat(std::unique_ptr<py::NativeTypeFormat> format);
+  inline bool hasNativeFormat() const { return nativeFormat != nullptr; }
+  /// Returns true if the parser is not the default parameter list parser.
+  inline bool hasCustomFormat() const { return useNative || parserFcn; }
+  inline void useNativeFormat(bool enable) {
+    useNative = enable && hasNativeFormat();
+  }
 
 private:
   /// The dialect to which this type belongs.
@@ -41,8 +55,11 @@ private:
   /// instances must be Spec attributes.
   NamedParameterRange paramSpec;
 
-  /// The function names of the custom parser and printer, if present.
-  llvm::Optional<std::string> parserFcn, printerFcn;
+  /// The resolved custom parser and printer functions, if present.
+  py::PythonFunction parserFcn, printerFcn;
+  /// The natively compiled format, if present, and whether it is used.
+  std::unique_ptr<py::NativeTypeFormat> nativeFormat;
+  bool useNative{};
 
   friend class DynamicType;
 };
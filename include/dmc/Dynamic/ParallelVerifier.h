@@ -0,0 +1,17 @@
+#pragma once
+
+#include <mlir/IR/Module.h>
+
+namespace dmc {
+
+/// Verify a module, verifying its top-level ops that are isolated from above,
+/// e.g. functions, in parallel. Dynamic ops that verify natively are verified
+/// without the GIL. A function containing ops with interpreted constraints
+/// holds the GIL once while it is verified, instead of once per constraint.
+///
+/// Diagnostics are reported in op order. Uses `threads` workers, or one per
+/// hardware thread if zero. Modules that cannot be split are verified
+/// serially.
+mlir::LogicalResult verifyParallel(mlir::ModuleOp module, unsigned threads = 0);
+
+} // end namespace dmc
@@ -7,11 +7,46 @@ namespace dmc {
 /// MLIR relies on static type IDs of classes, such as Dialect, Type,
 /// and Attribute, to manage objects. Since we are dynamically creating
 /// objects, we need to dynamically allocate TypeIDs.
+///
+/// Each allocated TypeID is the address of a slot owned by the allocator. The
+/// dynamic object that owns the TypeID can bind itself to the slot so that it
+/// can be recovered from the TypeID with a single load, e.g. from the TypeID
+/// stored inside an AbstractOperation.
 class TypeIDAllocator {
 public:
+  virtual ~TypeIDAllocator() = default;
   virtual mlir::TypeID allocateID() = 0;
+  /// Return a TypeID to the allocator so that it may be reused. The TypeID
+  /// must no longer be referenced by any MLIR object.
+  virtual void freeID(mlir::TypeID id) = 0;
 };
 
-TypeIDAllocator *getFixedTypeIDAllocator();
+/// Get the process-wide TypeID allocator. Slots are allocated in chunks that
+/// are never moved, so the allocator grows without bound. Freed TypeIDs are
+/// recycled. Allocating and freeing are lock-free.
+TypeIDAllocator *getTypeIDAllocator();
+
+namespace detail {
+/// The storage behind a dynamically allocated TypeID.
+struct TypeIDSlot {
+  void *object{};
+};
+
+inline TypeIDSlot *getTypeIDSlot(mlir::TypeID id) {
+  return const_cast<TypeIDSlot *>(
+      static_cast<const TypeIDSlot *>(id.getAsOpaquePointer()));
+}
+} // end namespace detail
+
+/// Bind an object to a TypeID allocated by a TypeIDAllocator.
+inline void bindTypeID(mlir::TypeID id, void *object) {
+  detail::getTypeIDSlot(id)->object = object;
+}
+
+/// Get the object bound to a TypeID allocated by a TypeIDAllocator. Returns
+/// null if no object has been bound.
+inline void *lookupTypeIDObject(mlir::TypeID id) {
+  return detail::getTypeIDSlot(id)->object;
+}
 
 } // end namespace dmc
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <mlir/IR/Attributes.h>
+#include <mlir/IR/Types.h>
+#include <llvm/ADT/Optional.h>
+
+#include <memory>
+
+namespace dmc {
+namespace py {
+
+namespace detail {
+class ConstraintNode;
+} // end namespace detail
+
+/// A Python constraint expression compiled to a native predicate tree. The
+/// supported subset covers `isinstance({self}, Cls)` for classes whose Python
+/// `isinstance` agrees with MLIR `isa`, `len({self})`, integer properties such
+/// as `{self}.width` and `{self}.rank`, argument-less query methods such as
+/// `{self}.isSignless()`, integer and boolean literals, comparisons, and the
+/// `and`, `or`, and `not` combinators.
+///
+/// Where the Python expression would raise, e.g. `{self}.width` of a tensor,
+/// the native predicate evaluates to false. `len` of a subject that it does
+/// not handle natively is deferred to the Python constraint instead.
+class NativeConstraint {
+public:
+  ~NativeConstraint();
+
+  /// Compile a constraint expression. Returns null if the expression is
+  /// outside the supported subset.
+  static std::unique_ptr<NativeConstraint> compile(llvm::StringRef expr);
+
+  /// Evaluate the predicate on a type or attribute. Returns None if the
+  /// result must be computed by the Python constraint.
+  llvm::Optional<bool> operator()(mlir::Type type) const;
+  llvm::Optional<bool> operator()(mlir::Attribute attr) const;
+
+  /// Whether evaluation may be deferred to the Python constraint, which must
+  /// then also be registered.
+  bool mayDefer() const { return defers; }
+
+private:
+  NativeConstraint(std::unique_ptr<detail::ConstraintNode> root,
+                   bool mayDefer);
+
+  std::unique_ptr<detail::ConstraintNode> root;
+  bool defers;
+};
+
+} // end namespace py
+} // end namespace dmc
@@ -5,16 +5,36 @@
 #include <mlir/IR/Types.h>
 #include <mlir/IR/Location.h>
 
+#include <vector>
+
 namespace dmc {
 namespace py {
 
+class NativeConstraint;
+
+/// Handle to a registered constraint. Expressions inside the natively
+/// supported subset are evaluated without entering Python; the rest are
+/// wrapped in a generated Python function.
+struct Constraint {
+  const NativeConstraint *native{};
+  std::string funcName{};
+
+  explicit operator bool() const { return native || !funcName.empty(); }
+};
+
+/// Register a constraint expression into a handle. Does nothing if the
+/// handle is already registered. Thread-safe.
 mlir::LogicalResult registerConstraint(mlir::Location loc, llvm::StringRef expr,
-                                       std::string &funcName);
+                                       Constraint &constraint);
 
-mlir::LogicalResult evalConstraint(const std::string &funcName,
+mlir::LogicalResult evalConstraint(const Constraint &constraint,
                                    mlir::Type type);
-mlir::LogicalResult evalConstraint(const std::string &funcName,
+mlir::LogicalResult evalConstraint(const Constraint &constraint,
                                    mlir::Attribute attr);
 
+/// Get the constraint expressions that could not be compiled natively and
+/// fall back to the Python interpreter.
+std::vector<std::string> getInterpretedConstraints();
+
 } // end namespace py
 } // end namespace dmc
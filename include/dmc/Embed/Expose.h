@@ -6,7 +6,9 @@
 namespace dmc {
 class DynamicDialect;
 namespace py {
+class SpecCache;
 void exposeDialectInternal(DynamicDialect *dialect,
-                           llvm::ArrayRef<llvm::StringRef> scope);
+                           llvm::ArrayRef<llvm::StringRef> scope,
+                           SpecCache &cache);
 } // end namespace py
 } // end namespace dmc
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mlir/IR/Attributes.h>
+#include <mlir/IR/OpDefinition.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dmc {
+class OpType;
+namespace py {
+
+namespace detail {
+class FoldNode;
+} // end namespace detail
+
+/// A declarative fold of a dynamic op, compiled to native expression trees.
+/// The fold is a list of alternatives, tried in order, e.g.
+///
+///   Op @add(lhs: i64, rhs: i64) -> (res: i64)
+///     config { fold = ["$lhs if $rhs == 0", "$lhs + $rhs"] }
+///
+/// `$name` refers to an operand or an attribute of the op. An expression that
+/// is an operand forwards it. Otherwise, it must evaluate to a constant,
+/// computed from constant operands, attributes, and literals with `+`, `-`,
+/// `*`, and comparisons. An alternative with an `if` condition only applies
+/// if the condition holds. Operands that are the same value compare equal.
+///
+/// An alternative does not fold if any of its operands is not constant where
+/// a constant is needed, or if the arithmetic is ill-typed.
+class NativeFold {
+public:
+  ~NativeFold();
+
+  /// Compile the fold alternatives of an op with the given signature and
+  /// attributes. Emits an error and returns null if an expression is invalid.
+  static std::unique_ptr<NativeFold>
+  compile(mlir::Location loc, llvm::ArrayRef<llvm::StringRef> exprs,
+          OpType opTy, mlir::DictionaryAttr opAttrs);
+
+  /// Fold an op with the given constant operands, which are null if not
+  /// constant. Fails if no alternative applies.
+  mlir::LogicalResult fold(mlir::Operation *op,
+                           llvm::ArrayRef<mlir::Attribute> operands,
+                           llvm::SmallVectorImpl<mlir::OpFoldResult> &results)
+      const;
+
+  /// If the fold is an unconditional attribute of an op without operands,
+  /// the op is a constant, and this returns the attribute name.
+  llvm::Optional<llvm::StringRef> getConstantAttrName() const;
+
+private:
+  NativeFold();
+
+  struct Alternative;
+  std::vector<Alternative> alternatives;
+  /// The attribute folded to by a constant op, if it is one.
+  std::string constantAttr;
+};
+
+/// Check that a Python fold function exists in the main scope. Emits an error
+/// otherwise.
+mlir::LogicalResult checkPyFold(mlir::Location loc, const std::string &fcnName);
+
+/// Call a Python fold function in the main scope, as `fcn(op, operands)`,
+/// where `operands` lists the constant operands or None. The function returns
+/// None if the op does not fold, or an attribute, value, or list of them, one
+/// per result. The op does not fold if the function raises or returns
+/// anything else. The GIL is acquired for the call.
+mlir::LogicalResult execFold(const std::string &fcnName, mlir::Operation *op,
+                             llvm::ArrayRef<mlir::Attribute> operands,
+                             llvm::SmallVectorImpl<mlir::OpFoldResult> &results);
+
+} // end namespace py
+} // end namespace dmc
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/StringSwitch.h>
+
+namespace dmc {
+namespace py {
+
+/// The backend used to run declarative assembly formats.
+enum class FormatBackend {
+  /// Generate Python parsers and printers and run them in the interpreter.
+  Python,
+  /// Compile formats to a native program. Formats that cannot be compiled
+  /// fall back to Python.
+  Native
+};
+
+/// Parse a format backend name. Returns None if the name is invalid.
+inline llvm::Optional<FormatBackend> symbolizeFormatBackend(
+    llvm::StringRef name) {
+  return llvm::StringSwitch<llvm::Optional<FormatBackend>>(name)
+      .Case("python", FormatBackend::Python)
+      .Case("native", FormatBackend::Native)
+      .Default(llvm::None);
+}
+
+/// Get the format backend for dialects that do not specify one. This is
+/// `DMC_FORMAT_BACKEND` if set to `python` or `native`, and Python otherwise.
+FormatBackend getDefaultFormatBackend();
+
+} // end namespace py
+} // end namespace dmc
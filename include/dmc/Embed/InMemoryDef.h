@@ -22,21 +22,28 @@ protected:
   PythonGenStream pgs{os};
 };
 
-class InMemoryDef : public InMemoryStream {
+/// A function definition that is not executed when destroyed. The sources
+/// of many definitions can be executed at once with `execDefs`.
+class DeferredDef : public InMemoryStream {
 public:
-  explicit InMemoryDef(llvm::StringRef fcnName, llvm::StringRef fcnSig);
-  ~InMemoryDef();
+  explicit DeferredDef(llvm::StringRef fcnName, llvm::StringRef fcnSig);
+
+  /// End the definition and get its source.
+  std::string finish();
 };
 
-class InMemoryClass : public InMemoryStream {
+/// Execute function definitions in the internal scope.
+void execDefs(const std::string &source);
+
+/// A class definition that is not executed when destroyed. The sources of
+/// many classes can be executed at once in the scope of a module.
+class DeferredClass : public InMemoryStream {
 public:
-  explicit InMemoryClass(
-      llvm::StringRef clsName, llvm::ArrayRef<llvm::StringRef> parentCls,
-      pybind11::module &m);
-  ~InMemoryClass();
+  explicit DeferredClass(llvm::StringRef clsName,
+                         llvm::ArrayRef<llvm::StringRef> parentCls);
 
-private:
-  pybind11::module &m;
+  /// End the definition and get its source.
+  std::string finish();
 };
 
 } // end namespace py
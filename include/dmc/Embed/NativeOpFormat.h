@@ -0,0 +1,149 @@
+#pragma once
+
+#include "FormatBackend.h"
+
+#include <mlir/IR/OpImplementation.h>
+
+#include <string>
+#include <vector>
+
+namespace dmc {
+class DynamicOperation;
+namespace py {
+
+/// A declarative op assembly format compiled to a flat program that runs
+/// directly against OpAsmParser and OpAsmPrinter. The program mirrors the
+/// Python generated by OpFormatGen, instruction for statement, so that both
+/// backends print identical text and accept the same input.
+class NativeOpFormat {
+public:
+  /// Parse and print an op with this format.
+  mlir::ParseResult parse(mlir::OpAsmParser &parser,
+                          mlir::OperationState &result) const;
+  void print(mlir::OpAsmPrinter &printer, mlir::Operation *op,
+             DynamicOperation *spec) const;
+
+  /// Parser instructions.
+  enum class ParseOp {
+    /// Parse a literal `str`.
+    Literal,
+    /// Parse an optional literal `str`. Jump to `jump` if not present.
+    OptionalLiteral,
+    /// Jump to `jump` if operand list `idx` is empty.
+    JumpIfNoOperands,
+    /// Parse attribute `str`, with buildable type `type` if set.
+    Attribute,
+    /// Parse symbol name attribute `str`.
+    Symbol,
+    /// Parse one operand, or a list of operands, into operand list `idx`.
+    Operand,
+    OperandList,
+    /// Parse one successor, or a list of successors, into successor list
+    /// `idx`.
+    Successor,
+    SuccessorList,
+    /// Parse region `idx` with optional arguments.
+    Region,
+    /// Parse the attribute dictionary.
+    AttrDict,
+    AttrDictWithKeyword,
+    /// Parse one type, or a list of types, into type list `idx`.
+    Type,
+    TypeList,
+    /// Parse a function type into type lists `idx` and `aux`.
+    FunctionalType,
+  };
+
+  struct ParseInstr {
+    ParseOp opc;
+    unsigned idx{}, aux{}, jump{};
+    std::string str{};
+    mlir::Type type{};
+  };
+
+  /// Where the types of a type directive come from.
+  enum class ValueKind { Operand, Result, AllOperands, AllResults };
+
+  struct ValueRef {
+    ValueKind kind;
+    unsigned idx{};
+  };
+
+  /// Printer instructions.
+  enum class PrintOp {
+    /// Print a single space.
+    Space,
+    /// Print literal `str`.
+    Literal,
+    /// Print the op name.
+    OpName,
+    /// Print the attribute dictionary, eliding `elided`. The names are owned
+    /// by the context.
+    AttrDict,
+    AttrDictWithKeyword,
+    /// Print attribute `str`, optionally without its type.
+    Attribute,
+    AttributeWithoutType,
+    /// Print the symbol name in attribute `str`.
+    Symbol,
+    /// Print the values in `values[0]`.
+    Operands,
+    /// Print successor group `idx`, or all successors.
+    Successors,
+    AllSuccessors,
+    /// Print region `idx` with its entry block arguments.
+    Region,
+    /// Print the types of `values[0]`.
+    Types,
+    /// Print a function type of `values[0]` to `values[1]`.
+    FunctionalType,
+    /// Jump to `jump` if operand group `idx` is empty.
+    JumpIfNoOperands,
+    /// Jump to `jump` if attribute `str` is not present.
+    JumpIfNoAttr,
+  };
+
+  struct PrintInstr {
+    PrintOp opc;
+    unsigned idx{}, jump{};
+    std::string str{};
+    std::vector<ValueRef> values{};
+    std::vector<llvm::StringRef> elided{};
+  };
+
+  /// How to resolve the types of an operand or result after parsing.
+  struct TypeResolver {
+    enum { List, Builder } kind;
+    /// The type list to use, which is the value's own list if no other
+    /// variable resolves it.
+    unsigned list{};
+    /// The built type.
+    mlir::Type type{};
+  };
+
+  /// Parser program and the resolution metadata. Type list indices are laid
+  /// out as operands, then results, then the `operands` and `results`
+  /// directive lists. Operand and successor lists are followed by the list of
+  /// the `operands` and `successors` directives.
+  std::vector<ParseInstr> parseProgram;
+  unsigned numOperands{}, numResults{}, numSuccessors{};
+  std::vector<bool> variadicOperands, variadicSuccessors;
+  std::vector<TypeResolver> operandTypes, resultTypes;
+  bool allOperands{}, allOperandTypes{}, allResultTypes{};
+  bool allSuccessors{}, sizedOperandSegments{};
+
+  /// Printer program.
+  std::vector<PrintInstr> printProgram;
+
+  inline unsigned getAllOperandsList() const { return numOperands; }
+  inline unsigned getAllOperandTypesList() const {
+    return numOperands + numResults;
+  }
+  inline unsigned getAllResultTypesList() const {
+    return numOperands + numResults + 1;
+  }
+  inline unsigned getAllSuccessorsList() const { return numSuccessors; }
+};
+
+} // end namespace py
+} // end namespace dmc
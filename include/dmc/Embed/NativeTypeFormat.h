@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mlir/IR/DialectImplementation.h>
+
+#include <string>
+#include <vector>
+
+namespace dmc {
+namespace py {
+
+/// A declarative type or attribute format compiled to a flat program that
+/// runs directly against DialectAsmParser and DialectAsmPrinter. The program
+/// mirrors the Python generated by TypeFormatGen.
+class NativeTypeFormat {
+public:
+  explicit NativeTypeFormat(llvm::StringRef name, unsigned numParams)
+      : name{name.str()}, numParams{numParams} {}
+
+  /// Parse the parameters of a type or attribute. The name has already been
+  /// parsed by the dialect.
+  mlir::ParseResult parse(mlir::DialectAsmParser &parser,
+                          std::vector<mlir::Attribute> &params) const;
+  /// Print a type or attribute with its parameters.
+  void print(mlir::DialectAsmPrinter &printer,
+             llvm::ArrayRef<mlir::Attribute> params) const;
+
+  /// Format instructions.
+  enum class Op {
+    /// Parse or print literal `str`.
+    Literal,
+    /// Parse or print parameter `idx` as an attribute.
+    Parameter,
+    /// Parse or print parameter `idx` as a dimension list.
+    Dims,
+  };
+
+  struct Instr {
+    Op opc;
+    unsigned idx{};
+    std::string str{};
+  };
+
+  /// Append an instruction.
+  inline void push_back(Instr instr) { program.push_back(std::move(instr)); }
+
+private:
+  /// The type or attribute name.
+  std::string name;
+  /// The number of parameters.
+  unsigned numParams;
+  /// The format program.
+  std::vector<Instr> program;
+};
+
+} // end namespace py
+} // end namespace dmc
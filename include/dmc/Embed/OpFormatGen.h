@@ -1,8 +1,14 @@
 #pragma once
 
+#include "NativeOpFormat.h"
 #include "PythonGen.h"
 #include "dmc/Spec/SpecOps.h"
 
 mlir::LogicalResult generateOpFormat(dmc::OperationOp op,
                                      dmc::py::PythonGenStream &parserOs,
                                      dmc::py::PythonGenStream &printerOs);
+
+/// Compile the op format to a native parser and printer. Returns null if the
+/// format cannot be handled natively, in which case the Python backend is used.
+std::unique_ptr<dmc::py::NativeOpFormat>
+compileOpFormat(dmc::OperationOp op);
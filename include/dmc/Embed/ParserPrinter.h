@@ -1,8 +1,15 @@
 #pragma once
 
+#include <llvm/ADT/Optional.h>
+
+#include <memory>
 #include <string>
 #include <vector>
 
+namespace pybind11 {
+class function;
+} // end namespace pybind11
+
 namespace mlir {
 class OpAsmParser;
 class OpAsmPrinter;
@@ -16,14 +23,38 @@ class Attribute;
 namespace dmc {
 class DynamicOperation;
 namespace py {
-bool execParser(const std::string &name, mlir::OpAsmParser &parser,
+
+/// A strong reference to a generated parser or printer function. The function
+/// is resolved once, when the format is set, so that parsing and printing do
+/// not look it up by name on every call.
+class PythonFunction {
+public:
+  PythonFunction();
+  ~PythonFunction();
+  PythonFunction(PythonFunction &&other);
+  PythonFunction &operator=(PythonFunction &&other);
+
+  /// Resolve a function defined in the internal scope. Returns None if there
+  /// is no such function.
+  static llvm::Optional<PythonFunction> lookup(const std::string &name);
+
+  explicit operator bool() const { return static_cast<bool>(fcn); }
+  pybind11::function &get() const { return *fcn; }
+
+private:
+  std::unique_ptr<pybind11::function> fcn;
+};
+
+/// Call a generated parser or printer. The GIL is acquired for the call, so
+/// these may be called from any thread.
+bool execParser(const PythonFunction &fcn, mlir::OpAsmParser &parser,
                 mlir::OperationState &result);
-void execPrinter(const std::string &name, mlir::OpAsmPrinter &printer,
+void execPrinter(const PythonFunction &fcn, mlir::OpAsmPrinter &printer,
                  mlir::Operation *op, DynamicOperation *spec);
-bool execParser(const std::string &name, mlir::DialectAsmParser &parser,
+bool execParser(const PythonFunction &fcn, mlir::DialectAsmParser &parser,
                 std::vector<mlir::Attribute> &result);
 template <typename DynamicT>
-void execPrinter(const std::string &name, mlir::DialectAsmPrinter &printer,
+void execPrinter(const PythonFunction &fcn, mlir::DialectAsmPrinter &printer,
                  DynamicT type);
 } // end namespace py
 } // end namespace dmc
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <mlir/IR/PatternMatch.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dmc {
+namespace py {
+
+namespace detail {
+struct SourceNode;
+struct ResultValue;
+} // end namespace detail
+
+/// A declarative rewrite pattern, compiled to a native matcher and rewriter.
+/// The source is an op DAG rooted at the matched op, e.g.
+///
+///   (lua.binary (lua.number {value = $v : #dmc.I<64>}) $rhs {op = "+"})
+///
+/// An operand is `_`, which matches anything, a nested DAG, which matches the
+/// defining op of the operand, or a capture `$name`, optionally constrained by
+/// a type or type constraint. An attribute is either captured, optionally
+/// with an attribute constraint, or must satisfy the given constraint, which
+/// is equality for attributes that are not constraints. Captures used more
+/// than once must match the same value or attribute.
+///
+/// The rewrite is a capture, which replaces the matched op, or an op DAG
+/// whose root replaces the matched op, e.g.
+///
+///   (std.constant {value = #luac.type_bool} -> i32)
+///
+/// Operands and attributes of new ops are captures, nested DAGs, or
+/// attribute literals. Result types are given after `->`, either as types or
+/// as `$name`, the type of a capture. Otherwise, they are the result types of
+/// the op spec, if these are concrete, or the types of the replaced op.
+class NativePattern {
+public:
+  ~NativePattern();
+
+  /// Compile a pattern. The ops of the pattern must be registered. Emits an
+  /// error and returns null if the pattern is invalid.
+  static std::unique_ptr<NativePattern>
+  compile(mlir::Location loc, llvm::StringRef name, llvm::StringRef source,
+          llvm::StringRef rewrite, unsigned benefit);
+
+  /// Getters.
+  inline llvm::StringRef getName() const { return name; }
+  llvm::StringRef getRootName() const;
+  inline unsigned getBenefit() const { return benefit; }
+
+  /// Match an op with the root name and rewrite it.
+  mlir::LogicalResult matchAndRewrite(mlir::Operation *op,
+                                      mlir::PatternRewriter &rewriter) const;
+
+  /// Add a RewritePattern that applies this pattern to a list. The pattern
+  /// must outlive the list.
+  void addTo(mlir::OwningRewritePatternList &patterns,
+             mlir::MLIRContext *ctx) const;
+
+private:
+  NativePattern();
+
+  std::string name;
+  unsigned benefit;
+  std::unique_ptr<detail::SourceNode> source;
+  std::unique_ptr<detail::ResultValue> rewrite;
+  /// The number of value and attribute captures.
+  unsigned numValues{}, numAttrs{};
+  /// The names of the ops created by the rewrite.
+  std::vector<std::string> generatedOps;
+};
+
+} // end namespace py
+} // end namespace dmc
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+
+#include <memory>
+
+namespace pybind11 {
+class module;
+}
+
+namespace dmc {
+namespace py {
+
+/// The Python code generated for a dialect spec, cached on disk across
+/// processes. The code is kept in named sections, e.g. the op formats, which
+/// are stored compiled and marshalled. A warm start skips both generating
+/// and compiling them.
+///
+/// Entries are keyed by the dialect name, the hash of its spec, and the hash
+/// of the DMC sources that generate the code, taken at build time. They are
+/// stored in `DMC_SPEC_CACHE_DIR`, or in `dmc` under the user cache directory.
+/// Set `DMC_SPEC_CACHE=off` to disable the cache.
+class SpecCache {
+public:
+  /// Open the entry of a dialect spec. The entry is cold if it does not exist,
+  /// cannot be read, or the cache is disabled.
+  SpecCache(llvm::StringRef dialectName, uint64_t specHash);
+  ~SpecCache();
+
+  /// Whether the entry was loaded. Code is only generated for cold entries.
+  bool isWarm();
+
+  /// Execute a loaded section of function definitions in the internal scope.
+  /// Does nothing if the section is empty.
+  void execDefs(llvm::StringRef section);
+  /// Execute a loaded section in the scope of a module.
+  void execIn(llvm::StringRef section, pybind11::module &m);
+
+  /// Append generated source to a section of a cold entry.
+  void addSource(llvm::StringRef section, llvm::StringRef source);
+  /// Compile the sections of a cold entry and write it to disk. Errors are
+  /// ignored, since the cache is only an optimization.
+  void save();
+
+private:
+  class Impl;
+  std::unique_ptr<Impl> impl;
+};
+
+} // end namespace py
+} // end namespace dmc
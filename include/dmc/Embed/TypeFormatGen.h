@@ -1,5 +1,6 @@
 #pragma once
 
+#include "NativeTypeFormat.h"
 #include "PythonGen.h"
 #include "dmc/Spec/ParameterList.h"
 #include "dmc/Spec/FormatOp.h"
@@ -8,3 +9,8 @@ template <typename OpT, typename DynamicT>
 mlir::LogicalResult generateTypeFormat(OpT op, DynamicT *impl,
                                        dmc::py::PythonGenStream &parserOs,
                                        dmc::py::PythonGenStream &printerOs);
+
+/// Compile the type or attribute format to a native parser and printer.
+template <typename OpT, typename DynamicT>
+std::unique_ptr<dmc::py::NativeTypeFormat> compileTypeFormat(OpT op,
+                                                             DynamicT *impl);
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <mlir/IR/Module.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace dmc {
+
+/// Forward declarations.
+class DynamicContext;
+
+/// A compact binary format for modules containing dynamic operations, types,
+/// and attributes. Reading and writing never call the custom formats of
+/// dynamic objects: dynamic types and attributes are stored as their
+/// dialect, name, and parameters, and ops are stored in generic form.
+///
+/// The file consists of
+///
+///   magic        "DMCB" version
+///   strings      count, then each string as length and bytes
+///   dialects     count, then each dynamic dialect as a string index and the
+///                hash of the spec that defined it
+///   entries      count, then each type, attribute, or location as a kind
+///                byte, the payload size, and a payload that refers to
+///                earlier entries
+///   body         the module op
+///
+/// Integers are unsigned LEB128 unless noted. Each op is its name, location,
+/// operands, result types, attribute dictionary, successors, and regions.
+/// Successors are indices of blocks in the region that contains the op.
+/// Operands refer to values numbered in definition order: the results of an
+/// op precede its regions, and the arguments of a block precede its ops. A
+/// reference to a value that is not yet defined is followed by its type.
+///
+/// The regions of top-level ops that are isolated from above, such as
+/// functions, are written as a chunk prefixed with its size, and the values
+/// in a chunk are numbered from zero. A reader can skip a chunk and read it
+/// later, and entries are only read when they are first used.
+///
+/// Builtin leaf types and attributes, and those of other dialects, are
+/// stored as text.
+namespace bytecode {
+constexpr char Magic[] = {'D', 'M', 'C', 'B'};
+constexpr unsigned Version = 2;
+} // end namespace bytecode
+
+/// Write a module as bytecode.
+mlir::LogicalResult writeBytecode(mlir::ModuleOp module, llvm::raw_ostream &os);
+mlir::LogicalResult writeBytecodeFile(mlir::ModuleOp module,
+                                      llvm::StringRef filename);
+
+/// Read a module from bytecode. The dynamic dialects that the module uses
+/// must be registered from the same specs that they were written with. On
+/// failure, errors are emitted to the context and null is returned.
+mlir::OwningModuleRef parseBytecode(llvm::StringRef data, DynamicContext *ctx);
+mlir::OwningModuleRef parseBytecodeFile(llvm::StringRef filename,
+                                        DynamicContext *ctx);
+
+/// A module read from a bytecode file whose chunks, such as function bodies,
+/// are read on first access. The file is memory-mapped and kept open for the
+/// lifetime of the module, which is owned by this object.
+///
+/// Until they are materialized, top-level ops have empty regions, so they
+/// look like declarations. Print and write the module through this object,
+/// which materializes it first, rather than through `getModule()`. The module
+/// is not verified as a whole until every op is materialized.
+class LazyModule {
+public:
+  ~LazyModule();
+
+  /// Load a module, reading only the tables that it needs and the ops at its
+  /// top level. On failure, errors are emitted to the context and null is
+  /// returned.
+  static std::unique_ptr<LazyModule> load(llvm::StringRef filename,
+                                          DynamicContext *ctx);
+
+  /// Get the module, which may have unmaterialized ops.
+  mlir::ModuleOp getModule();
+
+  /// Lookup a top-level symbol and materialize it. Returns null if the symbol
+  /// does not exist or it fails to read.
+  mlir::Operation *lookup(llvm::StringRef name);
+
+  /// Read and verify the regions of a top-level op if they were skipped.
+  mlir::LogicalResult materialize(mlir::Operation *op);
+  /// Materialize every op and verify the module.
+  mlir::LogicalResult materializeAll();
+  /// Get the number of ops that are not yet materialized.
+  unsigned getNumUnmaterialized();
+
+  /// Materialize every op, then print the module.
+  mlir::LogicalResult print(llvm::raw_ostream &os,
+                            mlir::OpPrintingFlags flags = llvm::None);
+  /// Materialize every op, then write the module as bytecode.
+  mlir::LogicalResult writeBytecode(llvm::raw_ostream &os);
+  mlir::LogicalResult writeBytecodeFile(llvm::StringRef filename);
+
+private:
+  class Impl;
+  explicit LazyModule(std::unique_ptr<Impl> impl);
+
+  std::unique_ptr<Impl> impl;
+};
+
+} // end namespace dmc
@@ -5,6 +5,10 @@
 #include <mlir/IR/Attributes.h>
 #include <llvm/ADT/ArrayRef.h>
 
+namespace mlir {
+class DialectAsmPrinter;
+} // end namespace mlir
+
 namespace dmc {
 class DynamicType;
 class DynamicAttribute;
@@ -34,5 +38,10 @@ private:
   std::vector<mlir::Attribute> &result;
 };
 
+/// Print an array of integers as a dimension list, with -1 as `?`. Other
+/// attributes are printed as is.
+void printDimensionListOrRaw(mlir::DialectAsmPrinter &printer,
+                             mlir::Attribute attr);
+
 } // end namespace py
 } // end namespace dmc
@@ -2,6 +2,7 @@
 
 #include "Polymorphic.h"
 
+#include <llvm/Support/ErrorHandling.h>
 #include <pybind11/pybind11.h>
 
 namespace mlir {
@@ -10,5 +11,25 @@ namespace py {
 void getModule(pybind11::module &m);
 void setMLIRContext(MLIRContext *ctx);
 MLIRContext *getMLIRContext();
+void pushMLIRContext(MLIRContext *ctx);
+bool popMLIRContext(MLIRContext *ctx);
+
+/// Make a context current on this thread for the lifetime of this object.
+/// Threads that call into Python on behalf of a context enter it first.
+class ContextScope {
+public:
+  explicit ContextScope(MLIRContext *ctx) : ctx{ctx} { pushMLIRContext(ctx); }
+  ~ContextScope() {
+    if (!popMLIRContext(ctx))
+      llvm::report_fatal_error("ContextScope exited out of order: an inner "
+                               "context was not exited");
+  }
+
+  ContextScope(const ContextScope &) = delete;
+  ContextScope &operator=(const ContextScope &) = delete;
+
+private:
+  MLIRContext *ctx;
+};
 } // end namespace py
 } // end namespace mlir
@@ -12,6 +12,9 @@ namespace SpecAttrs {
 bool is(mlir::Attribute base);
 mlir::LogicalResult delegateVerify(mlir::Attribute base,
                                    mlir::Attribute attr);
+/// Whether verifying against an attribute constraint may enter Python. See
+/// `SpecTypes::isInterpreted`.
+bool isInterpreted(mlir::Attribute base);
 } // end namespace SpecAttrs
 
 template <typename ConcreteType, unsigned SpecKind,
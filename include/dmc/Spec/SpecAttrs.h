@@ -157,6 +157,7 @@ public:
   static llvm::StringLiteral getAttrName() { return "ElementsOf"; }
 
   static ElementsOfAttr get(mlir::Type elTy);
+  mlir::Type getElementType();
   mlir::LogicalResult verify(Attribute attr);
 
   static Attribute parse(mlir::DialectAsmParser &parser);
@@ -209,6 +210,7 @@ public:
   /// An array of a constant attribute makes no sense, so assert that the
   /// attribute is a SpecAttr constraint.
   static ArrayOfAttr getChecked(mlir::Location loc, Attribute constraint);
+  Attribute getConstraint();
   static mlir::LogicalResult verifyConstructionInvariants(mlir::Location,
                                                           Attribute constraint);
   mlir::LogicalResult verify(Attribute attr);
@@ -243,6 +245,7 @@ public:
   static llvm::StringLiteral getAttrName() { return "Constant"; }
 
   static ConstantAttr get(Attribute attr);
+  Attribute getValue();
   mlir::LogicalResult verify(Attribute attr);
 
   static Attribute parse(mlir::DialectAsmParser &parser);
@@ -257,6 +260,7 @@ public:
 
   static AnyOfAttr getChecked(mlir::Location loc,
                                  llvm::ArrayRef<Attribute> attrs);
+  llvm::ArrayRef<Attribute> getAttrs();
   static mlir::LogicalResult verifyConstructionInvariants(
       mlir::Location loc, llvm::ArrayRef<Attribute> attrs);
   mlir::LogicalResult verify(Attribute attr);
@@ -273,6 +277,7 @@ public:
 
   static AllOfAttr getChecked(mlir::Location loc,
                                  llvm::ArrayRef<Attribute> attrs);
+  llvm::ArrayRef<Attribute> getAttrs();
   static mlir::LogicalResult verifyConstructionInvariants(
       mlir::Location loc, llvm::ArrayRef<Attribute> attrs);
   mlir::LogicalResult verify(Attribute attr);
@@ -288,6 +293,8 @@ public:
   static llvm::StringLiteral getAttrName() { return "OfType"; }
 
   static OfTypeAttr get(mlir::Type ty);
+  /// Get the type constraint. Not to be confused with the attribute type.
+  mlir::Type getConstraintType();
   mlir::LogicalResult verify(Attribute attr);
 
   static Attribute parse(mlir::DialectAsmParser &parser);
@@ -303,6 +310,7 @@ public:
   static llvm::StringLiteral getAttrName() { return "Optional"; }
 
   static OptionalAttr get(Attribute baseAttr);
+  Attribute getBaseAttr();
   mlir::LogicalResult verify(Attribute attr);
 
   static Attribute parse(mlir::DialectAsmParser &parser);
@@ -323,7 +331,8 @@ public:
   static Attribute parse(mlir::DialectAsmParser &parser);
   void print(mlir::DialectAsmPrinter &printer);
 
-  /// Get the default value.
+  /// Get the base constraint and the default value.
+  Attribute getBaseAttr();
   Attribute getDefaultValue();
 };
 
@@ -350,6 +359,8 @@ public:
 
   static PyAttr getChecked(mlir::Location loc, llvm::StringRef expr);
   mlir::LogicalResult verify(Attribute attr);
+  /// Whether the expression is evaluated without entering Python.
+  bool isNative();
 
   static Attribute parse(mlir::DialectAsmParser &parser);
   void print(mlir::DialectAsmPrinter &printer);
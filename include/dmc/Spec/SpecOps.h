@@ -20,6 +20,7 @@ class OperationOp;
 class TypeOp;
 class AttributeOp;
 class AliasOp;
+class PatternOp;
 class DynamicTrait;
 
 /// Top-level Op in the SpecDialect which defines a dialect:
@@ -38,7 +39,7 @@ class DialectOp
           mlir::SymbolOpInterface::Trait,
           dmc::OpTrait::HasOnlyChildren<
               DialectTerminatorOp, OperationOp, TypeOp, AttributeOp,
-              AliasOp>::Impl> {
+              AliasOp, PatternOp>::Impl> {
 public:
   using Op::Op;
 
@@ -55,6 +56,8 @@ public:
   /// Getters.
   bool allowsUnknownOps();
   bool allowsUnknownTypes();
+  /// Get the requested declarative format backend, if one is specified.
+  llvm::Optional<llvm::StringRef> getFormatBackend();
 
   mlir::Region &getBodyRegion();
   mlir::Block *getBody();
@@ -79,6 +82,9 @@ private:
   static inline llvm::StringRef getAllowUnknownTypesAttrName() {
     return "allow_unknown_types";
   }
+  static inline llvm::StringRef getFormatBackendAttrName() {
+    return "format_backend";
+  }
 };
 
 /// Special terminator Op for DialectOp.
@@ -132,6 +138,10 @@ public:
   OpRegion getOpRegions();
   OpSuccessor getOpSuccessors();
   OpTraitsAttr getOpTraits();
+  /// Get the native fold alternatives, in order. Empty if none.
+  llvm::SmallVector<llvm::StringRef, 2> getFoldExprs();
+  /// Get the name of the Python fold function, if specified.
+  llvm::Optional<llvm::StringRef> getPyFold();
 
   /// Allow querying of traits by temporarily instantiating one.
   std::unique_ptr<DynamicTrait> getTrait(llvm::StringRef name);
@@ -168,6 +178,8 @@ private:
   static inline llvm::StringRef getOpSuccsAttrName() {
     return "successors";
   }
+  static inline llvm::StringRef getFoldAttrName() { return "fold"; }
+  static inline llvm::StringRef getPyFoldAttrName() { return "py_fold"; }
 };
 
 /// The TypeOp allows dialects to define custom types by composing Attributes.
@@ -274,4 +286,42 @@ private:
   static llvm::StringRef getTypeAttrName() { return "type"; }
 };
 
+/// A declarative rewrite pattern, compiled to a native canonicalization
+/// pattern. The source and result are op DAGs:
+///
+/// dmc.Pattern @get_bool "(luac.get_bool_val (luac.wrap_bool $b))" -> "$b"
+///     { benefit = 1 }
+///
+class PatternOp
+    : public mlir::Op<PatternOp,
+                      mlir::OpTrait::ZeroOperands, mlir::OpTrait::ZeroResult,
+                      mlir::OpTrait::IsIsolatedFromAbove,
+                      mlir::OpTrait::HasParent<DialectOp>::Impl,
+                      mlir::SymbolOpInterface::Trait> {
+public:
+  using Op::Op;
+
+  static llvm::StringRef getOperationName() { return "dmc.Pattern"; }
+
+  static void build(mlir::OpBuilder &builder, mlir::OperationState &result,
+                    llvm::StringRef name, llvm::StringRef source,
+                    llvm::StringRef rewrite, unsigned benefit);
+
+  /// Operation hooks.
+  static mlir::ParseResult parse(mlir::OpAsmParser &parser,
+                                 mlir::OperationState &result);
+  void print(mlir::OpAsmPrinter &printer);
+  mlir::LogicalResult verify();
+
+  /// Getters.
+  llvm::StringRef getSource();
+  llvm::StringRef getRewrite();
+  unsigned getBenefit();
+
+private:
+  static llvm::StringRef getSourceAttrName() { return "source"; }
+  static llvm::StringRef getRewriteAttrName() { return "rewrite"; }
+  static llvm::StringRef getBenefitAttrName() { return "benefit"; }
+};
+
 } // end namespace dmc
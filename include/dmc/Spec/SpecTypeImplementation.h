@@ -12,6 +12,9 @@ namespace dmc {
 namespace SpecTypes {
 bool is(mlir::Type base);
 mlir::LogicalResult delegateVerify(mlir::Type base, mlir::Type ty);
+/// Whether verifying against a type constraint may enter Python, i.e. it
+/// contains a Python constraint that could not be compiled natively.
+bool isInterpreted(mlir::Type base);
 } // end namespace SpecTypes
 
 /// A SpecType is used to define a TypeConstraint. Each SpecType
@@ -54,6 +54,8 @@ public:
   static llvm::StringLiteral getTypeName() { return "AnyOf"; }
 
   static AnyOfType getChecked(mlir::Location loc, llvm::ArrayRef<Type> tys);
+  /// Get the type constraints in the list.
+  llvm::ArrayRef<Type> getTypes();
 
   /// Type list cannot be empty.
   static mlir::LogicalResult verifyConstructionInvariants(
@@ -73,6 +75,7 @@ public:
   static llvm::StringLiteral getTypeName() { return "AllOf"; }
 
   static AllOfType getChecked(mlir::Location loc, llvm::ArrayRef<Type> tys);
+  llvm::ArrayRef<Type> getTypes();
   static mlir::LogicalResult verifyConstructionInvariants(
       mlir::Location loc, llvm::ArrayRef<Type> tys);
   mlir::LogicalResult verify(Type ty);
@@ -268,6 +271,7 @@ public:
   static llvm::StringLiteral getTypeName() { return "Complex"; }
 
   static ComplexType getChecked(mlir::Location loc, Type elTy);
+  Type getElementType();
   mlir::LogicalResult verify(Type ty);
 
   static Type parse(mlir::DialectAsmParser &parser);
@@ -310,6 +314,7 @@ public:
   static llvm::StringLiteral getTypeName() { return "Variadic"; }
 
   static VariadicType get(Type ty);
+  Type getBaseType();
   mlir::LogicalResult verify(Type ty);
 
   static Type parse(mlir::DialectAsmParser &parser);
@@ -359,6 +364,8 @@ public:
 
   static PyType getChecked(mlir::Location loc, llvm::StringRef expr);
   mlir::LogicalResult verify(Type ty);
+  /// Whether the expression is evaluated without entering Python.
+  bool isNative();
 
   static Type parse(mlir::DialectAsmParser &parser);
   void print(mlir::DialectAsmPrinter &printer);
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <mlir/IR/Attributes.h>
+#include <mlir/IR/Location.h>
+#include <mlir/IR/Types.h>
+#include <llvm/ADT/DenseMap.h>
+
+namespace dmc {
+
+/// Forward declarations.
+class DynamicContext;
+
+/// Resolves the placeholders that a spec holds for symbols of dynamic
+/// dialects. When the spec is parsed, the dynamic dialects do not exist yet,
+/// so a reference like `!lua.value` is parsed as an opaque type. Once the
+/// types, attributes, and aliases of all dialects are registered, the
+/// placeholders are replaced with the symbols they name.
+///
+/// Types and attributes are walked structurally and a container is rebuilt
+/// only if one of its children was replaced. A bare symbol name is looked up
+/// directly in its dialect. Parameterized references, symbols with a custom
+/// format, and types and attributes that cannot be walked are resolved by
+/// printing and reparsing them.
+///
+/// Results are memoized, so a resolver should be reused across a spec op.
+/// A resolver is not thread-safe, but separate resolvers may be used
+/// concurrently.
+class SymbolResolver {
+public:
+  /// Errors are reported at the provided location.
+  explicit SymbolResolver(mlir::Location loc);
+
+  /// Resolve a type or attribute. Returns null on failure.
+  mlir::Type resolve(mlir::Type type);
+  mlir::Attribute resolve(mlir::Attribute attr);
+
+  /// Get the number of types and attributes that were resolved by reparsing.
+  unsigned getNumReparsed() const { return numReparsed; }
+
+private:
+  mlir::Type resolveType(mlir::Type type);
+  mlir::Attribute resolveAttr(mlir::Attribute attr);
+  mlir::Type resolveOpaqueType(mlir::Type type);
+  mlir::Attribute resolveOpaqueAttr(mlir::Attribute attr);
+  mlir::Type reparse(mlir::Type type);
+  mlir::Attribute reparse(mlir::Attribute attr);
+
+  mlir::Location loc;
+  DynamicContext *ctx;
+
+  llvm::DenseMap<mlir::Type, mlir::Type> types;
+  llvm::DenseMap<mlir::Attribute, mlir::Attribute> attrs;
+  unsigned numReparsed{};
+};
+
+namespace impl {
+/// Resolve a type or attribute by printing and reparsing it.
+mlir::Type reparseType(mlir::Type type);
+mlir::Attribute reparseAttr(mlir::Attribute attr);
+} // end namespace impl
+
+} // end namespace dmc
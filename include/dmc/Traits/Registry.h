@@ -44,7 +44,7 @@ public:
   explicit TraitRegistry(mlir::MLIRContext *ctx);
   static llvm::StringRef getDialectNamespace() { return "trait";  }
 
-  /// Register a trait constructor.
+  /// Register a trait constructor. The trait is assigned a trait ID.
   void registerTrait(llvm::StringRef name, TraitConstructor &&getter);
   /// Lookup a trait constructor.
   TraitConstructor lookupTrait(llvm::StringRef name);
@@ -87,6 +87,8 @@ public:
   inline mlir::LogicalResult verifyOp(mlir::Operation *op) const override {
     return impl::verifyTypeConstraints(op, opTy);
   }
+  /// Whether any operand or result constraint is interpreted.
+  bool verifiesInPython() const override;
 
   inline auto getOpType() { return opTy; }
 
@@ -107,6 +109,8 @@ public:
   inline mlir::LogicalResult verifyOp(mlir::Operation *op) const override {
     return impl::verifyAttrConstraints(op, opAttrs);
   }
+  /// Whether any attribute constraint is interpreted.
+  bool verifiesInPython() const override;
 
   inline auto getOpAttrs() { return opAttrs; }
 
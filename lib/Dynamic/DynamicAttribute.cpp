@@ -54,8 +54,11 @@ DynamicAttributeImpl::DynamicAttributeImpl(
 Attribute DynamicAttributeImpl::parseAttribute(Location loc,
                                                DialectAsmParser &parser) {
   std::vector<Attribute> params;
-  if (parserFcn) {
-    if (!py::execParser(*parserFcn, parser, params))
+  if (useNative) {
+    if (failed(nativeFormat->parse(parser, params)))
+      return {};
+  } else if (parserFcn) {
+    if (!py::execParser(parserFcn, parser, params))
       return {};
   } else if (!parser.parseOptionalLess()) {
     do {
@@ -75,8 +78,12 @@ void DynamicAttributeImpl::printAttribute(Attribute attr,
   auto dynAttr = attr.cast<DynamicAttribute>();
 
   /// Try a formated printer.
+  if (useNative) {
+    nativeFormat->print(printer, dynAttr.getParams());
+    return;
+  }
   if (printerFcn) {
-    py::execPrinter(*printerFcn, printer, dynAttr);
+    py::execPrinter(printerFcn, printer, dynAttr);
     return;
   }
 
@@ -92,10 +99,23 @@ void DynamicAttributeImpl::printAttribute(Attribute attr,
   }
 }
 
-void DynamicAttributeImpl::setFormat(std::string parserName,
-                                     std::string printerName) {
-  parserFcn = std::move(parserName);
-  printerFcn = std::move(printerName);
+LogicalResult DynamicAttributeImpl::setFormat(Location loc,
+                                              std::string parserName,
+                                              std::string printerName) {
+  auto parser = py::PythonFunction::lookup(parserName);
+  auto printer = py::PythonFunction::lookup(printerName);
+  if (!parser || !printer)
+    return emitError(loc) << "missing generated parser or printer for "
+        << "attribute '" << getName() << "'";
+  parserFcn = std::move(*parser);
+  printerFcn = std::move(*printer);
+  return success();
+}
+
+void DynamicAttributeImpl::setNativeFormat(
+    std::unique_ptr<py::NativeTypeFormat> format) {
+  nativeFormat = std::move(format);
+  useNative = hasNativeFormat();
 }
 
 /// Since dynamic attributes are not registered with a Dialect or the MLIR
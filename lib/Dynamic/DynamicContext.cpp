@@ -7,6 +7,8 @@
 #include <llvm/ADT/StringMap.h>
 #include <mlir/IR/Operation.h>
 
+#include <mutex>
+
 using namespace mlir;
 
 namespace dmc {
@@ -14,6 +16,8 @@ namespace dmc {
 class DynamicContext::Impl {
   friend class DynamicContext;
 
+  /// The dynamic dialects by namespace.
+  llvm::StringMap<DynamicDialect *> dialects;
   /// A registry of symbols and their associated dynamic dialect.
   DenseMap<const void *, DynamicDialect *> dialectSymbols;
 
@@ -28,13 +32,20 @@ class DynamicContext::Impl {
                                                      dialect);
     return success(inserted);
   }
+
+  /// The pattern lists that the dynamic patterns were added to, with the
+  /// index and address of the first added pattern. A later list allocated at
+  /// the same address will not have that pattern there.
+  DenseMap<OwningRewritePatternList *, std::pair<std::size_t, RewritePattern *>>
+      populatedLists;
+  std::mutex populatedListsMutex;
 };
 
 DynamicContext::~DynamicContext() = default;
 
 DynamicContext::DynamicContext(MLIRContext *ctx)
     : Dialect{getDialectNamespace(), ctx, TypeID::get<DynamicContext>()},
-      typeIdAlloc{getFixedTypeIDAllocator()},
+      typeIdAlloc{getTypeIDAllocator()},
       impl{std::make_unique<Impl>()} {
   // Automatically initialize the interpreter
   py::init(ctx);
@@ -49,9 +60,14 @@ DynamicDialect *DynamicContext::createDynamicDialect(StringRef name) {
     return ptr;
   };
   getContext()->getOrCreateDialect(name, typeId, ctor);
+  impl->dialects.try_emplace(name, dialect);
   return dialect;
 }
 
+DynamicDialect *DynamicContext::lookupDialect(StringRef name) {
+  return impl->dialects.lookup(name);
+}
+
 DynamicDialect *DynamicContext::lookupDialectFor(Type type) {
   if (auto dynTy = type.dyn_cast<DynamicType>())
     return dynTy.getDynImpl()->getDialect();
@@ -83,4 +99,21 @@ LogicalResult DynamicContext::registerDialectSymbol(DynamicDialect *dialect,
   return impl->registerDialectSymbol(dialect, opName);
 }
 
+void DynamicContext::getCanonicalizationPatterns(
+    OwningRewritePatternList &patterns) {
+  std::lock_guard<std::mutex> lock{impl->populatedListsMutex};
+  auto size = static_cast<std::size_t>(
+      std::distance(patterns.begin(), patterns.end()));
+  auto it = impl->populatedLists.find(&patterns);
+  if (it != impl->populatedLists.end()) {
+    auto [idx, first] = it->second;
+    if (idx < size && patterns.begin()[idx].get() == first)
+      return;
+  }
+  for (auto &dialect : impl->dialects)
+    dialect.second->getCanonicalizationPatterns(patterns);
+  if (patterns.begin() + size != patterns.end())
+    impl->populatedLists[&patterns] = {size, patterns.begin()[size].get()};
+}
+
 } // end namespace dmc
@@ -4,6 +4,11 @@
 #include "dmc/Dynamic/DynamicAttribute.h"
 #include "dmc/Dynamic/DynamicDialect.h"
 #include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Spec/SpecAttrImplementation.h"
+#include "dmc/Spec/SpecTypeImplementation.h"
+#include "dmc/Traits/SpecTraits.h"
+
+#include <mlir/IR/Builders.h>
 
 #include <mlir/IR/StandardTypes.h>
 
@@ -93,4 +98,41 @@ void DynamicDialect::printAttribute(Attribute attr,
   dynAttr.getDynImpl()->printAttribute(attr, printer);
 }
 
+Operation *DynamicDialect::materializeConstant(OpBuilder &builder,
+                                               Attribute value, Type type,
+                                               Location loc) {
+  for (auto *op : getOps()) {
+    auto attrName = op->getConstantAttrName();
+    if (!attrName)
+      continue;
+    auto resultTy = op->getTrait<TypeConstraintTrait>()->getOpType()
+        .getResultType(0);
+    auto attrTy = op->getTrait<AttrConstraintTrait>()->getOpAttrs()
+        .get(*attrName);
+    if (failed(SpecTypes::delegateVerify(resultTy, type)) ||
+        failed(SpecAttrs::delegateVerify(attrTy, value)))
+      continue;
+    OperationState state{loc, op->getName()};
+    state.addAttribute(*attrName, value);
+    state.addTypes(type);
+    return builder.createOperation(state);
+  }
+
+  /// Builtin constants can be materialized by the standard dialect.
+  auto isBuiltinConstant = [&] {
+    if (value.getType() != type)
+      return false;
+    return (value.isa<IntegerAttr>() && type.isIntOrIndex()) ||
+        (value.isa<FloatAttr>() && type.isa<FloatType>());
+  };
+  if (isBuiltinConstant() &&
+      AbstractOperation::lookup("std.constant", getContext())) {
+    OperationState state{loc, "std.constant"};
+    state.addAttribute("value", value);
+    state.addTypes(type);
+    return builder.createOperation(state);
+  }
+  return nullptr;
+}
+
 } // end namespace dmc
@@ -4,6 +4,7 @@
 #include "dmc/Dynamic/DynamicAttribute.h"
 #include "dmc/Dynamic/DynamicContext.h"
 #include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Embed/PatternCompiler.h"
 
 #include <mlir/IR/Operation.h>
 #include <llvm/ADT/StringMap.h>
@@ -21,6 +22,8 @@ class DynamicDialect::Impl {
   StringMap<std::unique_ptr<DynamicAttributeImpl>> dynAttrs;
   StringMap<TypeAlias> typeAliases;
   StringMap<AttributeAlias> attrAliases;
+  /// Declarative canonicalization patterns, in spec order.
+  std::vector<std::unique_ptr<py::NativePattern>> patterns;
 
   /// Since an alias refers to a concrete value which may not be a dynamic
   /// value, metadata cannot be directly associated with the values. When
@@ -31,7 +34,20 @@ class DynamicDialect::Impl {
   llvm::DenseMap<Attribute, AttributeAlias> attrAliasData;
 };
 
-DynamicDialect::~DynamicDialect() = default;
+/// The dialect is destroyed with its context, after which nothing refers to
+/// the TypeIDs of the dialect or its registered objects, so they are recycled.
+/// Objects that failed to register may still be referenced by the context and
+/// keep their TypeIDs.
+DynamicDialect::~DynamicDialect() {
+  auto *alloc = getTypeIDAllocator();
+  for (auto &op : llvm::make_second_range(impl->dynOps))
+    alloc->freeID(op->getTypeID());
+  for (auto &type : llvm::make_second_range(impl->dynTys))
+    alloc->freeID(type->getTypeID());
+  for (auto &attr : llvm::make_second_range(impl->dynAttrs))
+    alloc->freeID(attr->getTypeID());
+  alloc->freeID(DynamicObject::getTypeID());
+}
 
 DynamicDialect::DynamicDialect(StringRef name, DynamicContext *ctx)
     : DynamicObject{ctx},
@@ -145,6 +161,16 @@ template <typename E, typename MapT> static auto getDialectObjs(MapT &objs) {
   return ret;
 }
 
+void DynamicDialect::addPattern(std::unique_ptr<py::NativePattern> pattern) {
+  impl->patterns.push_back(std::move(pattern));
+}
+
+void DynamicDialect::getCanonicalizationPatterns(
+    OwningRewritePatternList &patterns) const {
+  for (auto &pattern : impl->patterns)
+    pattern->addTo(patterns, getContext());
+}
+
 std::vector<DynamicOperation *> DynamicDialect::getOps() {
   return getDialectObjs<DynamicOperation>(impl->dynOps);
 }
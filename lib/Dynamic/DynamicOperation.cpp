@@ -5,38 +5,29 @@
 #include "dmc/Spec/SpecAttrs.h"
 #include "dmc/Traits/SpecTraits.h"
 #include "dmc/Traits/StandardTraits.h"
-#include "dmc/Python/OpAsm.h"
 
 #include <mlir/IR/OpDefinition.h>
 #include <mlir/IR/OpImplementation.h>
 #include <mlir/IR/Builders.h>
 
+#include <mutex>
+
 using namespace mlir;
 
 namespace dmc {
 
 ParseResult BaseOp::parseAssembly(OpAsmParser &parser,
                                  OperationState &result) {
-  // TODO This is a *three*-step lookup
-  auto *ctx = parser.getBuilder().getContext();
-  auto *dynCtx = ctx->getRegisteredDialect<DynamicContext>();
-  assert(dynCtx && "Dynamic context is not registered");
-  auto *dialect = dynCtx->lookupDialectFor(result.name);
-  assert(dialect && "Not a dynamic operation");
-  auto *dynOp = dialect->lookupOp(result.name);
-  return dynOp->parseOperation(parser, result);
-}
-
-DynamicOperation *DynamicOperation::of(Operation *op) {
-  /// All DynamicOperations must belong to a DynamicDialect.
-  auto *dialect = dynamic_cast<DynamicDialect *>(op->getDialect());
-  assert(dialect && "Dynamic operation belongs to a non-dynamic dialect?");
-  return dialect->lookupOp(op->getName());
+  auto *opInfo = result.name.getAbstractOperation();
+  assert(opInfo && "Not a registered operation");
+  return DynamicOperation::of(opInfo)->parseOperation(parser, result);
 }
 
 bool BaseOp::classof(mlir::Operation *op) {
-  /// An Operation can be casted to dmc::BaseOp if it is a dynamic operation.
-  return dynamic_cast<DynamicDialect *>(op->getDialect());
+  /// An Operation can be casted to dmc::BaseOp if it is a dynamic operation,
+  /// i.e. it is registered with the BaseOp hooks.
+  auto *opInfo = op->getAbstractOperation();
+  return opInfo && &opInfo->parseAssembly == &BaseOp::parseAssembly;
 }
 
 DynamicOperation::DynamicOperation(StringRef name, DynamicDialect *dialect)
@@ -44,26 +35,109 @@ DynamicOperation::DynamicOperation(StringRef name, DynamicDialect *dialect)
       name{(dialect->getNamespace() + "." + name).str()},
       dialect{dialect} {}
 
+namespace {
+/// Process-wide assignment of trait IDs.
+class TraitIDs {
+public:
+  static TraitIDs &get() {
+    static TraitIDs instance;
+    return instance;
+  }
+
+  unsigned getID(StringRef name) {
+    std::lock_guard<std::mutex> lock{mutex};
+    return ids.try_emplace(name, ids.size()).first->second;
+  }
+
+  Optional<unsigned> lookupID(StringRef name) {
+    std::lock_guard<std::mutex> lock{mutex};
+    auto it = ids.find(name);
+    if (it == std::end(ids))
+      return llvm::None;
+    return it->second;
+  }
+
+private:
+  TraitIDs() = default;
+
+  std::mutex mutex;
+  llvm::StringMap<unsigned> ids;
+};
+} // end anonymous namespace
+
+unsigned getTraitID(StringRef name) {
+  return TraitIDs::get().getID(name);
+}
+
+Optional<unsigned> lookupTraitID(StringRef name) {
+  return TraitIDs::get().lookupID(name);
+}
+
 LogicalResult DynamicOperation::addOpTrait(
     StringRef name, std::unique_ptr<DynamicTrait> trait) {
-  if (getTrait(name))
+  auto id = getTraitID(name);
+  if (hasTrait(id))
     return failure();
-  traits.emplace_back(name, std::move(trait));
+  if (id >= traitBits.size()) {
+    traitBits.resize(id + 1);
+    traitSlots.resize(id + 1);
+  }
+  traitBits.set(id);
+  traitSlots[id] = trait.get();
+  traits.emplace_back(id, std::move(trait));
   return success();
 }
 
 DynamicTrait *DynamicOperation::getTrait(StringRef name) {
-  for (auto &trait : traits) {
-    if (trait.first == name)
-      return trait.second.get();
-  }
+  if (auto id = lookupTraitID(name))
+    return getTrait(*id);
   return nullptr;
 }
 
-void DynamicOperation::setOpFormat(std::string parserName,
-                                   std::string printerName) {
-  parserFcn = std::move(parserName);
-  printerFcn = std::move(printerName);
+LogicalResult DynamicOperation::setOpFormat(Location loc,
+                                            std::string parserName,
+                                            std::string printerName) {
+  auto parser = py::PythonFunction::lookup(parserName);
+  auto printer = py::PythonFunction::lookup(printerName);
+  if (!parser || !printer)
+    return emitError(loc) << "missing generated parser or printer for op '"
+        << getName() << "'";
+  parserFcn = std::move(*parser);
+  printerFcn = std::move(*printer);
+  return success();
+}
+
+void DynamicOperation::setNativeOpFormat(
+    std::unique_ptr<py::NativeOpFormat> format) {
+  nativeFormat = std::move(format);
+  useNative = hasNativeOpFormat();
+}
+
+void DynamicOperation::setFold(std::unique_ptr<py::NativeFold> fold,
+                               std::string pyFoldName) {
+  nativeFold = std::move(fold);
+  this->pyFoldName = std::move(pyFoldName);
+}
+
+LogicalResult DynamicOperation::foldOperation(
+    Operation *op, ArrayRef<Attribute> operands,
+    SmallVectorImpl<OpFoldResult> &results) {
+  if (nativeFold && succeeded(nativeFold->fold(op, operands, results)))
+    return success();
+  if (!pyFoldName.empty())
+    return py::execFold(pyFoldName, op, operands, results);
+  return failure();
+}
+
+bool BaseOp::hasConstantLikeTrait(TypeID traitID) {
+  return traitID == TypeID::get<OpTrait::ConstantLike>() ||
+      BaseOp::hasTrait(traitID);
+}
+
+void BaseOp::getCanonicalizationPatterns(OwningRewritePatternList &results,
+                                         MLIRContext *ctx) {
+  ctx->getRegisteredDialect<DynamicContext>()->getCanonicalizationPatterns(
+      results);
 }
 
 static auto handleDynamicInterfaces(DynamicOperation *op) {
@@ -73,11 +147,7 @@ static auto handleDynamicInterfaces(DynamicOperation *op) {
   ///   The interface should be removed if none of
   ///   Memory(Write|Read|Alloc|Free) or NoSideEffect or
   ///   (WriteTo|ReadFrom|Alloc|Free)<> are defined
-  if (!op->getTrait<MemoryWrite>() && !op->getTrait<MemoryRead>() &&
-      !op->getTrait<MemoryAlloc>() && !op->getTrait<MemoryFree>() &&
-      !op->getTrait<ReadFrom>() && !op->getTrait<WriteTo>() &&
-      !op->getTrait<Alloc>() && !op->getTrait<Free>() &&
-      !op->getTrait<NoSideEffects>())
+  if (op->getMemoryEffects().empty() && !op->getTrait<NoSideEffects>())
     map->erase(TypeID::get<MemoryEffectOpInterface>());
 
   if (!op->getTrait<LoopLike>())
@@ -86,21 +156,70 @@ static auto handleDynamicInterfaces(DynamicOperation *op) {
   return interfaces;
 }
 
+void DynamicOperation::buildMemoryEffects() {
+  if (getTrait<MemoryAlloc>())
+    effects.push_back({MemoryEffects::Allocate::get(),
+                       DynamicMemoryEffect::Op, 0});
+  if (getTrait<MemoryFree>())
+    effects.push_back({MemoryEffects::Free::get(), DynamicMemoryEffect::Op, 0});
+  if (getTrait<MemoryRead>())
+    effects.push_back({MemoryEffects::Read::get(), DynamicMemoryEffect::Op, 0});
+  if (getTrait<MemoryWrite>())
+    effects.push_back({MemoryEffects::Write::get(),
+                       DynamicMemoryEffect::Op, 0});
+
+  /// Resolve the named targets of value effects to group indices. Operands
+  /// take precedence over results with the same name. The targets have been
+  /// checked against the op type by the spec.
+  auto addValueEffects = [&](ValueMemoryEffect *trait,
+                             MemoryEffects::Effect *effect) {
+    if (!trait)
+      return;
+    auto opTy = getTrait<TypeConstraintTrait>()->getOpType();
+    auto findGroup = [](ArrayRef<NamedType> values, StringRef name) {
+      return llvm::find_if(values, [name](const NamedType &value)
+                           { return value.name == name; }) - values.begin();
+    };
+    for (auto target : trait->getTargets()) {
+      unsigned idx = findGroup(opTy.getOperands(), target);
+      if (idx != opTy.getNumOperands()) {
+        effects.push_back({effect, DynamicMemoryEffect::Operand, idx});
+        continue;
+      }
+      idx = findGroup(opTy.getResults(), target);
+      assert(idx != opTy.getNumResults() && "Unknown memory effect target");
+      effects.push_back({effect, DynamicMemoryEffect::Result, idx});
+    }
+  };
+  addValueEffects(getTrait<Alloc>(), MemoryEffects::Allocate::get());
+  addValueEffects(getTrait<Free>(), MemoryEffects::Free::get());
+  addValueEffects(getTrait<ReadFrom>(), MemoryEffects::Read::get());
+  addValueEffects(getTrait<WriteTo>(), MemoryEffects::Write::get());
+}
+
 LogicalResult DynamicOperation::finalize() {
   // Check that the operation name is unused.
   if (AbstractOperation::lookup(name, dialect->getContext()))
     return failure();
+  // Precompute the memory effects before the interfaces are resolved.
+  buildMemoryEffects();
+  // Classify the verifier so that native-only ops skip the GIL.
+  pythonVerifier = llvm::any_of(traits, [](const auto &trait)
+                                { return trait.second->verifiesInPython(); });
   // Add the operation to the dialect
   dialect->addOperation({
       name, *dialect, getOpProperties(), getTypeID(),
       BaseOp::parseAssembly, BaseOp::printAssembly,
       BaseOp::verifyInvariants, BaseOp::foldHook,
       BaseOp::getCanonicalizationPatterns,
-      handleDynamicInterfaces(this), BaseOp::hasTrait
+      handleDynamicInterfaces(this),
+      isConstantLike() ? BaseOp::hasConstantLikeTrait : BaseOp::hasTrait
   });
   /// Take reference to the operation info.
   opInfo = AbstractOperation::lookup(name, dialect->getContext());
   assert(opInfo != nullptr && "Failed to add DynamicOperation");
+  /// Bind this object to the op TypeID so hooks can dispatch directly.
+  bindTypeID(getTypeID(), this);
   return success();
 }
 
@@ -124,8 +243,11 @@ DynamicOperation::getOpProperties() const {
 
 ParseResult DynamicOperation::parseOperation(OpAsmParser &parser,
                                              OperationState &result) {
-  if (parserFcn) {
-    if (!py::execParser(*parserFcn, parser, result))
+  if (useNative) {
+    if (failed(nativeFormat->parse(parser, result)))
+      return failure();
+  } else if (parserFcn) {
+    if (!py::execParser(parserFcn, parser, result))
       return failure();
   } else {
     return parser.emitError(parser.getCurrentLocation(),
@@ -146,53 +268,60 @@ ParseResult DynamicOperation::parseOperation(OpAsmParser &parser,
 }
 
 void DynamicOperation::printOperation(OpAsmPrinter &printer, Operation *op) {
-  if (printerFcn) {
-    py::execPrinter(*printerFcn, printer, op, this);
+  if (useNative) {
+    nativeFormat->print(printer, op, this);
+  } else if (printerFcn) {
+    py::execPrinter(printerFcn, printer, op, this);
   } else {
     printer.printGenericOp(op);
   }
 }
 
+namespace {
+template <typename SizedT, typename SameT, typename GetSingleFcn>
+ValueRange getGroup(DynamicOperation *impl, Operation *op, unsigned idx,
+                    GetSingleFcn getSingle) {
+  if (impl->getTrait<SizedT>())
+    return SizedT::getGroup(op, idx);
+  else if (impl->getTrait<SameT>())
+    return SameT::getGroup(op, idx);
+  else
+    return getSingle(op, idx);
+}
+} // end anonymous namespace
+
+ValueRange DynamicOperation::getOperandGroup(Operation *op, unsigned idx) {
+  return getGroup<SizedOperandSegments, SameVariadicOperandSizes>(
+      this, op, idx, [](Operation *op, unsigned idx) {
+        auto it = std::next(op->operand_begin(), idx);
+        return OperandRange{it, std::next(it)};
+      });
+}
+
+ValueRange DynamicOperation::getResultGroup(Operation *op, unsigned idx) {
+  return getGroup<SizedResultSegments, SameVariadicResultSizes>(
+      this, op, idx, [](Operation *op, unsigned idx) {
+        auto it = std::next(op->result_begin(), idx);
+        return ResultRange{it, std::next(it)};
+      });
+}
+
 void BaseOp::getEffects(SmallVectorImpl<SideEffects::EffectInstance<
                         MemoryEffects::Effect>> &effects) {
-  // TODO this is slow; perhaps it should be precomputed?
   auto *impl = DynamicOperation::of(*this);
-  py::OperationWrap op{*this, impl};
-  if (impl->getTrait<MemoryAlloc>())
-    effects.emplace_back(MemoryEffects::Allocate::get());
-  if (impl->getTrait<MemoryFree>())
-    effects.emplace_back(MemoryEffects::Free::get());
-  if (impl->getTrait<MemoryRead>())
-    effects.emplace_back(MemoryEffects::Read::get());
-  if (impl->getTrait<MemoryWrite>())
-    effects.emplace_back(MemoryEffects::Write::get());
-
-  if (auto *trait = impl->getTrait<Alloc>()) {
-    for (auto target : trait->getTargets()) {
-      for (auto val : op.getOperandOrResultGroup(target)) {
-        effects.emplace_back(MemoryEffects::Allocate::get(), val);
-      }
-    }
-  }
-  if (auto *trait = impl->getTrait<Free>()) {
-    for (auto target : trait->getTargets()) {
-      for (auto val : op.getOperandOrResultGroup(target)) {
-        effects.emplace_back(MemoryEffects::Free::get(), val);
-      }
-    }
-  }
-  if (auto *trait = impl->getTrait<ReadFrom>()) {
-    for (auto target : trait->getTargets()) {
-      for (auto val : op.getOperandOrResultGroup(target)) {
-        effects.emplace_back(MemoryEffects::Read::get(), val);
-      }
-    }
-  }
-  if (auto *trait = impl->getTrait<WriteTo>()) {
-    for (auto target : trait->getTargets()) {
-      for (auto val : op.getOperandOrResultGroup(target)) {
-        effects.emplace_back(MemoryEffects::Write::get(), val);
-      }
+  for (auto &effect : impl->getMemoryEffects()) {
+    switch (effect.target) {
+    case DynamicMemoryEffect::Op:
+      effects.emplace_back(effect.effect);
+      break;
+    case DynamicMemoryEffect::Operand:
+      for (auto val : impl->getOperandGroup(*this, effect.groupIdx))
+        effects.emplace_back(effect.effect, val);
+      break;
+    case DynamicMemoryEffect::Result:
+      for (auto val : impl->getResultGroup(*this, effect.groupIdx))
+        effects.emplace_back(effect.effect, val);
+      break;
     }
   }
 }
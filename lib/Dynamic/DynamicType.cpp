@@ -59,8 +59,11 @@ DynamicTypeImpl::DynamicTypeImpl(DynamicDialect *dialect, StringRef name,
 
 Type DynamicTypeImpl::parseType(Location loc, DialectAsmParser &parser) {
   std::vector<Attribute> params;
-  if (parserFcn) {
-    if (!py::execParser(*parserFcn, parser, params))
+  if (useNative) {
+    if (failed(nativeFormat->parse(parser, params)))
+      return {};
+  } else if (parserFcn) {
+    if (!py::execParser(parserFcn, parser, params))
       return {};
   } else if (!parser.parseOptionalLess()) {
     do {
@@ -79,8 +82,12 @@ void DynamicTypeImpl::printType(Type type, DialectAsmPrinter &printer) {
   auto dynTy = type.cast<DynamicType>();
 
   /// Try a formated printer.
+  if (useNative) {
+    nativeFormat->print(printer, dynTy.getParams());
+    return;
+  }
   if (printerFcn) {
-    py::execPrinter(*printerFcn, printer, dynTy);
+    py::execPrinter(printerFcn, printer, dynTy);
     return;
   }
 
@@ -96,10 +103,23 @@ void DynamicTypeImpl::printType(Type type, DialectAsmPrinter &printer) {
   }
 }
 
-void DynamicTypeImpl::setFormat(std::string parserName,
-                                std::string printerName) {
-  parserFcn = std::move(parserName);
-  printerFcn = std::move(printerName);
+LogicalResult DynamicTypeImpl::setFormat(Location loc,
+                                         std::string parserName,
+                                         std::string printerName) {
+  auto parser = py::PythonFunction::lookup(parserName);
+  auto printer = py::PythonFunction::lookup(printerName);
+  if (!parser || !printer)
+    return emitError(loc) << "missing generated parser or printer for type '"
+        << getName() << "'";
+  parserFcn = std::move(*parser);
+  printerFcn = std::move(*printer);
+  return success();
+}
+
+void DynamicTypeImpl::setNativeFormat(
+    std::unique_ptr<py::NativeTypeFormat> format) {
+  nativeFormat = std::move(format);
+  useNative = hasNativeFormat();
 }
 
 /// One instance of DynamicType needs to be registered for each DynamicDialect,
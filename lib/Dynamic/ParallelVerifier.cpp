@@ -0,0 +1,80 @@
+#include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Dynamic/ParallelVerifier.h"
+
+#include <llvm/ADT/Optional.h>
+#include <llvm/Support/ThreadPool.h>
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/Verifier.h>
+#include <pybind11/pybind11.h>
+
+using namespace mlir;
+using namespace llvm;
+
+namespace dmc {
+
+namespace {
+/// Check whether verifying an op or any op nested in it may enter Python.
+bool verifiesInPython(Operation *root) {
+  return root->walk([](Operation *op) {
+    if (BaseOp::classof(op) && DynamicOperation::of(op)->verifiesInPython())
+      return WalkResult::interrupt();
+    return WalkResult::advance();
+  }).wasInterrupted();
+}
+
+/// Verify an isolated op on a worker thread. The GIL is held for the whole
+/// op if any of its constraints are interpreted.
+LogicalResult verifyIsolated(Operation *op) {
+  if (!verifiesInPython(op))
+    return mlir::verify(op);
+  pybind11::gil_scoped_acquire gil;
+  return mlir::verify(op);
+}
+} // end anonymous namespace
+
+LogicalResult verifyParallel(ModuleOp module, unsigned threads) {
+  /// Isolated ops can be verified independently of each other. Dominance
+  /// of values defined at the top level is only checked by verifying the
+  /// whole module, so fall back if any are used.
+  std::vector<Operation *> isolated, rest;
+  for (auto &op : *module.getBody()) {
+    if (!op.use_empty())
+      return mlir::verify(module);
+    if (op.isKnownIsolatedFromAbove())
+      isolated.push_back(&op);
+    else
+      rest.push_back(&op);
+  }
+  if (isolated.size() < 2)
+    return mlir::verify(module);
+
+  auto *ctx = module.getContext();
+  std::vector<char> failures(isolated.size());
+  {
+    ParallelDiagnosticHandler handler{ctx};
+    /// Let workers enter Python, if the caller holds the GIL.
+    Optional<pybind11::gil_scoped_release> release;
+    if (Py_IsInitialized() && PyGILState_Check())
+      release.emplace();
+    ThreadPool pool{hardware_concurrency(threads)};
+    for (unsigned i = 0, e = isolated.size(); i < e; ++i) {
+      pool.async([&, i] {
+        handler.setOrderIDForThread(i);
+        failures[i] = failed(verifyIsolated(isolated[i]));
+        handler.eraseOrderIDForThread();
+      });
+    }
+    pool.wait();
+  }
+
+  /// Verify the module itself without descending into its body, then the
+  /// remaining top-level ops.
+  bool ok = !is_contained(failures, true);
+  auto *opInfo = module.getOperation()->getAbstractOperation();
+  ok &= succeeded(opInfo->verifyInvariants(module));
+  for (auto *op : rest)
+    ok &= succeeded(mlir::verify(op));
+  return success(ok);
+}
+
+} // end namespace dmc
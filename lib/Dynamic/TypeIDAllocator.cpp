@@ -1,47 +1,131 @@
 #include "dmc/Dynamic/TypeIDAllocator.h"
 
+#include <llvm/Support/ErrorHandling.h>
+#include <llvm/Support/MathExtras.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
 using namespace mlir;
 
 namespace dmc {
 
-/// Pre-allocate a pool of TypeIDs. Definitely a hack.
 namespace {
 
-template <std::size_t NumIDs>
-using IDList = std::array<TypeID, NumIDs>;
+/// Allocate TypeID slots from a list of chunks. Chunk `k` holds
+/// `FirstChunkSize << k` slots, so a slot index maps to its chunk with a
+/// single bit scan. Chunks are created on demand and never freed or moved,
+/// which keeps TypeIDs stable and lets readers access slots without locks.
+///
+/// Freed slots are pushed onto a lock-free stack. The stack head packs the
+/// index of the top slot with a tag that is bumped on every update, which
+/// guards against ABA when popping.
+class ChunkedTypeIDAllocator : public TypeIDAllocator {
+public:
+  ~ChunkedTypeIDAllocator() override {
+    for (auto &chunk : chunks)
+      delete[] chunk.load(std::memory_order_relaxed);
+  }
 
-namespace detail {
+  TypeID allocateID() override {
+    /// Try to reuse a freed slot.
+    auto head = freeList.load(std::memory_order_acquire);
+    while (auto top = static_cast<uint32_t>(head)) {
+      auto *entry = getEntry(top - 1);
+      auto next = bumpTag(head) |
+          entry->nextFree.load(std::memory_order_relaxed);
+      if (freeList.compare_exchange_weak(head, next,
+                                         std::memory_order_acquire,
+                                         std::memory_order_acquire))
+        return TypeID::getFromOpaquePointer(&entry->slot);
+    }
 
-template <std::size_t Index> struct IDReserve {};
+    /// Otherwise, bump allocate a new slot.
+    auto index = nextIndex.fetch_add(1, std::memory_order_relaxed);
+    if (index >= MaxIndex)
+      llvm::report_fatal_error("Out of TypeIDs");
+    return TypeID::getFromOpaquePointer(&getOrCreateEntry(index)->slot);
+  }
 
-template <std::size_t... ID>
-IDList<sizeof...(ID)> allocateIDPoolImpl(std::index_sequence<ID...>) {
-  return {TypeID::get<IDReserve<ID>>()...};
-}
+  void freeID(TypeID id) override {
+    auto *entry = reinterpret_cast<Entry *>(detail::getTypeIDSlot(id));
+    entry->slot.object = nullptr;
+    auto head = freeList.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+      entry->nextFree.store(static_cast<uint32_t>(head),
+                            std::memory_order_relaxed);
+      next = bumpTag(head) | (entry->index + 1);
+    } while (!freeList.compare_exchange_weak(head, next,
+                                             std::memory_order_release,
+                                             std::memory_order_relaxed));
+  }
 
-template <std::size_t NumIDs> auto allocateIDPool() {
-  return allocateIDPoolImpl(std::make_index_sequence<NumIDs>());
-}
+private:
+  /// The slot must be the first member so that a TypeID is also the address
+  /// of its entry.
+  struct Entry {
+    detail::TypeIDSlot slot;
+    /// The index of this entry.
+    uint32_t index;
+    /// The free list link, as an index plus one.
+    std::atomic<uint32_t> nextFree{};
+  };
 
-} // end namespace detail
+  static constexpr unsigned FirstChunkLog2 = 10;
+  static constexpr unsigned NumChunks = 32 - FirstChunkLog2;
+  static constexpr uint32_t MaxIndex =
+      (uint32_t{1} << 31) - (uint32_t{1} << FirstChunkLog2);
 
-template <std::size_t NumIDs>
-class FixedTypeIDAllocator : public TypeIDAllocator {
-public:
-  TypeID allocateID() override {
-    assert(index < ids.size() && "Out of TypeIDs");
-    return ids[index++];
+  /// Get the chunk and offset of a slot index.
+  static std::pair<unsigned, uint32_t> locate(uint32_t index) {
+    auto biased = index + (uint32_t{1} << FirstChunkLog2);
+    auto chunk = llvm::Log2_32(biased) - FirstChunkLog2;
+    return {chunk, biased - (uint32_t{1} << (chunk + FirstChunkLog2))};
   }
 
-private:
-  std::size_t index{};
-  IDList<NumIDs> ids = detail::allocateIDPool<NumIDs>();
+  static uint64_t bumpTag(uint64_t head) {
+    return ((head >> 32) + 1) << 32;
+  }
+
+  /// Get an entry whose chunk is known to exist.
+  Entry *getEntry(uint32_t index) {
+    auto [chunk, offset] = locate(index);
+    return &chunks[chunk].load(std::memory_order_acquire)[offset];
+  }
+
+  Entry *getOrCreateEntry(uint32_t index) {
+    auto [chunk, offset] = locate(index);
+    auto *entries = chunks[chunk].load(std::memory_order_acquire);
+    if (!entries) {
+      auto size = uint32_t{1} << (chunk + FirstChunkLog2);
+      auto base = size - (uint32_t{1} << FirstChunkLog2);
+      auto *fresh = new Entry[size];
+      for (uint32_t i = 0; i < size; ++i)
+        fresh[i].index = base + i;
+      /// Another thread may have created the chunk first.
+      if (chunks[chunk].compare_exchange_strong(entries, fresh,
+                                                std::memory_order_acq_rel,
+                                                std::memory_order_acquire))
+        entries = fresh;
+      else
+        delete[] fresh;
+    }
+    return &entries[offset];
+  }
+
+  std::array<std::atomic<Entry *>, NumChunks> chunks{};
+  std::atomic<uint32_t> nextIndex{};
+  /// The free list head: a tag in the upper half and the top index plus one
+  /// in the lower half, or zero if empty.
+  std::atomic<uint64_t> freeList{};
 };
 
 } // end anonymous namespace
 
-TypeIDAllocator *getFixedTypeIDAllocator() {
-  static FixedTypeIDAllocator<2048> typeIdAllocator;
+TypeIDAllocator *getTypeIDAllocator() {
+  static ChunkedTypeIDAllocator typeIdAllocator;
   return &typeIdAllocator;
 }
 
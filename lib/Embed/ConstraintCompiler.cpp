@@ -0,0 +1,585 @@
+#include "dmc/Embed/ConstraintCompiler.h"
+#include "dmc/Dynamic/DynamicType.h"
+
+#include <llvm/ADT/StringSwitch.h>
+#include <mlir/IR/StandardTypes.h>
+
+#include <algorithm>
+#include <cctype>
+
+using namespace mlir;
+using namespace llvm;
+
+namespace dmc {
+namespace py {
+
+namespace detail {
+
+/// The value under test. Exactly one of the type or attribute is set.
+struct Subject {
+  Type type;
+  Attribute attr;
+  /// Set by nodes that cannot evaluate the subject natively. The Python
+  /// constraint decides instead.
+  mutable bool deferred{};
+};
+
+/// A node in the predicate tree. Nodes evaluate to an integer or a boolean,
+/// or to None where the equivalent Python expression would raise.
+class ConstraintNode {
+public:
+  enum ValueKind { Bool, Int };
+
+  explicit ConstraintNode(ValueKind kind) : kind{kind} {}
+  virtual ~ConstraintNode() = default;
+
+  virtual Optional<int64_t> eval(const Subject &subject) const = 0;
+  inline ValueKind getValueKind() const { return kind; }
+
+private:
+  ValueKind kind;
+};
+
+} // end namespace detail
+
+namespace {
+
+using detail::Subject;
+using detail::ConstraintNode;
+using NodePtr = std::unique_ptr<ConstraintNode>;
+using PropertyFcn = Optional<int64_t> (*)(const Subject &);
+
+/// An integer or boolean literal.
+class LiteralNode : public ConstraintNode {
+public:
+  explicit LiteralNode(ValueKind kind, int64_t value)
+      : ConstraintNode{kind}, value{value} {}
+
+  Optional<int64_t> eval(const Subject &) const override { return value; }
+
+private:
+  int64_t value;
+};
+
+/// A query on the subject: an isinstance check, a property, or a method.
+class PropertyNode : public ConstraintNode {
+public:
+  explicit PropertyNode(ValueKind kind, PropertyFcn fcn)
+      : ConstraintNode{kind}, fcn{fcn} {}
+
+  Optional<int64_t> eval(const Subject &subject) const override {
+    return fcn(subject);
+  }
+
+private:
+  PropertyFcn fcn;
+};
+
+class NotNode : public ConstraintNode {
+public:
+  explicit NotNode(NodePtr operand)
+      : ConstraintNode{Bool}, operand{std::move(operand)} {}
+
+  Optional<int64_t> eval(const Subject &subject) const override {
+    auto val = operand->eval(subject);
+    if (!val)
+      return llvm::None;
+    return !*val;
+  }
+
+private:
+  NodePtr operand;
+};
+
+/// Short-circuiting `and` and `or`.
+class LogicNode : public ConstraintNode {
+public:
+  explicit LogicNode(bool isAnd, NodePtr lhs, NodePtr rhs)
+      : ConstraintNode{Bool}, isAnd{isAnd},
+        lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+
+  Optional<int64_t> eval(const Subject &subject) const override {
+    auto lhsVal = lhs->eval(subject);
+    if (!lhsVal)
+      return llvm::None;
+    if (isAnd != static_cast<bool>(*lhsVal))
+      return *lhsVal;
+    return rhs->eval(subject);
+  }
+
+private:
+  bool isAnd;
+  NodePtr lhs, rhs;
+};
+
+class CompareNode : public ConstraintNode {
+public:
+  enum Predicate { EQ, NE, LT, LE, GT, GE };
+
+  explicit CompareNode(Predicate pred, NodePtr lhs, NodePtr rhs)
+      : ConstraintNode{Bool}, pred{pred},
+        lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+
+  Optional<int64_t> eval(const Subject &subject) const override {
+    auto lhsVal = lhs->eval(subject), rhsVal = rhs->eval(subject);
+    if (!lhsVal || !rhsVal)
+      return llvm::None;
+    switch (pred) {
+    case EQ: return *lhsVal == *rhsVal;
+    case NE: return *lhsVal != *rhsVal;
+    case LT: return *lhsVal < *rhsVal;
+    case LE: return *lhsVal <= *rhsVal;
+    case GT: return *lhsVal > *rhsVal;
+    case GE: return *lhsVal >= *rhsVal;
+    }
+    llvm_unreachable("Unknown comparison predicate");
+  }
+
+private:
+  Predicate pred;
+  NodePtr lhs, rhs;
+};
+
+/// Apply a function to the subject if it is an instance of `T`. Otherwise,
+/// the Python object does not have the property or method.
+template <typename T, typename FcnT>
+Optional<int64_t> applyTo(const Subject &subject, FcnT fcn) {
+  if constexpr (std::is_same_v<T, Type>) {
+    if (subject.type)
+      return fcn(subject.type);
+  } else if constexpr (std::is_base_of_v<Type, T>) {
+    if (auto t = subject.type.dyn_cast_or_null<T>())
+      return fcn(t);
+  } else {
+    if (auto a = subject.attr.dyn_cast_or_null<T>())
+      return fcn(a);
+  }
+  return llvm::None;
+}
+
+template <typename T> Optional<int64_t> isInstance(const Subject &subject) {
+  if constexpr (std::is_base_of_v<Type, T>)
+    return subject.type && subject.type.isa<T>();
+  else
+    return subject.attr && subject.attr.isa<T>();
+}
+
+/// Classes for which Python `isinstance` agrees with `isa`. Classes that the
+/// polymorphic type hook never selects, e.g. RankedTensorType, which is
+/// always downcast to TensorType, are left to Python.
+PropertyFcn lookupClass(StringRef name) {
+  return StringSwitch<PropertyFcn>(name)
+      .Case("IntegerType", &isInstance<IntegerType>)
+      .Case("FloatType", &isInstance<FloatType>)
+      .Case("IndexType", &isInstance<IndexType>)
+      .Case("ComplexType", &isInstance<ComplexType>)
+      .Case("NoneType", &isInstance<mlir::NoneType>)
+      .Case("FunctionType", &isInstance<FunctionType>)
+      .Case("OpaqueType", &isInstance<OpaqueType>)
+      .Case("TupleType", &isInstance<TupleType>)
+      .Case("ShapedType", &isInstance<ShapedType>)
+      .Case("VectorType", &isInstance<VectorType>)
+      .Case("TensorType", &isInstance<TensorType>)
+      .Case("BaseMemRefType", &isInstance<BaseMemRefType>)
+      .Case("DynamicType", &isInstance<DynamicType>)
+      .Case("AffineMapAttr", &isInstance<AffineMapAttr>)
+      .Case("ArrayAttr", &isInstance<ArrayAttr>)
+      .Case("BoolAttr", &isInstance<BoolAttr>)
+      .Case("DictionaryAttr", &isInstance<DictionaryAttr>)
+      .Case("FloatAttr", &isInstance<FloatAttr>)
+      .Case("IntegerAttr", &isInstance<IntegerAttr>)
+      .Case("OpaqueAttr", &isInstance<OpaqueAttr>)
+      .Case("StringAttr", &isInstance<StringAttr>)
+      .Case("SymbolRefAttr", &isInstance<SymbolRefAttr>)
+      .Case("TypeAttr", &isInstance<TypeAttr>)
+      .Case("ElementsAttr", &isInstance<ElementsAttr>)
+      .Default(nullptr);
+}
+
+/// `len({self})`, for the classes whose Python `__len__` does not raise.
+/// Other subjects are deferred to Python.
+Optional<int64_t> getLength(const Subject &subject) {
+  if (auto arr = subject.attr.dyn_cast_or_null<ArrayAttr>())
+    return arr.size();
+  if (auto elements = subject.attr.dyn_cast_or_null<ElementsAttr>())
+    return elements.getNumElements();
+  if (auto dict = subject.attr.dyn_cast_or_null<DictionaryAttr>())
+    return dict.size();
+  if (auto tuple = subject.type.dyn_cast_or_null<TupleType>())
+    return tuple.size();
+  if (auto shaped = subject.type.dyn_cast_or_null<ShapedType>())
+    if (shaped.hasStaticShape())
+      return shaped.getNumElements();
+  subject.deferred = true;
+  return llvm::None;
+}
+
+/// Properties, e.g. `{self}.width`.
+PropertyFcn lookupProperty(StringRef name) {
+  return StringSwitch<PropertyFcn>(name)
+      .Case("width", +[](const Subject &subject) -> Optional<int64_t> {
+        if (auto intTy = subject.type.dyn_cast_or_null<IntegerType>())
+          return intTy.getWidth();
+        return applyTo<FloatType>(subject, [](FloatType ty)
+                                  { return ty.getWidth(); });
+      })
+      .Case("rank", +[](const Subject &subject) -> Optional<int64_t> {
+        return applyTo<ShapedType>(subject, [](ShapedType ty)
+            -> Optional<int64_t> {
+          if (!ty.hasRank())
+            return llvm::None;
+          return ty.getRank();
+        });
+      })
+      .Case("numDynamicDims", +[](const Subject &subject) -> Optional<int64_t> {
+        return applyTo<ShapedType>(subject, [](ShapedType ty)
+            -> Optional<int64_t> {
+          if (!ty.hasRank())
+            return llvm::None;
+          return ty.getNumDynamicDims();
+        });
+      })
+      .Case("elementWidth", +[](const Subject &subject) -> Optional<int64_t> {
+        return applyTo<ShapedType>(subject, [](ShapedType ty)
+            -> Optional<int64_t> {
+          if (!ty.getElementType().isIntOrIndexOrFloat())
+            return llvm::None;
+          return ty.getElementTypeBitWidth();
+        });
+      })
+      .Default(nullptr);
+}
+
+/// Argument-less methods, e.g. `{self}.isSignless()`.
+PropertyFcn lookupMethod(StringRef name) {
+  return StringSwitch<PropertyFcn>(name)
+      /// IntegerType
+      .Case("isSignless", +[](const Subject &subject) {
+        return applyTo<IntegerType>(subject, [](IntegerType ty)
+                                    { return ty.isSignless(); });
+      })
+      .Case("isSigned", +[](const Subject &subject) {
+        return applyTo<IntegerType>(subject, [](IntegerType ty)
+                                    { return ty.isSigned(); });
+      })
+      .Case("isUnsigned", +[](const Subject &subject) {
+        return applyTo<IntegerType>(subject, [](IntegerType ty)
+                                    { return ty.isUnsigned(); });
+      })
+      /// Type
+      .Case("isIndex", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) { return ty.isIndex(); });
+      })
+      .Case("isBF16", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) { return ty.isBF16(); });
+      })
+      .Case("isF16", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) { return ty.isF16(); });
+      })
+      .Case("isF32", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) { return ty.isF32(); });
+      })
+      .Case("isF64", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) { return ty.isF64(); });
+      })
+      .Case("isSignlessIntOrIndex", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isSignlessIntOrIndex(); });
+      })
+      .Case("isSignlessIntOrIndexOrFloat", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isSignlessIntOrIndexOrFloat(); });
+      })
+      .Case("isSignlessIntOrFloat", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isSignlessIntOrFloat(); });
+      })
+      .Case("isIntOrIndex", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isIntOrIndex(); });
+      })
+      .Case("isIntOrFloat", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isIntOrFloat(); });
+      })
+      .Case("isIntOrIndexOrFloat", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty)
+                             { return ty.isIntOrIndexOrFloat(); });
+      })
+      .Case("getIntOrFloatBitWidth", +[](const Subject &subject) {
+        return applyTo<Type>(subject, [](Type ty) -> Optional<int64_t> {
+          if (!ty.isIntOrFloat())
+            return llvm::None;
+          return ty.getIntOrFloatBitWidth();
+        });
+      })
+      /// ShapedType
+      .Case("hasStaticShape", +[](const Subject &subject) {
+        return applyTo<ShapedType>(subject, [](ShapedType ty)
+                                   { return ty.hasStaticShape(); });
+      })
+      /// IntegerAttr
+      .Case("getInt", +[](const Subject &subject) {
+        return applyTo<IntegerAttr>(subject, [](IntegerAttr attr)
+            -> Optional<int64_t> {
+          auto ty = attr.getType();
+          if (!ty.isSignlessInteger() && !ty.isIndex())
+            return llvm::None;
+          return attr.getInt();
+        });
+      })
+      /// ArrayAttr
+      .Case("empty", +[](const Subject &subject) {
+        return applyTo<ArrayAttr>(subject, [](ArrayAttr attr)
+                                  { return attr.size() == 0; });
+      })
+      .Default(nullptr);
+}
+
+/// Tokens of the supported expression subset.
+struct Token {
+  enum Kind { Ident, Int, Self, LParen, RParen, Comma, Dot, Cmp, End, Error };
+
+  Kind kind;
+  StringRef spelling;
+};
+
+class Lexer {
+public:
+  explicit Lexer(StringRef expr) : expr{expr} {}
+
+  Token next() {
+    expr = expr.ltrim();
+    if (expr.empty())
+      return {Token::End, expr};
+    if (expr.startswith("{self}"))
+      return take(Token::Self, 6);
+    auto c = expr.front();
+    if (std::isdigit(c))
+      return take(Token::Int, expr.find_if_not(isDigit));
+    if (std::isalpha(c) || c == '_')
+      return take(Token::Ident, expr.find_if_not(isIdentChar));
+    if (expr.startswith("==") || expr.startswith("!=") ||
+        expr.startswith("<=") || expr.startswith(">="))
+      return take(Token::Cmp, 2);
+    switch (c) {
+    case '<': case '>': return take(Token::Cmp, 1);
+    case '(': return take(Token::LParen, 1);
+    case ')': return take(Token::RParen, 1);
+    case ',': return take(Token::Comma, 1);
+    case '.': return take(Token::Dot, 1);
+    default: return {Token::Error, expr};
+    }
+  }
+
+private:
+  static bool isDigit(char c) { return std::isdigit(c); }
+  static bool isIdentChar(char c) { return std::isalnum(c) || c == '_'; }
+
+  Token take(Token::Kind kind, std::size_t len) {
+    len = std::min(len, expr.size());
+    Token tok{kind, expr.take_front(len)};
+    expr = expr.drop_front(len);
+    return tok;
+  }
+
+  StringRef expr;
+};
+
+/// Recursive descent parser over the supported subset. Every parse function
+/// returns null if the expression falls outside the subset.
+class ConstraintParser {
+public:
+  explicit ConstraintParser(StringRef expr) : lexer{expr} { consume(); }
+
+  NodePtr parse() {
+    auto root = parseOr();
+    if (!root || cur.kind != Token::End ||
+        root->getValueKind() != ConstraintNode::Bool)
+      return nullptr;
+    return root;
+  }
+
+  /// Whether the expression uses `len`, which may defer to Python.
+  bool getUsesLength() const { return usesLength; }
+
+private:
+  void consume() { cur = lexer.next(); }
+
+  bool consumeIf(Token::Kind kind) {
+    if (cur.kind != kind)
+      return false;
+    consume();
+    return true;
+  }
+
+  bool consumeKeyword(StringRef keyword) {
+    if (cur.kind != Token::Ident || cur.spelling != keyword)
+      return false;
+    consume();
+    return true;
+  }
+
+  static bool isBool(const NodePtr &node) {
+    return node && node->getValueKind() == ConstraintNode::Bool;
+  }
+
+  /// or-expr ::= and-expr (`or` and-expr)*
+  NodePtr parseOr() {
+    auto lhs = parseAnd();
+    while (isBool(lhs) && consumeKeyword("or")) {
+      auto rhs = parseAnd();
+      if (!isBool(rhs))
+        return nullptr;
+      lhs = std::make_unique<LogicNode>(false, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  /// and-expr ::= not-expr (`and` not-expr)*
+  NodePtr parseAnd() {
+    auto lhs = parseNot();
+    while (isBool(lhs) && consumeKeyword("and")) {
+      auto rhs = parseNot();
+      if (!isBool(rhs))
+        return nullptr;
+      lhs = std::make_unique<LogicNode>(true, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  /// not-expr ::= `not` not-expr | compare-expr
+  NodePtr parseNot() {
+    if (!consumeKeyword("not"))
+      return parseCompare();
+    auto operand = parseNot();
+    if (!isBool(operand))
+      return nullptr;
+    return std::make_unique<NotNode>(std::move(operand));
+  }
+
+  /// compare-expr ::= operand (cmp-op operand)?
+  NodePtr parseCompare() {
+    auto lhs = parseOperand();
+    if (!lhs || cur.kind != Token::Cmp)
+      return lhs;
+    auto pred = StringSwitch<CompareNode::Predicate>(cur.spelling)
+        .Case("==", CompareNode::EQ)
+        .Case("!=", CompareNode::NE)
+        .Case("<", CompareNode::LT)
+        .Case("<=", CompareNode::LE)
+        .Case(">", CompareNode::GT)
+        .Case(">=", CompareNode::GE);
+    consume();
+    auto rhs = parseOperand();
+    /// Chained comparisons are left to Python.
+    if (!rhs || cur.kind == Token::Cmp)
+      return nullptr;
+    /// Booleans may only be compared for equality.
+    if (lhs->getValueKind() != rhs->getValueKind() ||
+        (isBool(lhs) && pred != CompareNode::EQ && pred != CompareNode::NE))
+      return nullptr;
+    return std::make_unique<CompareNode>(pred, std::move(lhs), std::move(rhs));
+  }
+
+  /// operand ::= `(` or-expr `)` | int | `True` | `False`
+  ///           | `isinstance` `(` `{self}` `,` class-name `)`
+  ///           | `len` `(` `{self}` `)`
+  ///           | `{self}` `.` property-name
+  ///           | `{self}` `.` method-name `(` `)`
+  NodePtr parseOperand() {
+    if (consumeIf(Token::LParen)) {
+      auto expr = parseOr();
+      if (!consumeIf(Token::RParen))
+        return nullptr;
+      return expr;
+    }
+    if (cur.kind == Token::Int) {
+      int64_t value;
+      if (cur.spelling.getAsInteger(10, value))
+        return nullptr;
+      consume();
+      return std::make_unique<LiteralNode>(ConstraintNode::Int, value);
+    }
+    if (consumeKeyword("True"))
+      return std::make_unique<LiteralNode>(ConstraintNode::Bool, 1);
+    if (consumeKeyword("False"))
+      return std::make_unique<LiteralNode>(ConstraintNode::Bool, 0);
+    if (consumeKeyword("isinstance")) {
+      if (!consumeIf(Token::LParen) || !consumeIf(Token::Self) ||
+          !consumeIf(Token::Comma) || cur.kind != Token::Ident)
+        return nullptr;
+      auto fcn = lookupClass(cur.spelling);
+      consume();
+      if (!fcn || !consumeIf(Token::RParen))
+        return nullptr;
+      return std::make_unique<PropertyNode>(ConstraintNode::Bool, fcn);
+    }
+    if (consumeKeyword("len")) {
+      if (!consumeIf(Token::LParen) || !consumeIf(Token::Self) ||
+          !consumeIf(Token::RParen))
+        return nullptr;
+      usesLength = true;
+      return std::make_unique<PropertyNode>(ConstraintNode::Int, &getLength);
+    }
+    if (consumeIf(Token::Self)) {
+      if (!consumeIf(Token::Dot) || cur.kind != Token::Ident)
+        return nullptr;
+      auto name = cur.spelling;
+      consume();
+      if (!consumeIf(Token::LParen)) {
+        if (auto fcn = lookupProperty(name))
+          return std::make_unique<PropertyNode>(ConstraintNode::Int, fcn);
+        return nullptr;
+      }
+      auto fcn = lookupMethod(name);
+      if (!fcn || !consumeIf(Token::RParen))
+        return nullptr;
+      /// Integer-valued methods.
+      auto kind = name == "getIntOrFloatBitWidth" || name == "getInt" ?
+          ConstraintNode::Int : ConstraintNode::Bool;
+      return std::make_unique<PropertyNode>(kind, fcn);
+    }
+    return nullptr;
+  }
+
+  Lexer lexer;
+  Token cur;
+  bool usesLength{};
+};
+
+} // end anonymous namespace
+
+NativeConstraint::~NativeConstraint() = default;
+
+NativeConstraint::NativeConstraint(std::unique_ptr<ConstraintNode> root,
+                                   bool mayDefer)
+    : root{std::move(root)}, defers{mayDefer} {}
+
+std::unique_ptr<NativeConstraint> NativeConstraint::compile(StringRef expr) {
+  ConstraintParser parser{expr};
+  auto root = parser.parse();
+  if (!root)
+    return nullptr;
+  return std::unique_ptr<NativeConstraint>{
+      new NativeConstraint{std::move(root), parser.getUsesLength()}};
+}
+
+static Optional<bool> evalRoot(const ConstraintNode &root,
+                               const Subject &subject) {
+  auto val = root.eval(subject);
+  if (subject.deferred)
+    return llvm::None;
+  return val && *val;
+}
+
+Optional<bool> NativeConstraint::operator()(Type type) const {
+  return evalRoot(*root, {type, {}});
+}
+
+Optional<bool> NativeConstraint::operator()(Attribute attr) const {
+  return evalRoot(*root, {{}, attr});
+}
+
+} // end namespace py
+} // end namespace dmc
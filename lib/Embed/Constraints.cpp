@@ -1,5 +1,6 @@
 #include "Scope.h"
 #include "dmc/Embed/Constraints.h"
+#include "dmc/Embed/ConstraintCompiler.h"
 #include "dmc/Traits/StandardTraits.h"
 #include "dmc/Dynamic/DynamicOperation.h"
 
@@ -25,8 +26,39 @@ public:
     return instance;
   }
 
-  /// Function registers a constraint and returns the name. Throws on error.
-  std::string registerConstraint(std::string expr) {
+  /// Register a constraint. Expressions in the native subset are compiled to
+  /// a predicate tree; otherwise, a Python function is generated. A native
+  /// constraint that may defer also gets the Python function. Throws on
+  /// error.
+  Constraint registerConstraint(StringRef expr) {
+    if (auto native = NativeConstraint::compile(expr)) {
+      natives.push_back(std::move(native));
+      auto *handle = natives.back().get();
+      if (handle->mayDefer())
+        return {handle, registerPyConstraint(expr.str())};
+      return {handle};
+    }
+    interpreted.push_back(expr.str());
+    return {nullptr, registerPyConstraint(expr.str())};
+  }
+
+  template <typename ArgT>
+  LogicalResult evalConstraint(const Constraint &constraint, ArgT arg) {
+    if (constraint.native)
+      if (auto result = (*constraint.native)(arg))
+        return success(*result);
+    gil_scoped_acquire gil;
+    return success(getInternalScope()[constraint.funcName.c_str()](arg)
+                   .template cast<bool>());
+  }
+
+  const std::vector<std::string> &getInterpreted() { return interpreted; }
+
+private:
+  ConstraintRegistry() = default;
+
+  /// Function registers a Python constraint and returns the name.
+  std::string registerPyConstraint(std::string expr) {
     // Substitute `{self}`
     dict fmtArgs{"self"_a = "arg"};
     auto pyExpr = pybind11::cast(expr).cast<str>().format(**fmtArgs);
@@ -40,35 +72,39 @@ public:
     return funcName;
   }
 
-  template <typename ArgT>
-  LogicalResult evalConstraint(const std::string &funcName, ArgT arg) {
-    return success(
-        getInternalScope()[funcName.c_str()](arg).template cast<bool>());
-  }
-
-private:
-  ConstraintRegistry() = default;
-
   std::size_t idx{};
+  /// Compiled constraints. Handles point into this list.
+  std::vector<std::unique_ptr<NativeConstraint>> natives;
+  /// Expressions that fell back to Python.
+  std::vector<std::string> interpreted;
 };
 } // end anonymous namespace
 
 LogicalResult registerConstraint(Location loc, StringRef expr,
-                                 std::string &funcName) {
+                                 Constraint &constraint) {
+  /// Specs may be registered from several threads. The GIL guards the
+  /// registry and the handle.
+  gil_scoped_acquire gil;
+  if (constraint)
+    return success();
   try {
-    funcName = ConstraintRegistry::get().registerConstraint(expr.str());
+    constraint = ConstraintRegistry::get().registerConstraint(expr);
   } catch (const std::runtime_error &e) {
     return emitError(loc) << "Failed to create Python constraint: " << e.what();
   }
   return success();
 }
 
-LogicalResult evalConstraint(const std::string &funcName, Type type) {
-  return ConstraintRegistry::get().evalConstraint(funcName, type);
+LogicalResult evalConstraint(const Constraint &constraint, Type type) {
+  return ConstraintRegistry::get().evalConstraint(constraint, type);
+}
+
+LogicalResult evalConstraint(const Constraint &constraint, Attribute attr) {
+  return ConstraintRegistry::get().evalConstraint(constraint, attr);
 }
 
-LogicalResult evalConstraint(const std::string &funcName, Attribute attr) {
-  return ConstraintRegistry::get().evalConstraint(funcName, attr);
+std::vector<std::string> getInterpretedConstraints() {
+  return ConstraintRegistry::get().getInterpreted();
 }
 
 } // end namespace py
@@ -1,5 +1,6 @@
 #include "Scope.h"
 #include "dmc/Embed/InMemoryDef.h"
+#include "dmc/Embed/SpecCache.h"
 #include "dmc/Dynamic/Alias.h"
 #include "dmc/Dynamic/DynamicType.h"
 #include "dmc/Dynamic/DynamicOperation.h"
@@ -35,8 +36,8 @@ paramArgs(NamedParameterRange params) {
 
 // TODO wish there was a Python API I could directly call, but one is not
 // provided by pybind11, so I resort to codegen.
-void exposeDynamicType(module &m, DynamicTypeImpl *impl) {
-  InMemoryClass cls{impl->getName(), {"mlir.DynamicType"}, m};
+std::string exposeDynamicType(DynamicTypeImpl *impl) {
+  DeferredClass cls{impl->getName(), {"mlir.DynamicType"}};
   auto &s = cls.stream();
   s.line() << "def __init__(self, " << paramArgs(impl->getParamSpec())
       << "):" << incr; {
@@ -49,6 +50,7 @@ void exposeDynamicType(module &m, DynamicTypeImpl *impl) {
       s.line() << "return super().getParam(\"" << param.getName() << "\")";
     } s.enddef();
   }
+  return cls.finish();
 }
 
 struct Argument {
@@ -95,14 +97,14 @@ StringRef sanitizeClassName(StringRef name) {
   return name;
 }
 
-void exposeDynamicOp(module &m, DynamicOperation *impl) {
+std::string exposeDynamicOp(DynamicOperation *impl) {
   auto *dialect = impl->getDialect();
   auto *ctx = dialect->getDynContext();
 
   // Declare the class
   auto opName = impl->getName();
-  InMemoryClass cls{sanitizeClassName(opName.substr(opName.find('.') + 1)),
-                    {"mlir.Op", "mlir.OperationWrap"}, m};
+  DeferredClass cls{sanitizeClassName(opName.substr(opName.find('.') + 1)),
+                    {"mlir.Op", "mlir.OperationWrap"}};
 
   // Retrieve op traits
   auto &s = cls.stream();
@@ -235,11 +237,13 @@ void exposeDynamicOp(module &m, DynamicOperation *impl) {
           << "\")";
     } s.enddef();
   }
+  return cls.finish();
 }
 
 } // end anonymous namespace
 
-void exposeDialectInternal(DynamicDialect *dialect, ArrayRef<StringRef> scope) {
+void exposeDialectInternal(DynamicDialect *dialect, ArrayRef<StringRef> scope,
+                           SpecCache &cache) {
   auto m = reinterpret_borrow<module>(
       PyImport_AddModule(dialect->getNamespace().str().c_str()));
   ensureBuiltins(m);
@@ -255,11 +259,19 @@ void exposeDialectInternal(DynamicDialect *dialect, ArrayRef<StringRef> scope) {
     exec(name.str() + " = mlir.register_internal_module_" +
          name.str() + "()", m.attr("__dict__"));
   }
-  for (auto *ty : dialect->getTypes()) {
-    exposeDynamicType(m, ty);
-  }
-  for (auto *op : dialect->getOps()) {
-    exposeDynamicOp(m, op);
+  /// Define the classes at once, or load them from the cache.
+  if (cache.isWarm()) {
+    cache.execIn("classes", m);
+  } else {
+    std::string source;
+    for (auto *ty : dialect->getTypes()) {
+      source += exposeDynamicType(ty);
+    }
+    for (auto *op : dialect->getOps()) {
+      source += exposeDynamicOp(op);
+    }
+    exec(source, m.attr("__dict__"));
+    cache.addSource("classes", source);
   }
   for (auto *ty : dialect->getTypeAliases()) {
     auto name = ty->getName().str();
@@ -0,0 +1,802 @@
+#include "Scope.h"
+#include "dmc/Embed/FoldCompiler.h"
+#include "dmc/Spec/OpType.h"
+
+/// The polymorphic_type_hook must be visible so that attributes returned to
+/// Python are downcasted to their derived classes.
+#include "dmc/Python/Polymorphic.h"
+
+#include <llvm/ADT/StringSwitch.h>
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/StandardTypes.h>
+#include <mlir/IR/TypeUtilities.h>
+
+#include <algorithm>
+#include <cctype>
+
+using namespace mlir;
+using namespace llvm;
+
+namespace dmc {
+namespace py {
+
+namespace detail {
+
+/// A value computed by a fold expression: an operand, which is forwarded or
+/// used as its constant, a typed constant, an untyped literal that takes the
+/// type of the constant it is combined with, or a boolean. Null if the
+/// expression does not fold.
+struct FoldValue {
+  enum Kind { Null, Operand, Constant, Int, Float, Bool };
+
+  Kind kind{Null};
+  Value value{};
+  Attribute attr{};
+  int64_t intVal{};
+  double floatVal{};
+
+  static FoldValue getOperand(Value value, Attribute attr) {
+    FoldValue ret{Operand};
+    ret.value = value;
+    ret.attr = attr;
+    return ret;
+  }
+  static FoldValue getConstant(Attribute attr) {
+    if (!attr)
+      return {};
+    FoldValue ret{Constant};
+    ret.attr = attr;
+    return ret;
+  }
+  static FoldValue getInt(int64_t val) {
+    FoldValue ret{Int};
+    ret.intVal = val;
+    return ret;
+  }
+  static FoldValue getFloat(double val) {
+    FoldValue ret{Float};
+    ret.floatVal = val;
+    return ret;
+  }
+  static FoldValue getBool(bool val) {
+    FoldValue ret{Bool};
+    ret.intVal = val;
+    return ret;
+  }
+
+  explicit operator bool() const { return kind != Null; }
+  bool isLiteral() const { return kind == Int || kind == Float; }
+  /// Get the constant of an operand or a constant. Null otherwise.
+  Attribute getAttr() const {
+    return kind == Operand || kind == Constant ? attr : Attribute{};
+  }
+};
+
+/// The op being folded.
+struct FoldSubject {
+  Operation *op;
+  ArrayRef<Attribute> operands;
+};
+
+/// A node in a fold expression tree.
+class FoldNode {
+public:
+  explicit FoldNode(bool isBool) : isBool{isBool} {}
+  virtual ~FoldNode() = default;
+
+  virtual FoldValue eval(const FoldSubject &subject) const = 0;
+  /// Whether the node evaluates to a boolean.
+  inline bool isBoolean() const { return isBool; }
+
+private:
+  bool isBool;
+};
+
+} // end namespace detail
+
+namespace {
+
+using detail::FoldValue;
+using detail::FoldSubject;
+using detail::FoldNode;
+using NodePtr = std::unique_ptr<FoldNode>;
+
+/// Give an untyped literal the type of a constant. Typed constants are
+/// returned as is.
+Attribute getTypedConstant(const FoldValue &val, Type type) {
+  if (auto attr = val.getAttr())
+    return attr;
+  if (!type)
+    return {};
+  if (val.kind == FoldValue::Int) {
+    if (type.isIntOrIndex())
+      return IntegerAttr::get(type, val.intVal);
+    if (type.isa<FloatType>())
+      return FloatAttr::get(type, static_cast<double>(val.intVal));
+  } else if (val.kind == FoldValue::Float && type.isa<FloatType>()) {
+    return FloatAttr::get(type, val.floatVal);
+  }
+  return {};
+}
+
+/// Get the type of an integer or float constant.
+Type getConstantType(const FoldValue &val) {
+  auto attr = val.getAttr();
+  if (auto intAttr = attr.dyn_cast_or_null<IntegerAttr>())
+    return intAttr.getType();
+  if (auto floatAttr = attr.dyn_cast_or_null<FloatAttr>())
+    return floatAttr.getType();
+  return {};
+}
+
+/// Convert the operands of a binary node to constants of the same type.
+/// Returns false if either is not a number.
+bool getTypedOperands(const FoldValue &lhs, const FoldValue &rhs,
+                      Attribute &lhsAttr, Attribute &rhsAttr) {
+  auto type = getConstantType(lhs);
+  if (!type)
+    type = getConstantType(rhs);
+  lhsAttr = getTypedConstant(lhs, type);
+  rhsAttr = getTypedConstant(rhs, type);
+  if (!lhsAttr || !rhsAttr || lhsAttr.getType() != rhsAttr.getType())
+    return false;
+  return (lhsAttr.isa<IntegerAttr>() && rhsAttr.isa<IntegerAttr>()) ||
+      (lhsAttr.isa<FloatAttr>() && rhsAttr.isa<FloatAttr>());
+}
+
+/// A reference to a non-variadic operand.
+class OperandNode : public FoldNode {
+public:
+  explicit OperandNode(unsigned idx) : FoldNode{false}, idx{idx} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    return FoldValue::getOperand(subject.op->getOperand(idx),
+                                 subject.operands[idx]);
+  }
+
+  inline unsigned getIndex() const { return idx; }
+
+private:
+  unsigned idx;
+};
+
+/// A reference to an attribute of the op.
+class AttrNode : public FoldNode {
+public:
+  explicit AttrNode(StringRef name) : FoldNode{false}, name{name.str()} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    return FoldValue::getConstant(subject.op->getAttr(name));
+  }
+
+  inline StringRef getName() const { return name; }
+
+private:
+  std::string name;
+};
+
+class LiteralNode : public FoldNode {
+public:
+  explicit LiteralNode(FoldValue value)
+      : FoldNode{value.kind == FoldValue::Bool}, value{value} {}
+
+  FoldValue eval(const FoldSubject &) const override { return value; }
+
+private:
+  FoldValue value;
+};
+
+class NegNode : public FoldNode {
+public:
+  explicit NegNode(NodePtr operand)
+      : FoldNode{false}, operand{std::move(operand)} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    auto val = operand->eval(subject);
+    switch (val.kind) {
+    case FoldValue::Int:
+      return FoldValue::getInt(-static_cast<uint64_t>(val.intVal));
+    case FoldValue::Float:
+      return FoldValue::getFloat(-val.floatVal);
+    default:
+      break;
+    }
+    auto attr = val.getAttr();
+    if (auto intAttr = attr.dyn_cast_or_null<IntegerAttr>())
+      return FoldValue::getConstant(
+          IntegerAttr::get(intAttr.getType(), -intAttr.getValue()));
+    if (auto floatAttr = attr.dyn_cast_or_null<FloatAttr>())
+      return FoldValue::getConstant(
+          FloatAttr::get(floatAttr.getType(), neg(floatAttr.getValue())));
+    return {};
+  }
+
+private:
+  NodePtr operand;
+};
+
+class ArithNode : public FoldNode {
+public:
+  enum Opcode { Add, Sub, Mul };
+
+  explicit ArithNode(Opcode opc, NodePtr lhs, NodePtr rhs)
+      : FoldNode{false}, opc{opc}, lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    auto lhsVal = lhs->eval(subject);
+    if (!lhsVal)
+      return {};
+    auto rhsVal = rhs->eval(subject);
+    if (!rhsVal)
+      return {};
+    /// Literal arithmetic stays untyped. Integers wrap around.
+    if (lhsVal.kind == FoldValue::Int && rhsVal.kind == FoldValue::Int) {
+      auto a = static_cast<uint64_t>(lhsVal.intVal);
+      auto b = static_cast<uint64_t>(rhsVal.intVal);
+      return FoldValue::getInt(opc == Add ? a + b : opc == Sub ? a - b : a * b);
+    }
+    if (lhsVal.isLiteral() && rhsVal.isLiteral()) {
+      auto toDouble = [](const FoldValue &val) {
+        return val.kind == FoldValue::Int ? static_cast<double>(val.intVal) :
+            val.floatVal;
+      };
+      auto a = toDouble(lhsVal), b = toDouble(rhsVal);
+      return FoldValue::getFloat(opc == Add ? a + b : opc == Sub ? a - b :
+                                 a * b);
+    }
+
+    Attribute lhsAttr, rhsAttr;
+    if (!getTypedOperands(lhsVal, rhsVal, lhsAttr, rhsAttr))
+      return {};
+    if (auto lhsInt = lhsAttr.dyn_cast<IntegerAttr>()) {
+      auto a = lhsInt.getValue(), b = rhsAttr.cast<IntegerAttr>().getValue();
+      return FoldValue::getConstant(IntegerAttr::get(
+          lhsInt.getType(), opc == Add ? a + b : opc == Sub ? a - b : a * b));
+    }
+    auto lhsFloat = lhsAttr.cast<FloatAttr>();
+    auto a = lhsFloat.getValue(), b = rhsAttr.cast<FloatAttr>().getValue();
+    auto rm = APFloat::rmNearestTiesToEven;
+    switch (opc) {
+    case Add: a.add(b, rm); break;
+    case Sub: a.subtract(b, rm); break;
+    case Mul: a.multiply(b, rm); break;
+    }
+    return FoldValue::getConstant(FloatAttr::get(lhsFloat.getType(), a));
+  }
+
+private:
+  Opcode opc;
+  NodePtr lhs, rhs;
+};
+
+class CompareNode : public FoldNode {
+public:
+  enum Predicate { EQ, NE, LT, LE, GT, GE };
+
+  explicit CompareNode(Predicate pred, NodePtr lhs, NodePtr rhs)
+      : FoldNode{true}, pred{pred}, lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    auto lhsVal = lhs->eval(subject);
+    if (!lhsVal)
+      return {};
+    auto rhsVal = rhs->eval(subject);
+    if (!rhsVal)
+      return {};
+    /// A value is equal to itself, unless it may be NaN.
+    if (lhsVal.kind == FoldValue::Operand && rhsVal.kind == FoldValue::Operand &&
+        lhsVal.value == rhsVal.value &&
+        !getElementTypeOrSelf(lhsVal.value.getType()).isa<FloatType>())
+      return fromOrder(0);
+    if (lhsVal.kind == FoldValue::Bool || rhsVal.kind == FoldValue::Bool) {
+      if (lhsVal.kind != rhsVal.kind || (pred != EQ && pred != NE))
+        return {};
+      return fromOrder(lhsVal.intVal - rhsVal.intVal);
+    }
+    if (lhsVal.kind == FoldValue::Int && rhsVal.kind == FoldValue::Int)
+      return fromOrder(lhsVal.intVal < rhsVal.intVal ? -1 :
+                       lhsVal.intVal > rhsVal.intVal);
+    if (lhsVal.isLiteral() && rhsVal.isLiteral())
+      return compareFloats(APFloat{lhsVal.kind == FoldValue::Int ?
+                                   lhsVal.intVal : lhsVal.floatVal},
+                           APFloat{rhsVal.kind == FoldValue::Int ?
+                                   rhsVal.intVal : rhsVal.floatVal});
+
+    Attribute lhsAttr, rhsAttr;
+    if (!getTypedOperands(lhsVal, rhsVal, lhsAttr, rhsAttr))
+      return {};
+    if (auto lhsInt = lhsAttr.dyn_cast<IntegerAttr>()) {
+      auto a = lhsInt.getValue(), b = rhsAttr.cast<IntegerAttr>().getValue();
+      if (lhsInt.getType().isUnsignedInteger())
+        return fromOrder(a.ult(b) ? -1 : a.ugt(b));
+      return fromOrder(a.slt(b) ? -1 : a.sgt(b));
+    }
+    return compareFloats(lhsAttr.cast<FloatAttr>().getValue(),
+                         rhsAttr.cast<FloatAttr>().getValue());
+  }
+
+private:
+  /// Evaluate the predicate given the sign of `lhs - rhs`.
+  FoldValue fromOrder(int64_t order) const {
+    switch (pred) {
+    case EQ: return FoldValue::getBool(order == 0);
+    case NE: return FoldValue::getBool(order != 0);
+    case LT: return FoldValue::getBool(order < 0);
+    case LE: return FoldValue::getBool(order <= 0);
+    case GT: return FoldValue::getBool(order > 0);
+    case GE: return FoldValue::getBool(order >= 0);
+    }
+    llvm_unreachable("Unknown comparison predicate");
+  }
+
+  /// Comparisons with NaN are false, except `!=`.
+  FoldValue compareFloats(const APFloat &a, const APFloat &b) const {
+    switch (a.compare(b)) {
+    case APFloat::cmpLessThan: return fromOrder(-1);
+    case APFloat::cmpEqual: return fromOrder(0);
+    case APFloat::cmpGreaterThan: return fromOrder(1);
+    case APFloat::cmpUnordered: return FoldValue::getBool(pred == NE);
+    }
+    llvm_unreachable("Unknown float comparison result");
+  }
+
+  Predicate pred;
+  NodePtr lhs, rhs;
+};
+
+class NotNode : public FoldNode {
+public:
+  explicit NotNode(NodePtr operand)
+      : FoldNode{true}, operand{std::move(operand)} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    auto val = operand->eval(subject);
+    if (!val)
+      return {};
+    return FoldValue::getBool(!val.intVal);
+  }
+
+private:
+  NodePtr operand;
+};
+
+/// Short-circuiting `and` and `or`.
+class LogicNode : public FoldNode {
+public:
+  explicit LogicNode(bool isAnd, NodePtr lhs, NodePtr rhs)
+      : FoldNode{true}, isAnd{isAnd}, lhs{std::move(lhs)}, rhs{std::move(rhs)} {}
+
+  FoldValue eval(const FoldSubject &subject) const override {
+    auto lhsVal = lhs->eval(subject);
+    if (!lhsVal)
+      return {};
+    if (isAnd != static_cast<bool>(lhsVal.intVal))
+      return lhsVal;
+    return rhs->eval(subject);
+  }
+
+private:
+  bool isAnd;
+  NodePtr lhs, rhs;
+};
+
+/// Tokens of fold expressions.
+struct Token {
+  enum Kind {
+    Ident, Int, Float, Ref, LParen, RParen, Plus, Minus, Star, Cmp, End, Error
+  };
+
+  Kind kind;
+  StringRef spelling;
+};
+
+class Lexer {
+public:
+  explicit Lexer(StringRef expr) : expr{expr} {}
+
+  Token next() {
+    expr = expr.ltrim();
+    if (expr.empty())
+      return {Token::End, expr};
+    auto c = expr.front();
+    if (std::isdigit(c)) {
+      auto len = expr.find_if_not(isNumberChar);
+      auto kind = expr.take_front(len).contains('.') ? Token::Float :
+          Token::Int;
+      return take(kind, len);
+    }
+    if (std::isalpha(c) || c == '_')
+      return take(Token::Ident, expr.find_if_not(isIdentChar));
+    if (c == '$') {
+      auto len = expr.drop_front().find_if_not(isIdentChar);
+      if (len == 0)
+        return {Token::Error, expr};
+      return take(Token::Ref, len == StringRef::npos ? expr.size() : len + 1);
+    }
+    if (expr.startswith("==") || expr.startswith("!=") ||
+        expr.startswith("<=") || expr.startswith(">="))
+      return take(Token::Cmp, 2);
+    switch (c) {
+    case '<': case '>': return take(Token::Cmp, 1);
+    case '(': return take(Token::LParen, 1);
+    case ')': return take(Token::RParen, 1);
+    case '+': return take(Token::Plus, 1);
+    case '-': return take(Token::Minus, 1);
+    case '*': return take(Token::Star, 1);
+    default: return {Token::Error, expr};
+    }
+  }
+
+private:
+  static bool isNumberChar(char c) { return std::isdigit(c) || c == '.'; }
+  static bool isIdentChar(char c) { return std::isalnum(c) || c == '_'; }
+
+  Token take(Token::Kind kind, std::size_t len) {
+    len = std::min(len, expr.size());
+    Token tok{kind, expr.take_front(len)};
+    expr = expr.drop_front(len);
+    return tok;
+  }
+
+  StringRef expr;
+};
+
+/// Recursive descent parser of fold alternatives. Parse functions return null
+/// and set the error message on failure.
+class FoldParser {
+public:
+  explicit FoldParser(StringRef expr, OpType opTy, DictionaryAttr opAttrs)
+      : lexer{expr}, opTy{opTy}, opAttrs{opAttrs} { consume(); }
+
+  /// alternative ::= compare-expr (`if` or-expr)?
+  bool parse(NodePtr &result, NodePtr &cond) {
+    result = parseCompare();
+    if (!result)
+      return false;
+    if (consumeKeyword("if")) {
+      cond = parseOr();
+      if (!cond)
+        return false;
+      if (!cond->isBoolean())
+        return fail("expected a boolean condition");
+    }
+    if (cur.kind != Token::End)
+      return fail("unexpected '" + cur.spelling + "'");
+    return true;
+  }
+
+  inline StringRef getError() const { return error; }
+
+private:
+  void consume() { cur = lexer.next(); }
+
+  bool consumeIf(Token::Kind kind) {
+    if (cur.kind != kind)
+      return false;
+    consume();
+    return true;
+  }
+
+  bool consumeKeyword(StringRef keyword) {
+    if (cur.kind != Token::Ident || cur.spelling != keyword)
+      return false;
+    consume();
+    return true;
+  }
+
+  bool fail(const Twine &msg) {
+    if (error.empty())
+      error = msg.str();
+    return false;
+  }
+
+  NodePtr failNode(const Twine &msg) {
+    fail(msg);
+    return nullptr;
+  }
+
+  /// or-expr ::= and-expr (`or` and-expr)*
+  NodePtr parseOr() {
+    auto lhs = parseAnd();
+    while (lhs && consumeKeyword("or")) {
+      auto rhs = parseAnd();
+      if (!rhs)
+        return nullptr;
+      if (!lhs->isBoolean() || !rhs->isBoolean())
+        return failNode("expected boolean operands to 'or'");
+      lhs = std::make_unique<LogicNode>(false, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  /// and-expr ::= not-expr (`and` not-expr)*
+  NodePtr parseAnd() {
+    auto lhs = parseNot();
+    while (lhs && consumeKeyword("and")) {
+      auto rhs = parseNot();
+      if (!rhs)
+        return nullptr;
+      if (!lhs->isBoolean() || !rhs->isBoolean())
+        return failNode("expected boolean operands to 'and'");
+      lhs = std::make_unique<LogicNode>(true, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  /// not-expr ::= `not` not-expr | compare-expr
+  NodePtr parseNot() {
+    if (!consumeKeyword("not"))
+      return parseCompare();
+    auto operand = parseNot();
+    if (!operand)
+      return nullptr;
+    if (!operand->isBoolean())
+      return failNode("expected a boolean operand to 'not'");
+    return std::make_unique<NotNode>(std::move(operand));
+  }
+
+  /// compare-expr ::= arith-expr (cmp-op arith-expr)?
+  NodePtr parseCompare() {
+    auto lhs = parseArith();
+    if (!lhs || cur.kind != Token::Cmp)
+      return lhs;
+    auto pred = StringSwitch<CompareNode::Predicate>(cur.spelling)
+        .Case("==", CompareNode::EQ)
+        .Case("!=", CompareNode::NE)
+        .Case("<", CompareNode::LT)
+        .Case("<=", CompareNode::LE)
+        .Case(">", CompareNode::GT)
+        .Case(">=", CompareNode::GE);
+    consume();
+    auto rhs = parseArith();
+    if (!rhs)
+      return nullptr;
+    if (cur.kind == Token::Cmp)
+      return failNode("comparisons cannot be chained");
+    return std::make_unique<CompareNode>(pred, std::move(lhs), std::move(rhs));
+  }
+
+  /// arith-expr ::= term ((`+` | `-`) term)*
+  NodePtr parseArith() {
+    auto lhs = parseTerm();
+    while (lhs && (cur.kind == Token::Plus || cur.kind == Token::Minus)) {
+      auto opc = cur.kind == Token::Plus ? ArithNode::Add : ArithNode::Sub;
+      consume();
+      auto rhs = parseTerm();
+      if (!rhs)
+        return nullptr;
+      lhs = makeArith(opc, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  /// term ::= unary (`*` unary)*
+  NodePtr parseTerm() {
+    auto lhs = parseUnary();
+    while (lhs && consumeIf(Token::Star)) {
+      auto rhs = parseUnary();
+      if (!rhs)
+        return nullptr;
+      lhs = makeArith(ArithNode::Mul, std::move(lhs), std::move(rhs));
+    }
+    return lhs;
+  }
+
+  NodePtr makeArith(ArithNode::Opcode opc, NodePtr lhs, NodePtr rhs) {
+    if (lhs->isBoolean() || rhs->isBoolean())
+      return failNode("arithmetic on a boolean");
+    return std::make_unique<ArithNode>(opc, std::move(lhs), std::move(rhs));
+  }
+
+  /// unary ::= `-` unary | operand
+  NodePtr parseUnary() {
+    if (!consumeIf(Token::Minus))
+      return parseOperand();
+    auto operand = parseUnary();
+    if (!operand)
+      return nullptr;
+    if (operand->isBoolean())
+      return failNode("arithmetic on a boolean");
+    return std::make_unique<NegNode>(std::move(operand));
+  }
+
+  /// operand ::= `(` or-expr `)` | int | float | `True` | `False` | `$`name
+  NodePtr parseOperand() {
+    if (consumeIf(Token::LParen)) {
+      auto expr = parseOr();
+      if (!expr)
+        return nullptr;
+      if (!consumeIf(Token::RParen))
+        return failNode("expected ')'");
+      return expr;
+    }
+    if (cur.kind == Token::Int) {
+      int64_t value;
+      if (cur.spelling.getAsInteger(10, value))
+        return failNode("invalid integer '" + cur.spelling + "'");
+      consume();
+      return std::make_unique<LiteralNode>(FoldValue::getInt(value));
+    }
+    if (cur.kind == Token::Float) {
+      double value;
+      if (cur.spelling.getAsDouble(value))
+        return failNode("invalid float '" + cur.spelling + "'");
+      consume();
+      return std::make_unique<LiteralNode>(FoldValue::getFloat(value));
+    }
+    if (consumeKeyword("True"))
+      return std::make_unique<LiteralNode>(FoldValue::getBool(true));
+    if (consumeKeyword("False"))
+      return std::make_unique<LiteralNode>(FoldValue::getBool(false));
+    if (cur.kind == Token::Ref) {
+      auto name = cur.spelling.drop_front();
+      consume();
+      return resolveName(name);
+    }
+    if (cur.kind == Token::End)
+      return failNode("unexpected end of expression");
+    return failNode("unexpected '" + cur.spelling + "'");
+  }
+
+  /// Resolve a name to an operand or an attribute. Operands are indexed
+  /// directly, so they cannot follow a variadic operand.
+  NodePtr resolveName(StringRef name) {
+    auto operands = opTy.getOperands();
+    for (unsigned idx = 0, e = operands.size(); idx < e; ++idx) {
+      if (operands[idx].isVariadic())
+        break;
+      if (operands[idx].name == name)
+        return std::make_unique<OperandNode>(idx);
+    }
+    if (llvm::any_of(operands, [name](const NamedType &operand)
+                     { return operand.name == name; }))
+      return failNode("operand '" + name + "' is or follows a variadic "
+                      "operand");
+    if (opAttrs.get(name))
+      return std::make_unique<AttrNode>(name);
+    return failNode("unknown operand or attribute '" + name + "'");
+  }
+
+  Lexer lexer;
+  Token cur;
+  OpType opTy;
+  DictionaryAttr opAttrs;
+  std::string error;
+};
+
+} // end anonymous namespace
+
+struct NativeFold::Alternative {
+  NodePtr result, cond;
+};
+
+NativeFold::NativeFold() = default;
+NativeFold::~NativeFold() = default;
+
+std::unique_ptr<NativeFold> NativeFold::compile(Location loc,
+                                                ArrayRef<StringRef> exprs,
+                                                OpType opTy,
+                                                DictionaryAttr opAttrs) {
+  if (opTy.getNumResults() != 1 || opTy.getResult(0)->isVariadic()) {
+    emitError(loc) << "only ops with one result can be folded";
+    return nullptr;
+  }
+  std::unique_ptr<NativeFold> fold{new NativeFold};
+  for (auto expr : exprs) {
+    FoldParser parser{expr, opTy, opAttrs};
+    Alternative alt;
+    if (!parser.parse(alt.result, alt.cond)) {
+      emitError(loc) << "invalid fold expression '" << expr << "': "
+                     << parser.getError();
+      return nullptr;
+    }
+    fold->alternatives.push_back(std::move(alt));
+  }
+  /// An op without operands that unconditionally folds to an attribute is a
+  /// constant.
+  auto &alts = fold->alternatives;
+  if (!opTy.getNumOperands() && alts.size() == 1 && !alts.front().cond) {
+    if (auto *attr = dynamic_cast<AttrNode *>(alts.front().result.get()))
+      fold->constantAttr = attr->getName().str();
+  }
+  return fold;
+}
+
+/// Convert the value of an alternative to the fold result of an op. Untyped
+/// literals take the result type.
+static OpFoldResult getFoldResult(const FoldValue &val, Operation *op) {
+  auto resultTy = op->getResult(0).getType();
+  switch (val.kind) {
+  case FoldValue::Operand:
+    /// Forwarding an operand must not change the type of the result.
+    if (val.value.getType() == resultTy)
+      return val.value;
+    return val.attr;
+  case FoldValue::Constant:
+    return val.attr;
+  case FoldValue::Int:
+  case FoldValue::Float:
+    return getTypedConstant(val, resultTy);
+  case FoldValue::Bool:
+    return IntegerAttr::get(IntegerType::get(1, op->getContext()),
+                            val.intVal);
+  case FoldValue::Null:
+    break;
+  }
+  return {};
+}
+
+LogicalResult NativeFold::fold(Operation *op, ArrayRef<Attribute> operands,
+                               SmallVectorImpl<OpFoldResult> &results) const {
+  FoldSubject subject{op, operands};
+  for (auto &alt : alternatives) {
+    if (alt.cond) {
+      auto cond = alt.cond->eval(subject);
+      if (!cond || !cond.intVal)
+        continue;
+    }
+    if (auto result = getFoldResult(alt.result->eval(subject), op)) {
+      results.push_back(result);
+      return success();
+    }
+  }
+  return failure();
+}
+
+Optional<StringRef> NativeFold::getConstantAttrName() const {
+  if (constantAttr.empty())
+    return llvm::None;
+  return StringRef{constantAttr};
+}
+
+LogicalResult checkPyFold(Location loc, const std::string &fcnName) {
+  pybind11::gil_scoped_acquire gil;
+  auto scope = getMainScope();
+  if (!scope.contains(fcnName.c_str()) ||
+      !PyCallable_Check(scope[fcnName.c_str()].ptr()))
+    return emitError(loc) << "Python fold '" << fcnName
+                          << "' is not a function in the main scope";
+  return success();
+}
+
+LogicalResult execFold(const std::string &fcnName, Operation *op,
+                       ArrayRef<Attribute> operands,
+                       SmallVectorImpl<OpFoldResult> &results) {
+  pybind11::gil_scoped_acquire gil;
+  try {
+    pybind11::list pyOperands;
+    for (auto attr : operands) {
+      if (attr)
+        pyOperands.append(pybind11::cast(attr));
+      else
+        pyOperands.append(pybind11::none());
+    }
+    auto ret = getMainScope()[fcnName.c_str()](op, pyOperands);
+    if (ret.is_none())
+      return failure();
+    auto addResult = [&](pybind11::handle obj) {
+      if (pybind11::isinstance<Attribute>(obj))
+        results.push_back(obj.cast<Attribute>());
+      else if (pybind11::isinstance<Value>(obj))
+        results.push_back(obj.cast<Value>());
+      else
+        throw std::invalid_argument{"expected an Attribute or a Value"};
+    };
+    if (pybind11::isinstance<pybind11::list>(ret)) {
+      for (auto obj : ret.cast<pybind11::list>())
+        addResult(obj);
+    } else {
+      addResult(ret);
+    }
+    if (results.size() != op->getNumResults())
+      throw std::invalid_argument{"expected one fold result per op result"};
+  } catch (const std::exception &) {
+    /// Folding is opportunistic, so a fold that raises does not fold.
+    results.clear();
+    return failure();
+  }
+  return success();
+}
+
+} // end namespace py
+} // end namespace dmc
@@ -0,0 +1,16 @@
+#include "dmc/Embed/FormatBackend.h"
+
+#include <cstdlib>
+
+namespace dmc {
+namespace py {
+
+FormatBackend getDefaultFormatBackend() {
+  if (auto *name = std::getenv("DMC_FORMAT_BACKEND"))
+    if (auto backend = symbolizeFormatBackend(name))
+      return *backend;
+  return FormatBackend::Python;
+}
+
+} // end namespace py
+} // end namespace dmc
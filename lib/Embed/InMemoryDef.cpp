@@ -10,18 +10,21 @@ using namespace pybind11;
 namespace dmc {
 namespace py {
 
-InMemoryDef::InMemoryDef(StringRef fcnName, StringRef fcnSig) {
+DeferredDef::DeferredDef(StringRef fcnName, StringRef fcnSig) {
   pgs.def(fcnName + fcnSig);
 }
 
-InMemoryDef::~InMemoryDef() {
+std::string DeferredDef::finish() {
   pgs.enddef();
-  // Store the parser/printer in the internal scope
-  exec(os.str(), getInternalScope());
+  return os.str();
 }
 
-InMemoryClass::InMemoryClass(StringRef clsName, ArrayRef<StringRef> parentCls,
-                             module &m) : m{m} {
+void execDefs(const std::string &source) {
+  exec(source, getInternalScope());
+}
+
+DeferredClass::DeferredClass(StringRef clsName,
+                             ArrayRef<StringRef> parentCls) {
   // intercept invalid class names
   auto valid = StringSwitch<bool>(clsName)
       .Case("return", false)
@@ -38,9 +41,9 @@ InMemoryClass::InMemoryClass(StringRef clsName, ArrayRef<StringRef> parentCls,
   line << "):" << incr;
 }
 
-InMemoryClass::~InMemoryClass() {
+std::string DeferredClass::finish() {
   pgs.endblock();
-  exec(os.str(), m.attr("__dict__"));
+  return os.str();
 }
 
 } // end namespace py
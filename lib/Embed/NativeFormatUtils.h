@@ -0,0 +1,36 @@
+#pragma once
+
+#include <mlir/Support/LogicalResult.h>
+#include <llvm/ADT/StringRef.h>
+
+#include <cctype>
+
+namespace dmc {
+namespace py {
+
+/// Returns true if the literal is a keyword.
+inline bool isKeywordLiteral(llvm::StringRef value) {
+  return value.front() == '_' || isalpha(value.front());
+}
+
+/// Parse a literal, mirroring `getParserForLiteral`. Works with both the
+/// operation and dialect parsers.
+template <typename ParserT>
+mlir::ParseResult parseLiteral(ParserT &parser, llvm::StringRef value) {
+  if (isKeywordLiteral(value))
+    return parser.parseKeyword(value);
+  if (value == "->") return parser.parseArrow();
+  if (value == ":") return parser.parseColon();
+  if (value == ",") return parser.parseComma();
+  if (value == "=") return parser.parseEqual();
+  if (value == "<") return parser.parseLess();
+  if (value == ">") return parser.parseGreater();
+  if (value == "(") return parser.parseLParen();
+  if (value == ")") return parser.parseRParen();
+  if (value == "[") return parser.parseLSquare();
+  if (value == "]") return parser.parseRSquare();
+  return mlir::failure();
+}
+
+} // end namespace py
+} // end namespace dmc
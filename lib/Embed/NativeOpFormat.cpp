@@ -0,0 +1,374 @@
+#include "NativeFormatUtils.h"
+#include "dmc/Embed/NativeOpFormat.h"
+#include "dmc/Dynamic/DynamicOperation.h"
+
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/StandardTypes.h>
+
+using namespace mlir;
+
+namespace dmc {
+namespace py {
+
+namespace {
+
+ParseResult parseOptionalLiteral(OpAsmParser &parser, StringRef value) {
+  if (isKeywordLiteral(value))
+    return parser.parseOptionalKeyword(value);
+  if (value == "->") return parser.parseOptionalArrow();
+  if (value == ":") return parser.parseOptionalColon();
+  if (value == ",") return parser.parseOptionalComma();
+  if (value == "<") return parser.parseOptionalLess();
+  if (value == ">") return parser.parseOptionalGreater();
+  if (value == "(") return parser.parseOptionalLParen();
+  if (value == ")") return parser.parseOptionalRParen();
+  if (value == "[") return parser.parseOptionalLSquare();
+  if (value == "]") return parser.parseOptionalRSquare();
+  return failure();
+}
+
+/// Parse a region with an optional parenthesized list of typed arguments.
+ParseResult parseRegionWithArguments(OpAsmParser &parser, Region &region) {
+  SmallVector<OpAsmParser::OperandType, 4> args;
+  SmallVector<Type, 4> tys;
+  if (succeeded(parser.parseOptionalLParen())) {
+    OpAsmParser::OperandType arg;
+    Type ty;
+    auto result = parser.parseOptionalOperand(arg);
+    if (result.hasValue()) {
+      if (*result || parser.parseColonType(ty))
+        return failure();
+      args.push_back(arg);
+      tys.push_back(ty);
+      while (succeeded(parser.parseOptionalComma())) {
+        if (parser.parseOperand(arg) || parser.parseColonType(ty))
+          return failure();
+        args.push_back(arg);
+        tys.push_back(ty);
+      }
+    }
+    if (parser.parseRParen())
+      return failure();
+  }
+  return parser.parseRegion(region, args, tys);
+}
+
+ParseResult resolveOperands(OpAsmParser &parser,
+                            ArrayRef<OpAsmParser::OperandType> operands,
+                            ArrayRef<Type> types, llvm::SMLoc loc,
+                            OperationState &result) {
+  if (operands.size() != types.size())
+    return parser.emitError(loc) << operands.size()
+        << " operands present, but expected " << types.size();
+  for (auto [operand, type] : llvm::zip(operands, types)) {
+    if (parser.resolveOperand(operand, type, result.operands))
+      return failure();
+  }
+  return success();
+}
+
+} // end anonymous namespace
+
+ParseResult NativeOpFormat::parse(OpAsmParser &parser,
+                                  OperationState &result) const {
+  using OperandList = SmallVector<OpAsmParser::OperandType, 2>;
+  SmallVector<OperandList, 4> operands(numOperands + 1);
+  SmallVector<SmallVector<Type, 2>, 4> types(numOperands + numResults + 2);
+  SmallVector<SmallVector<Block *, 1>, 2> successors(numSuccessors + 1);
+  auto startLoc = parser.getCurrentLocation();
+  auto allOperandsLoc = startLoc;
+
+  for (unsigned pc = 0, e = parseProgram.size(); pc != e; ++pc) {
+    auto &instr = parseProgram[pc];
+    switch (instr.opc) {
+    case ParseOp::Literal:
+      if (parseLiteral(parser, instr.str))
+        return failure();
+      break;
+    case ParseOp::OptionalLiteral:
+      if (failed(parseOptionalLiteral(parser, instr.str)))
+        pc = instr.jump - 1;
+      break;
+    case ParseOp::JumpIfNoOperands:
+      if (operands[instr.idx].empty())
+        pc = instr.jump - 1;
+      break;
+    case ParseOp::Attribute: {
+      Attribute attr;
+      if (parser.parseAttribute(attr, instr.type, instr.str,
+                                result.attributes))
+        return failure();
+      break;
+    }
+    case ParseOp::Symbol: {
+      StringAttr attr;
+      if (parser.parseSymbolName(attr, instr.str, result.attributes))
+        return failure();
+      break;
+    }
+    case ParseOp::Operand: {
+      OpAsmParser::OperandType operand;
+      if (parser.parseOperand(operand))
+        return failure();
+      operands[instr.idx].assign(1, operand);
+      break;
+    }
+    case ParseOp::OperandList:
+      if (instr.idx == getAllOperandsList())
+        allOperandsLoc = parser.getCurrentLocation();
+      if (parser.parseOperandList(operands[instr.idx]))
+        return failure();
+      break;
+    case ParseOp::Successor: {
+      Block *succ;
+      if (parser.parseSuccessor(succ))
+        return failure();
+      successors[instr.idx].assign(1, succ);
+      break;
+    }
+    case ParseOp::SuccessorList: {
+      Block *succ;
+      auto tristate = parser.parseOptionalSuccessor(succ);
+      if (!tristate.hasValue())
+        break;
+      if (failed(*tristate))
+        return failure();
+      successors[instr.idx].push_back(succ);
+      while (succeeded(parser.parseOptionalComma())) {
+        if (parser.parseSuccessor(succ))
+          return failure();
+        successors[instr.idx].push_back(succ);
+      }
+      break;
+    }
+    case ParseOp::Region:
+      if (parseRegionWithArguments(parser, *result.addRegion()))
+        return failure();
+      break;
+    case ParseOp::AttrDict:
+      if (parser.parseOptionalAttrDict(result.attributes))
+        return failure();
+      break;
+    case ParseOp::AttrDictWithKeyword:
+      if (parser.parseOptionalAttrDictWithKeyword(result.attributes))
+        return failure();
+      break;
+    case ParseOp::Type: {
+      Type type;
+      if (parser.parseType(type))
+        return failure();
+      types[instr.idx].assign(1, type);
+      break;
+    }
+    case ParseOp::TypeList:
+      if (parser.parseTypeList(types[instr.idx]))
+        return failure();
+      break;
+    case ParseOp::FunctionalType: {
+      FunctionType funcType;
+      if (parser.parseType(funcType))
+        return failure();
+      types[instr.idx].assign(funcType.getInputs().begin(),
+                              funcType.getInputs().end());
+      types[instr.aux].assign(funcType.getResults().begin(),
+                              funcType.getResults().end());
+      break;
+    }
+    }
+  }
+
+  /// Resolve the result types.
+  if (allResultTypes) {
+    result.addTypes(types[getAllResultTypesList()]);
+  } else {
+    for (auto &resolver : resultTypes) {
+      if (resolver.kind == TypeResolver::Builder)
+        result.addTypes(resolver.type);
+      else
+        result.addTypes(types[resolver.list]);
+    }
+  }
+
+  /// Resolve the operand types.
+  auto &allOperandsList = operands[getAllOperandsList()];
+  if (numOperands == 0) {
+    /// Nothing to resolve.
+  } else if (allOperandTypes) {
+    auto &allTypes = types[getAllOperandTypesList()];
+    if (allOperands) {
+      if (resolveOperands(parser, allOperandsList, allTypes, allOperandsLoc,
+                          result))
+        return failure();
+    } else {
+      OperandList operandsToResolve;
+      for (unsigned i = 0; i < numOperands; ++i)
+        operandsToResolve.append(operands[i].begin(), operands[i].end());
+      if (resolveOperands(parser, operandsToResolve, allTypes,
+                          parser.getNameLoc(), result))
+        return failure();
+    }
+  } else if (allOperands) {
+    SmallVector<Type, 4> typesToResolve;
+    for (auto &resolver : operandTypes) {
+      if (resolver.kind == TypeResolver::Builder)
+        typesToResolve.push_back(resolver.type);
+      else
+        typesToResolve.append(types[resolver.list].begin(),
+                              types[resolver.list].end());
+    }
+    if (resolveOperands(parser, allOperandsList, typesToResolve,
+                        allOperandsLoc, result))
+      return failure();
+  } else {
+    for (unsigned i = 0; i < numOperands; ++i) {
+      auto &resolver = operandTypes[i];
+      /// A buildable type resolves every operand in the group.
+      if (resolver.kind == TypeResolver::Builder) {
+        if (parser.resolveOperands(operands[i], resolver.type,
+                                   result.operands))
+          return failure();
+      } else if (resolveOperands(parser, operands[i], types[resolver.list],
+                                 startLoc, result)) {
+        return failure();
+      }
+    }
+  }
+
+  /// Resolve the successors.
+  if (allSuccessors) {
+    auto &succs = successors[getAllSuccessorsList()];
+    result.successors.append(succs.begin(), succs.end());
+  } else {
+    for (unsigned i = 0; i < numSuccessors; ++i)
+      result.successors.append(successors[i].begin(), successors[i].end());
+  }
+
+  /// Add the operand segment sizes.
+  if (!allOperands && sizedOperandSegments) {
+    SmallVector<int32_t, 4> sizes;
+    for (unsigned i = 0; i < numOperands; ++i)
+      sizes.push_back(variadicOperands[i] ? operands[i].size() : 1);
+    result.addAttribute("operand_segment_sizes",
+                        parser.getBuilder().getI32VectorAttr(sizes));
+  }
+  return success();
+}
+
+namespace {
+
+/// Get the successors of a successor group. There is at most one variadic
+/// successor group, which takes the remaining successors.
+SuccessorRange getSuccessorGroup(Operation *op, ArrayRef<bool> variadic,
+                                 unsigned idx) {
+  unsigned numVariadic = llvm::count(variadic, true);
+  unsigned variadicSize = op->getNumSuccessors() -
+      (variadic.size() - numVariadic);
+  unsigned start = 0;
+  for (unsigned i = 0; i < idx; ++i)
+    start += variadic[i] ? variadicSize : 1;
+  return op->getSuccessors().slice(start, variadic[idx] ? variadicSize : 1);
+}
+
+ValueRange getValues(Operation *op, DynamicOperation *spec,
+                     const NativeOpFormat::ValueRef &ref) {
+  switch (ref.kind) {
+  case NativeOpFormat::ValueKind::Operand:
+    return spec->getOperandGroup(op, ref.idx);
+  case NativeOpFormat::ValueKind::Result:
+    return spec->getResultGroup(op, ref.idx);
+  case NativeOpFormat::ValueKind::AllOperands:
+    return op->getOperands();
+  case NativeOpFormat::ValueKind::AllResults:
+    return op->getResults();
+  }
+  llvm_unreachable("Unknown value kind");
+}
+
+void printSuccessors(OpAsmPrinter &printer, SuccessorRange succs) {
+  llvm::interleaveComma(succs, printer, [&](Block *succ)
+                        { printer.printSuccessor(succ); });
+}
+
+} // end anonymous namespace
+
+void NativeOpFormat::print(OpAsmPrinter &printer, Operation *op,
+                           DynamicOperation *spec) const {
+  for (unsigned pc = 0, e = printProgram.size(); pc != e; ++pc) {
+    auto &instr = printProgram[pc];
+    switch (instr.opc) {
+    case PrintOp::Space:
+      printer << " ";
+      break;
+    case PrintOp::Literal:
+      printer << instr.str;
+      break;
+    case PrintOp::OpName:
+      printer << op->getName().getStringRef();
+      break;
+    case PrintOp::AttrDict:
+      printer.printOptionalAttrDict(op->getAttrs(), instr.elided);
+      break;
+    case PrintOp::AttrDictWithKeyword:
+      printer.printOptionalAttrDictWithKeyword(op->getAttrs(), instr.elided);
+      break;
+    case PrintOp::Attribute:
+      printer.printAttribute(op->getAttr(instr.str));
+      break;
+    case PrintOp::AttributeWithoutType:
+      printer.printAttributeWithoutType(op->getAttr(instr.str));
+      break;
+    case PrintOp::Symbol:
+      printer.printSymbolName(
+          op->getAttr(instr.str).cast<StringAttr>().getValue());
+      break;
+    case PrintOp::Operands:
+      printer.printOperands(getValues(op, spec, instr.values[0]));
+      break;
+    case PrintOp::Successors:
+      printSuccessors(printer,
+                      getSuccessorGroup(op, variadicSuccessors, instr.idx));
+      break;
+    case PrintOp::AllSuccessors:
+      printSuccessors(printer, op->getSuccessors());
+      break;
+    case PrintOp::Region: {
+      auto &region = op->getRegion(instr.idx);
+      if (!region.empty()) {
+        printer << "(";
+        llvm::interleaveComma(region.front().getArguments(), printer,
+                              [&](Value val) {
+          printer << val << ": " << val.getType();
+        });
+        printer << ")";
+      }
+      printer.printRegion(region, /*printEntryBlockArgs=*/false);
+      break;
+    }
+    case PrintOp::Types:
+      llvm::interleaveComma(getValues(op, spec, instr.values[0]).getTypes(),
+                            printer, [&](Type type)
+                            { printer.printType(type); });
+      break;
+    case PrintOp::FunctionalType: {
+      SmallVector<Type, 4> inputs, results;
+      for (auto type : getValues(op, spec, instr.values[0]).getTypes())
+        inputs.push_back(type);
+      for (auto type : getValues(op, spec, instr.values[1]).getTypes())
+        results.push_back(type);
+      printer.printFunctionalType(inputs, results);
+      break;
+    }
+    case PrintOp::JumpIfNoOperands:
+      if (spec->getOperandGroup(op, instr.idx).empty())
+        pc = instr.jump - 1;
+      break;
+    case PrintOp::JumpIfNoAttr:
+      if (!op->getAttr(instr.str))
+        pc = instr.jump - 1;
+      break;
+    }
+  }
+}
+
+} // end namespace py
+} // end namespace dmc
@@ -0,0 +1,56 @@
+#include "NativeFormatUtils.h"
+#include "dmc/Embed/NativeTypeFormat.h"
+#include "dmc/Python/DialectAsm.h"
+
+#include <mlir/IR/Builders.h>
+
+using namespace mlir;
+
+namespace dmc {
+namespace py {
+
+ParseResult NativeTypeFormat::parse(DialectAsmParser &parser,
+                                    std::vector<Attribute> &params) const {
+  params.assign(numParams, Attribute{});
+  for (auto &instr : program) {
+    switch (instr.opc) {
+    case Op::Literal:
+      if (parseLiteral(parser, instr.str))
+        return failure();
+      break;
+    case Op::Parameter:
+      if (parser.parseAttribute(params[instr.idx]))
+        return failure();
+      break;
+    case Op::Dims: {
+      SmallVector<int64_t, 4> dims;
+      if (parser.parseDimensionList(dims, /*allowDynamic=*/true))
+        return failure();
+      params[instr.idx] = parser.getBuilder().getI64ArrayAttr(dims);
+      break;
+    }
+    }
+  }
+  return success();
+}
+
+void NativeTypeFormat::print(DialectAsmPrinter &printer,
+                             ArrayRef<Attribute> params) const {
+  printer << name;
+  for (auto &instr : program) {
+    switch (instr.opc) {
+    case Op::Literal:
+      printer << instr.str;
+      break;
+    case Op::Parameter:
+      printer.printAttribute(params[instr.idx]);
+      break;
+    case Op::Dims:
+      printDimensionListOrRaw(printer, params[instr.idx]);
+      break;
+    }
+  }
+}
+
+} // end namespace py
+} // end namespace dmc
@@ -7,6 +7,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "FormatUtils.h"
+#include "Scope.h"
+#include "dmc/Embed/NativeOpFormat.h"
 #include "dmc/Embed/PythonGen.h"
 #include "dmc/Spec/SpecOps.h"
 #include "dmc/Spec/SpecAttrs.h"
@@ -29,6 +31,8 @@
 #include "llvm/TableGen/Error.h"
 #include "llvm/TableGen/Record.h"
 
+#include <pybind11/eval.h>
+
 #define DEBUG_TYPE "mlir-tblgen-opformatgen"
 
 using namespace mlir;
@@ -258,6 +262,11 @@ struct OperationFormat {
   /// Generate the operation printer from this format.
   void genPrinter(OperationOp op, PythonGenStream &body);
 
+  /// Lower this format to a native parser and printer program. Fails if the
+  /// format uses features the native backend does not support.
+  LogicalResult genNativeParser(OperationOp op, NativeOpFormat &program);
+  void genNativePrinter(OperationOp op, NativeOpFormat &program);
+
   /// The various elements in this format.
   std::vector<std::unique_ptr<Element>> elements;
 
@@ -506,6 +515,7 @@ static void genElementParser(Element *element, PythonGenStream &body,
       body.line() << "if parser.parse"
           << getParserForLiteral(literal->getLiteral(), true) << ":" << incr;
     } else if (auto *opVar = dyn_cast<OperandVariable>(&*elements.begin())) {
+      genElementParser(opVar, body, attrTypeCtx);
       body.line() << "if len(" << opVar->getVar()->name << "Operands) > 0:"
           << incr;
     }
@@ -1029,6 +1039,360 @@ void OperationFormat::genPrinter(OperationOp op, PythonGenStream &body) {
                       lastWasPunctuation);
 }
 
+//===----------------------------------------------------------------------===//
+// NativeGen
+
+/// Evaluate a Python type builder once, when the format is compiled. The
+/// builder sees a `parser` whose `getBuilder()` is available, but builders
+/// that use anything else of the parser cannot be evaluated ahead of time. The
+/// op then falls back to the Python format, and a remark says why.
+static Type evalTypeBuilder(StringRef builder, FmtContext &ctx,
+                            OperationOp op) {
+  auto expr = tgfmt(builder, &ctx).str();
+  try {
+    auto namespaceCls = pybind11::module::import("types")
+        .attr("SimpleNamespace");
+    pybind11::dict locals;
+    locals["parser"] = namespaceCls(
+        pybind11::arg("getBuilder") = getInternalScope()["Builder"]);
+    return pybind11::eval(expr, getInternalScope(), locals).cast<Type>();
+  } catch (const std::exception &e) {
+    op.emitRemark("type builder `") << expr << "` cannot be evaluated "
+        "ahead of time, using the Python format: " << e.what();
+    return {};
+  }
+}
+
+/// Get the type list of a type directive operand.
+static unsigned getNativeTypeList(Element *arg, OpType opTy,
+                                  NativeOpFormat &program,
+                                  ArgumentLengthKind &lengthKind) {
+  if (auto *operand = dyn_cast<OperandVariable>(arg)) {
+    lengthKind = getArgumentLengthKind(operand->getVar());
+    return operand->getVar() - opTy.operand_begin();
+  }
+  if (auto *result = dyn_cast<ResultVariable>(arg)) {
+    lengthKind = getArgumentLengthKind(result->getVar());
+    return program.numOperands + (result->getVar() - opTy.result_begin());
+  }
+  lengthKind = ArgumentLengthKind::Variadic;
+  if (isa<OperandsDirective>(arg))
+    return program.getAllOperandTypesList();
+  if (isa<ResultsDirective>(arg))
+    return program.getAllResultTypesList();
+  llvm_unreachable("unknown 'type' directive argument");
+}
+
+/// Lower a single format element to parser instructions.
+static LogicalResult genNativeElementParser(Element *element, OperationOp op,
+                                            NativeOpFormat &program,
+                                            FmtContext &attrTypeCtx) {
+  using ParseOp = NativeOpFormat::ParseOp;
+  auto opTy = op.getOpType();
+  auto &instrs = program.parseProgram;
+  auto emit = [&](ParseOp opc) -> NativeOpFormat::ParseInstr & {
+    instrs.push_back({opc});
+    return instrs.back();
+  };
+
+  /// Optional Group.
+  if (auto *optional = dyn_cast<OptionalElement>(element)) {
+    auto elements = optional->getElements();
+    unsigned gate;
+    if (auto *literal = dyn_cast<LiteralElement>(&*elements.begin())) {
+      /// There is no optional `=` parser.
+      if (literal->getLiteral() == "=")
+        return failure();
+      gate = instrs.size();
+      emit(ParseOp::OptionalLiteral).str = literal->getLiteral().str();
+    } else {
+      auto *opVar = cast<OperandVariable>(&*elements.begin());
+      if (failed(genNativeElementParser(opVar, op, program, attrTypeCtx)))
+        return failure();
+      gate = instrs.size();
+      emit(ParseOp::JumpIfNoOperands).idx =
+          opVar->getVar() - opTy.operand_begin();
+    }
+    for (auto &childElement : llvm::drop_begin(elements, 1)) {
+      if (failed(genNativeElementParser(&childElement, op, program,
+                                        attrTypeCtx)))
+        return failure();
+    }
+    instrs[gate].jump = instrs.size();
+
+    /// Literals.
+  } else if (auto *literal = dyn_cast<LiteralElement>(element)) {
+    emit(ParseOp::Literal).str = literal->getLiteral().str();
+
+    /// Arguments.
+  } else if (auto *attr = dyn_cast<AttributeVariable>(element)) {
+    const NamedAttribute *var = attr->getVar();
+    if (canFormatEnumAttr(var))
+      return failure();
+    Type type;
+    if (Optional<StringRef> typeBuilder = attr->getTypeBuilder()) {
+      if (!(type = evalTypeBuilder(*typeBuilder, attrTypeCtx, op)))
+        return failure();
+    }
+    auto &instr = emit(ParseOp::Attribute);
+    instr.str = var->first.str();
+    instr.type = type;
+
+    /// Operands
+  } else if (auto *operand = dyn_cast<OperandVariable>(element)) {
+    auto lengthKind = getArgumentLengthKind(operand->getVar());
+    emit(lengthKind == ArgumentLengthKind::Variadic ?
+         ParseOp::OperandList : ParseOp::Operand).idx =
+        operand->getVar() - opTy.operand_begin();
+
+    /// Successors
+  } else if (auto *successor = dyn_cast<SuccessorVariable>(element)) {
+    emit(successor->getVar()->isVariadic() ?
+         ParseOp::SuccessorList : ParseOp::Successor).idx =
+        successor->getVar() - op.getOpSuccessors().getSuccessors().begin();
+
+    /// Regions
+  } else if (auto *region = dyn_cast<RegionVariable>(element)) {
+    emit(ParseOp::Region).idx =
+        region->getVar() - op.getOpRegions().getRegions().begin();
+
+    /// Directives.
+  } else if (auto *attrDict = dyn_cast<AttrDictDirective>(element)) {
+    emit(attrDict->isWithKeyword() ?
+         ParseOp::AttrDictWithKeyword : ParseOp::AttrDict);
+  } else if (isa<OperandsDirective>(element)) {
+    emit(ParseOp::OperandList).idx = program.getAllOperandsList();
+  } else if (isa<SuccessorsDirective>(element)) {
+    emit(ParseOp::SuccessorList).idx = program.getAllSuccessorsList();
+  } else if (auto *dir = dyn_cast<TypeDirective>(element)) {
+    ArgumentLengthKind lengthKind;
+    auto list = getNativeTypeList(dir->getOperand(), opTy, program,
+                                  lengthKind);
+    emit(lengthKind == ArgumentLengthKind::Variadic ?
+         ParseOp::TypeList : ParseOp::Type).idx = list;
+  } else if (auto *dir = dyn_cast<FunctionalTypeDirective>(element)) {
+    ArgumentLengthKind ignored;
+    auto &instr = emit(ParseOp::FunctionalType);
+    instr.idx = getNativeTypeList(dir->getInputs(), opTy, program, ignored);
+    instr.aux = getNativeTypeList(dir->getResults(), opTy, program, ignored);
+  } else if (auto *dir = dyn_cast<SymbolDirective>(element)) {
+    emit(ParseOp::Symbol).str = dir->getAttrName().str();
+  } else {
+    llvm_unreachable("unknown format element");
+  }
+  return success();
+}
+
+LogicalResult OperationFormat::genNativeParser(OperationOp op,
+                                               NativeOpFormat &program) {
+  auto opTy = op.getOpType();
+  auto opSuccs = op.getOpSuccessors().getSuccessors();
+  program.numOperands = opTy.getNumOperands();
+  program.numResults = opTy.getNumResults();
+  program.numSuccessors = opSuccs.size();
+  for (auto &operand : opTy.getOperands())
+    program.variadicOperands.push_back(operand.isVariadic());
+  for (auto &successor : opSuccs)
+    program.variadicSuccessors.push_back(successor.isVariadic());
+  /// Successor groups are only well-defined with one variadic group.
+  if (llvm::count(program.variadicSuccessors, true) > 1)
+    return failure();
+
+  FmtContext attrTypeCtx;
+  attrTypeCtx.withBuilder("parser.getBuilder()");
+  for (auto &element : elements) {
+    if (failed(genNativeElementParser(element.get(), op, program,
+                                      attrTypeCtx)))
+      return failure();
+  }
+
+  /// Resolve the buildable types.
+  FmtContext typeBuilderCtx;
+  typeBuilderCtx.withBuilder("parser.getBuilder()");
+  std::vector<Type> builtTypes(buildableTypes.size());
+  for (auto &it : buildableTypes) {
+    if (!(builtTypes[it.second] = evalTypeBuilder(it.first, typeBuilderCtx,
+                                                  op)))
+      return failure();
+  }
+
+  /// Generate the type resolvers.
+  auto getResolver = [&](TypeResolution &resolution, unsigned ownList)
+      -> Optional<NativeOpFormat::TypeResolver> {
+    if (Optional<int> val = resolution.getBuilderIdx())
+      return NativeOpFormat::TypeResolver{NativeOpFormat::TypeResolver::Builder,
+                                          0, builtTypes[*val]};
+    if (const NamedType *var = resolution.getVariable()) {
+      if (resolution.getVarTransformer())
+        return llvm::None;
+      auto operands = opTy.getOperands();
+      unsigned list = var >= operands.begin() && var < operands.end() ?
+          var - operands.begin() :
+          program.numOperands + (var - opTy.result_begin());
+      return NativeOpFormat::TypeResolver{NativeOpFormat::TypeResolver::List,
+                                          list};
+    }
+    return NativeOpFormat::TypeResolver{NativeOpFormat::TypeResolver::List,
+                                        ownList};
+  };
+  for (unsigned i = 0, e = program.numResults; i != e; ++i) {
+    auto resolver = getResolver(resultTypes[i], program.numOperands + i);
+    if (!resolver)
+      return failure();
+    program.resultTypes.push_back(*resolver);
+  }
+  for (unsigned i = 0, e = program.numOperands; i != e; ++i) {
+    auto resolver = getResolver(operandTypes[i], i);
+    if (!resolver)
+      return failure();
+    program.operandTypes.push_back(*resolver);
+  }
+
+  program.allOperands = allOperands;
+  program.allOperandTypes = allOperandTypes;
+  program.allResultTypes = allResultTypes;
+  program.allSuccessors = llvm::any_of(
+      elements, [](auto &elt) { return isa<SuccessorsDirective>(elt.get()); });
+  program.sizedOperandSegments =
+      static_cast<bool>(op.getTrait<dmc::SizedOperandSegments>());
+  return success();
+}
+
+/// Get the values referred to by a type directive operand.
+static NativeOpFormat::ValueRef getNativeValueRef(Element *arg, OpType opTy) {
+  using ValueKind = NativeOpFormat::ValueKind;
+  if (isa<OperandsDirective>(arg))
+    return {ValueKind::AllOperands};
+  if (isa<ResultsDirective>(arg))
+    return {ValueKind::AllResults};
+  if (auto *operand = dyn_cast<OperandVariable>(arg))
+    return {ValueKind::Operand,
+            static_cast<unsigned>(operand->getVar() - opTy.operand_begin())};
+  auto *result = cast<ResultVariable>(arg);
+  return {ValueKind::Result,
+          static_cast<unsigned>(result->getVar() - opTy.result_begin())};
+}
+
+/// Lower a single format element to printer instructions. The spacing flags
+/// are tracked as in `genElementPrinter`.
+static void genNativeElementPrinter(Element *element, OperationFormat &fmt,
+                                    OperationOp op, NativeOpFormat &program,
+                                    bool &shouldEmitSpace,
+                                    bool &lastWasPunctuation) {
+  using PrintOp = NativeOpFormat::PrintOp;
+  auto opTy = op.getOpType();
+  auto &instrs = program.printProgram;
+  auto emit = [&](PrintOp opc) -> NativeOpFormat::PrintInstr & {
+    instrs.push_back({opc});
+    return instrs.back();
+  };
+
+  if (auto *literal = dyn_cast<LiteralElement>(element)) {
+    StringRef value = literal->getLiteral();
+    auto shouldPrintSpaceBeforeLiteral = [&] {
+      if (value.size() != 1 && value != "->")
+        return true;
+      if (lastWasPunctuation)
+        return !StringRef(">)}],").contains(value.front());
+      return !StringRef("<>(){}[],").contains(value.front());
+    };
+    if (shouldEmitSpace && shouldPrintSpaceBeforeLiteral())
+      emit(PrintOp::Space);
+    emit(PrintOp::Literal).str = value.str();
+    shouldEmitSpace =
+        value.size() != 1 || !StringRef("<({[").contains(value.front());
+    lastWasPunctuation = !(value.front() == '_' || isalpha(value.front()));
+    return;
+  }
+
+  // Emit an optional group.
+  if (auto *optional = dyn_cast<OptionalElement>(element)) {
+    Element *anchor = optional->getAnchor();
+    unsigned gate = instrs.size();
+    if (auto *operand = dyn_cast<OperandVariable>(anchor)) {
+      /// Single operands are always present.
+      if (!operand->getVar()->isVariadic())
+        gate = -1u;
+      else
+        emit(PrintOp::JumpIfNoOperands).idx =
+            operand->getVar() - opTy.operand_begin();
+    } else {
+      emit(PrintOp::JumpIfNoAttr).str =
+          cast<AttributeVariable>(anchor)->getVar()->first.str();
+    }
+    for (Element &childElement : optional->getElements())
+      genNativeElementPrinter(&childElement, fmt, op, program, shouldEmitSpace,
+                              lastWasPunctuation);
+    if (gate != -1u)
+      instrs[gate].jump = instrs.size();
+    return;
+  }
+
+  // Emit the attribute dictionary.
+  if (auto *attrDict = dyn_cast<AttrDictDirective>(element)) {
+    auto &instr = emit(attrDict->isWithKeyword() ?
+                       PrintOp::AttrDictWithKeyword : PrintOp::AttrDict);
+    if (!fmt.allOperands && op.getTrait<dmc::SizedOperandSegments>())
+      instr.elided.push_back("operand_segment_sizes");
+    for (auto &it : fmt.elements) {
+      if (auto *attr = dyn_cast<AttributeVariable>(it.get())) {
+        instr.elided.push_back(attr->getVar()->first.strref());
+      } else if (auto *opt = dyn_cast<OptionalElement>(it.get())) {
+        for (auto &it : opt->getElements()) {
+          if (auto *attr = dyn_cast<AttributeVariable>(&it))
+            instr.elided.push_back(attr->getVar()->first.strref());
+        }
+      } else if (auto *dir = dyn_cast<SymbolDirective>(it.get())) {
+        instr.elided.push_back(dir->getAttr()->first.strref());
+      }
+    }
+    lastWasPunctuation = false;
+    return;
+  }
+
+  if (shouldEmitSpace || !lastWasPunctuation)
+    emit(PrintOp::Space);
+  lastWasPunctuation = false;
+  shouldEmitSpace = true;
+
+  if (auto *attr = dyn_cast<AttributeVariable>(element)) {
+    emit(attr->getTypeBuilder() ?
+         PrintOp::AttributeWithoutType : PrintOp::Attribute).str =
+        attr->getVar()->first.str();
+  } else if (auto *operand = dyn_cast<OperandVariable>(element)) {
+    emit(PrintOp::Operands).values = {getNativeValueRef(operand, opTy)};
+  } else if (auto *successor = dyn_cast<SuccessorVariable>(element)) {
+    emit(PrintOp::Successors).idx =
+        successor->getVar() - op.getOpSuccessors().getSuccessors().begin();
+  } else if (auto *region = dyn_cast<RegionVariable>(element)) {
+    emit(PrintOp::Region).idx =
+        region->getVar() - op.getOpRegions().getRegions().begin();
+  } else if (isa<OperandsDirective>(element)) {
+    emit(PrintOp::Operands).values = {getNativeValueRef(element, opTy)};
+  } else if (isa<SuccessorsDirective>(element)) {
+    emit(PrintOp::AllSuccessors);
+  } else if (auto *dir = dyn_cast<TypeDirective>(element)) {
+    emit(PrintOp::Types).values = {getNativeValueRef(dir->getOperand(), opTy)};
+  } else if (auto *dir = dyn_cast<FunctionalTypeDirective>(element)) {
+    emit(PrintOp::FunctionalType).values = {
+        getNativeValueRef(dir->getInputs(), opTy),
+        getNativeValueRef(dir->getResults(), opTy)};
+  } else if (auto *dir = dyn_cast<SymbolDirective>(element)) {
+    emit(PrintOp::Symbol).str = dir->getAttrName().str();
+  } else {
+    llvm_unreachable("unknown format element");
+  }
+}
+
+void OperationFormat::genNativePrinter(OperationOp op,
+                                       NativeOpFormat &program) {
+  program.printProgram.push_back({NativeOpFormat::PrintOp::OpName});
+  bool shouldEmitSpace = true, lastWasPunctuation = false;
+  for (auto &element : elements)
+    genNativeElementPrinter(element.get(), *this, op, program,
+                            shouldEmitSpace, lastWasPunctuation);
+}
+
 //===----------------------------------------------------------------------===//
 // FormatLexer
 //===----------------------------------------------------------------------===//
@@ -1835,9 +2199,8 @@ LogicalResult FormatParser::parseSymbolDirective(
 // Interface
 //===----------------------------------------------------------------------===//
 
-LogicalResult generateOpFormat(OperationOp op,
-                               PythonGenStream &parserOs,
-                               PythonGenStream &printerOs) {
+/// Parse the assembly format of an op.
+static LogicalResult parseOpFormat(OperationOp op, OperationFormat &format) {
   /// Whether the format string is null-terminated is platform-dependent. We
   /// have to make sure that it is null-terminated.
   auto fmt = op.getAssemblyFormat().getValue().str();
@@ -1845,12 +2208,30 @@ LogicalResult generateOpFormat(OperationOp op,
   mgr.AddNewSourceBuffer(
       llvm::MemoryBuffer::getMemBuffer(fmt.c_str()),
       llvm::SMLoc{});
-  OperationFormat format{op};
   FormatLexer lexer{mgr, op};
-  if (failed(FormatParser(lexer, format, op).parse()))
+  return FormatParser(lexer, format, op).parse();
+}
+
+LogicalResult generateOpFormat(OperationOp op,
+                               PythonGenStream &parserOs,
+                               PythonGenStream &printerOs) {
+  OperationFormat format{op};
+  if (failed(parseOpFormat(op, format)))
     return failure();
 
   format.genParser(op, parserOs);
   format.genPrinter(op, printerOs);
   return success();
 }
+
+std::unique_ptr<NativeOpFormat> compileOpFormat(OperationOp op) {
+  OperationFormat format{op};
+  if (failed(parseOpFormat(op, format)))
+    return nullptr;
+
+  auto program = std::make_unique<NativeOpFormat>();
+  if (failed(format.genNativeParser(op, *program)))
+    return nullptr;
+  format.genNativePrinter(op, *program);
+  return program;
+}
@@ -19,46 +19,79 @@ template <> struct std::is_copy_constructible<OperationState>
 namespace dmc {
 namespace py {
 
-bool execParser(const std::string &name, OpAsmParser &parser,
+PythonFunction::PythonFunction() = default;
+PythonFunction::PythonFunction(PythonFunction &&other) = default;
+
+PythonFunction &PythonFunction::operator=(PythonFunction &&other) {
+  /// Hand the old function to `other`, which releases it under the GIL.
+  fcn.swap(other.fcn);
+  return *this;
+}
+
+PythonFunction::~PythonFunction() {
+  if (!fcn)
+    return;
+  /// The interpreter may already be gone at exit. Drop the reference without
+  /// touching the refcount in that case. Otherwise, the destructor may run on
+  /// a thread that does not hold the GIL.
+  if (!Py_IsInitialized()) {
+    fcn->release();
+    return;
+  }
+  gil_scoped_acquire gil;
+  fcn.reset();
+}
+
+llvm::Optional<PythonFunction>
+PythonFunction::lookup(const std::string &name) {
+  /// Functions resolve builtins through their globals, so ensure they exist
+  /// once here instead of on every call.
+  auto m = getInternalModule();
+  ensureBuiltins(m);
+  auto attr = getattr(m, name.c_str(), none());
+  if (!isinstance<function>(attr))
+    return llvm::None;
+  PythonFunction ret;
+  ret.fcn = std::make_unique<function>(attr.cast<function>());
+  return ret;
+}
+
+bool execParser(const PythonFunction &fcn, OpAsmParser &parser,
                 OperationState &result) {
   constexpr auto parser_policy = return_value_policy::reference;
-  ensureBuiltins(getInternalModule());
-  auto fcn = getInternalScope()[name.c_str()];
-  return fcn.operator()<parser_policy>(parser, result).cast<bool>();
+  gil_scoped_acquire gil;
+  return fcn.get().operator()<parser_policy>(parser, result).cast<bool>();
 }
 
-void execPrinter(const std::string &name, OpAsmPrinter &printer, Operation *op,
-                 DynamicOperation *spec) {
+void execPrinter(const PythonFunction &fcn, OpAsmPrinter &printer,
+                 Operation *op, DynamicOperation *spec) {
   constexpr auto printer_policy = return_value_policy::reference;
-  ensureBuiltins(getInternalModule());
-  auto fcn = getInternalScope()[name.c_str()];
+  gil_scoped_acquire gil;
   OperationWrap wrap{op, spec};
-  fcn.operator()<printer_policy>(printer, &wrap);
+  fcn.get().operator()<printer_policy>(printer, &wrap);
 }
 
-bool execParser(const std::string &name, DialectAsmParser &parser,
+bool execParser(const PythonFunction &fcn, DialectAsmParser &parser,
                 std::vector<Attribute> &result) {
   constexpr auto parser_policy = return_value_policy::reference;
-  ensureBuiltins(getInternalModule());
-  auto fcn = getInternalScope()[name.c_str()];
+  gil_scoped_acquire gil;
   TypeResultWrap wrap{result};
-  return fcn.operator()<parser_policy>(parser, wrap).cast<bool>();
+  return fcn.get().operator()<parser_policy>(parser, wrap).cast<bool>();
 }
 
 template <typename DynamicT>
-void execPrinter(const std::string &name, DialectAsmPrinter &printer,
+void execPrinter(const PythonFunction &fcn, DialectAsmPrinter &printer,
                  DynamicT t) {
   constexpr auto printer_policy = return_value_policy::reference;
-  ensureBuiltins(getInternalModule());
-  auto fcn = getInternalScope()[name.c_str()];
+  gil_scoped_acquire gil;
   TypeWrap wrap{t};
-  fcn.operator()<printer_policy>(printer, &wrap);
+  fcn.get().operator()<printer_policy>(printer, &wrap);
 }
 
-template void execPrinter(const std::string &name, DialectAsmPrinter &printer,
-                          DynamicType type);
-template void execPrinter(const std::string &name, DialectAsmPrinter &printer,
-                          DynamicAttribute attr);
+template void execPrinter(const PythonFunction &fcn,
+                          DialectAsmPrinter &printer, DynamicType type);
+template void execPrinter(const PythonFunction &fcn,
+                          DialectAsmPrinter &printer, DynamicAttribute attr);
 
 } // end namespace py
 } // end namespace dmc
@@ -0,0 +1,571 @@
+#include "dmc/Embed/PatternCompiler.h"
+#include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Spec/SpecAttrImplementation.h"
+#include "dmc/Spec/SpecTypeImplementation.h"
+#include "dmc/Traits/SpecTraits.h"
+
+#include <llvm/ADT/StringMap.h>
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/Parser.h>
+
+#include <cctype>
+
+using namespace mlir;
+using namespace llvm;
+
+namespace dmc {
+namespace py {
+
+namespace detail {
+
+/// An operand of a source DAG.
+struct SourceOperand {
+  enum Kind { Ignore, Capture, Op };
+
+  Kind kind;
+  /// The capture slot and optional type constraint.
+  unsigned slot{};
+  Type constraint{};
+  /// The nested DAG.
+  std::unique_ptr<SourceNode> op{};
+};
+
+/// An attribute of a source DAG. Either it is captured, or it must satisfy
+/// the constraint, or both.
+struct SourceAttr {
+  std::string name;
+  Optional<unsigned> slot;
+  Attribute constraint{};
+};
+
+struct SourceNode {
+  std::string opName;
+  std::vector<SourceOperand> operands;
+  std::vector<SourceAttr> attrs;
+};
+
+/// A captured value or a new op.
+struct ResultValue {
+  unsigned slot{};
+  std::unique_ptr<ResultNode> op{};
+};
+
+/// An attribute of a new op, either captured or a literal.
+struct ResultAttr {
+  std::string name;
+  Optional<unsigned> slot;
+  Attribute value{};
+};
+
+/// A result type of a new op, either a literal or the type of a capture.
+struct ResultType {
+  Type type{};
+  Optional<unsigned> slot;
+  bool isAttr{};
+};
+
+struct ResultNode {
+  std::string opName;
+  std::vector<ResultValue> operands;
+  std::vector<ResultAttr> attrs;
+  std::vector<ResultType> types;
+  /// Whether the result types are those of the replaced op.
+  bool typesFromRoot{};
+};
+
+} // end namespace detail
+
+namespace {
+
+using namespace detail;
+
+/// The values and attributes captured by a match.
+struct MatchState {
+  SmallVector<Value, 4> values;
+  SmallVector<Attribute, 4> attrs;
+};
+
+/// Lookup the dynamic op of a registered op, if it is one.
+DynamicOperation *lookupDynamicOp(const AbstractOperation *opInfo) {
+  if (&opInfo->parseAssembly != &BaseOp::parseAssembly)
+    return nullptr;
+  return DynamicOperation::of(opInfo);
+}
+
+/// Recursive descent parser of source and result DAGs. Types and attributes
+/// are parsed by the MLIR parser, so they may refer to dynamic types and
+/// attributes. Parse functions return false and set the error on failure.
+class PatternParser {
+public:
+  explicit PatternParser(MLIRContext *ctx) : ctx{ctx} {}
+
+  /// source ::= source-dag
+  bool parseSource(StringRef source, std::unique_ptr<SourceNode> &root) {
+    text = source;
+    inSource = true;
+    return parseSourceNode(root) && parseEnd();
+  }
+
+  /// rewrite ::= result-value
+  bool parseRewrite(StringRef rewrite, std::unique_ptr<ResultValue> &root) {
+    text = rewrite;
+    inSource = false;
+    root = std::make_unique<ResultValue>();
+    return parseResultValue(*root, /*isRoot=*/true) && parseEnd();
+  }
+
+  inline StringRef getError() const { return error; }
+  inline unsigned getNumValues() const { return numValues; }
+  inline unsigned getNumAttrs() const { return numAttrs; }
+  inline ArrayRef<std::string> getGeneratedOps() const { return generated; }
+
+private:
+  bool fail(const Twine &msg) {
+    if (error.empty())
+      error = msg.str();
+    return false;
+  }
+
+  bool consumeIf(StringRef tok) {
+    text = text.ltrim();
+    if (!text.startswith(tok))
+      return false;
+    text = text.drop_front(tok.size());
+    return true;
+  }
+
+  bool expect(StringRef tok) {
+    if (consumeIf(tok))
+      return true;
+    return fail("expected '" + tok + "' at '" + text.take_front(16) + "'");
+  }
+
+  bool parseEnd() {
+    if (!text.ltrim().empty())
+      return fail("unexpected '" + text.ltrim().take_front(16) + "'");
+    return true;
+  }
+
+  /// Parse an identifier, which may contain dots.
+  bool parseIdentifier(StringRef &ident) {
+    text = text.ltrim();
+    auto len = std::min(text.size(), text.find_if_not([](char c) {
+      return std::isalnum(c) || c == '_' || c == '.';
+    }));
+    if (!len)
+      return fail("expected an identifier at '" + text.take_front(16) + "'");
+    ident = text.take_front(len);
+    text = text.drop_front(len);
+    return true;
+  }
+
+  bool parseType(Type &type) {
+    text = text.ltrim();
+    size_t numRead{};
+    if (!(type = mlir::parseType(text, ctx, numRead)))
+      return fail("invalid type at '" + text.take_front(16) + "'");
+    text = text.drop_front(numRead);
+    return true;
+  }
+
+  bool parseAttribute(Attribute &attr) {
+    text = text.ltrim();
+    size_t numRead{};
+    if (!(attr = mlir::parseAttribute(text, ctx, numRead)))
+      return fail("invalid attribute at '" + text.take_front(16) + "'");
+    text = text.drop_front(numRead);
+    return true;
+  }
+
+  /// Parse the name of a capture after `$`. In the source, the first use of
+  /// a name defines the capture. In the rewrite, it must be defined.
+  bool parseCapture(bool isAttr, unsigned &slot) {
+    StringRef name;
+    if (!parseIdentifier(name))
+      return false;
+    auto it = captures.find(name);
+    if (it == captures.end()) {
+      if (!inSource)
+        return fail("unknown capture '$" + name + "'");
+      slot = isAttr ? numAttrs++ : numValues++;
+      captures.try_emplace(name, isAttr, slot);
+      return true;
+    }
+    if (it->second.first != isAttr)
+      return fail("capture '$" + name + "' is " +
+                  (isAttr ? "a value" : "an attribute"));
+    slot = it->second.second;
+    return true;
+  }
+
+  /// Get the registered op with a name.
+  bool lookupOp(StringRef name, const AbstractOperation *&opInfo) {
+    if (!(opInfo = AbstractOperation::lookup(name, ctx)))
+      return fail("unknown op '" + name + "'");
+    return true;
+  }
+
+  /// Check the number of operands of a DAG against the op spec.
+  bool checkNumOperands(DynamicOperation *dynOp, StringRef name,
+                        unsigned numOperands) {
+    if (!dynOp)
+      return true;
+    auto opTy = dynOp->getTrait<TypeConstraintTrait>()->getOpType();
+    if (!hasVariadicValues(opTy.getOperandTypes()) &&
+        opTy.getNumOperands() != numOperands)
+      return fail("'" + name + "' expects " + Twine(opTy.getNumOperands()) +
+                  " operands but got " + Twine(numOperands));
+    return true;
+  }
+
+  /// source-dag ::= `(` op-name source-operand* source-attrs? `)`
+  bool parseSourceNode(std::unique_ptr<SourceNode> &node) {
+    node = std::make_unique<SourceNode>();
+    StringRef name;
+    const AbstractOperation *opInfo;
+    if (!expect("(") || !parseIdentifier(name) || !lookupOp(name, opInfo))
+      return false;
+    node->opName = name.str();
+    while (!consumeIf(")")) {
+      if (consumeIf("{")) {
+        if (!parseSourceAttrs(*node) || !expect(")"))
+          return false;
+        break;
+      }
+      node->operands.emplace_back();
+      if (!parseSourceOperand(node->operands.back()))
+        return false;
+    }
+    return checkNumOperands(lookupDynamicOp(opInfo), name,
+                            node->operands.size());
+  }
+
+  /// source-operand ::= `_` | `$`name (`:` type)? | source-dag
+  bool parseSourceOperand(SourceOperand &operand) {
+    if (consumeIf("_")) {
+      operand.kind = SourceOperand::Ignore;
+      return true;
+    }
+    if (consumeIf("$")) {
+      operand.kind = SourceOperand::Capture;
+      return parseCapture(/*isAttr=*/false, operand.slot) &&
+          (!consumeIf(":") || parseType(operand.constraint));
+    }
+    operand.kind = SourceOperand::Op;
+    return parseSourceNode(operand.op);
+  }
+
+  /// source-attrs ::= source-attr (`,` source-attr)* `}`
+  /// source-attr  ::= name `=` (`$`name (`:` attribute)? | attribute)
+  bool parseSourceAttrs(SourceNode &node) {
+    do {
+      StringRef name;
+      node.attrs.emplace_back();
+      auto &attr = node.attrs.back();
+      if (!parseIdentifier(name) || !expect("="))
+        return false;
+      attr.name = name.str();
+      if (consumeIf("$")) {
+        unsigned slot;
+        if (!parseCapture(/*isAttr=*/true, slot) ||
+            (consumeIf(":") && !parseAttribute(attr.constraint)))
+          return false;
+        attr.slot = slot;
+      } else if (!parseAttribute(attr.constraint)) {
+        return false;
+      }
+    } while (consumeIf(","));
+    return expect("}");
+  }
+
+  /// result-value ::= `$`name | result-dag
+  bool parseResultValue(ResultValue &value, bool isRoot) {
+    if (consumeIf("$"))
+      return parseCapture(/*isAttr=*/false, value.slot);
+    return parseResultNode(value.op, isRoot);
+  }
+
+  /// result-dag ::= `(` op-name result-value* result-attrs?
+  ///                (`->` result-type (`,` result-type)*)? `)`
+  bool parseResultNode(std::unique_ptr<ResultNode> &node, bool isRoot) {
+    node = std::make_unique<ResultNode>();
+    StringRef name;
+    const AbstractOperation *opInfo;
+    if (!expect("(") || !parseIdentifier(name) || !lookupOp(name, opInfo))
+      return false;
+    node->opName = name.str();
+    generated.push_back(node->opName);
+
+    bool hasTypes = false;
+    while (!consumeIf(")")) {
+      if (consumeIf("{")) {
+        if (!parseResultAttrs(*node))
+          return false;
+        hasTypes = consumeIf("->") && parseResultTypes(*node);
+        if (!error.empty() || !expect(")"))
+          return false;
+        break;
+      }
+      if (consumeIf("->")) {
+        if (!parseResultTypes(*node) || !expect(")"))
+          return false;
+        hasTypes = true;
+        break;
+      }
+      node->operands.emplace_back();
+      if (!parseResultValue(node->operands.back(), /*isRoot=*/false))
+        return false;
+    }
+
+    auto *dynOp = lookupDynamicOp(opInfo);
+    if (!checkNumOperands(dynOp, name, node->operands.size()))
+      return false;
+    if (dynOp) {
+      auto opTy = dynOp->getTrait<TypeConstraintTrait>()->getOpType();
+      if (hasVariadicValues(opTy.getOperandTypes()))
+        return fail("cannot create '" + name + "' with variadic operands");
+      if (llvm::size(dynOp->getTrait<RegionConstraintTrait>()
+                     ->getOpRegions()))
+        return fail("cannot create '" + name + "' with regions");
+      /// Use the result types of the spec if they are concrete.
+      if (!hasTypes && llvm::none_of(opTy.getResultTypes(), &SpecTypes::is)) {
+        for (auto type : opTy.getResultTypes())
+          node->types.push_back({type});
+        hasTypes = true;
+      }
+    }
+    if (!hasTypes) {
+      if (!isRoot)
+        return fail("cannot infer the result types of '" + name +
+                    "', specify them with '->'");
+      node->typesFromRoot = true;
+    } else if (!isRoot && node->types.size() != 1) {
+      return fail("nested op '" + name + "' must have one result");
+    }
+    return true;
+  }
+
+  /// result-attrs ::= result-attr (`,` result-attr)* `}`
+  /// result-attr  ::= name `=` (`$`name | attribute)
+  bool parseResultAttrs(ResultNode &node) {
+    do {
+      StringRef name;
+      node.attrs.emplace_back();
+      auto &attr = node.attrs.back();
+      if (!parseIdentifier(name) || !expect("="))
+        return false;
+      attr.name = name.str();
+      if (consumeIf("$")) {
+        unsigned slot;
+        if (!parseCapture(/*isAttr=*/true, slot))
+          return false;
+        attr.slot = slot;
+      } else if (!parseAttribute(attr.value)) {
+        return false;
+      }
+    } while (consumeIf(","));
+    return expect("}");
+  }
+
+  /// result-type ::= `$`name | type
+  bool parseResultTypes(ResultNode &node) {
+    do {
+      node.types.emplace_back();
+      auto &type = node.types.back();
+      if (consumeIf("$")) {
+        StringRef name;
+        if (!parseIdentifier(name))
+          return false;
+        auto it = captures.find(name);
+        if (it == captures.end())
+          return fail("unknown capture '$" + name + "'");
+        type.isAttr = it->second.first;
+        type.slot = it->second.second;
+      } else if (!parseType(type.type)) {
+        return false;
+      }
+    } while (consumeIf(","));
+    return true;
+  }
+
+  MLIRContext *ctx;
+  StringRef text;
+  bool inSource{};
+  /// Captures by name: whether it is an attribute, and its slot.
+  StringMap<std::pair<bool, unsigned>> captures;
+  unsigned numValues{}, numAttrs{};
+  std::vector<std::string> generated;
+  std::string error;
+};
+
+/// Match a source DAG against an op and capture its values and attributes.
+bool matchNode(const SourceNode &node, Operation *op, MatchState &state) {
+  if (op->getName().getStringRef() != node.opName ||
+      op->getNumOperands() != node.operands.size())
+    return false;
+  for (auto it : llvm::zip(node.operands, op->getOperands())) {
+    auto &operand = std::get<0>(it);
+    auto value = std::get<1>(it);
+    switch (operand.kind) {
+    case SourceOperand::Ignore:
+      break;
+    case SourceOperand::Capture: {
+      if (operand.constraint &&
+          failed(SpecTypes::delegateVerify(operand.constraint,
+                                           value.getType())))
+        return false;
+      auto &captured = state.values[operand.slot];
+      if (captured && captured != value)
+        return false;
+      captured = value;
+      break;
+    }
+    case SourceOperand::Op: {
+      auto *defOp = value.getDefiningOp();
+      if (!defOp || !matchNode(*operand.op, defOp, state))
+        return false;
+      break;
+    }
+    }
+  }
+  for (auto &attr : node.attrs) {
+    auto value = op->getAttr(attr.name);
+    if (!value || (attr.constraint &&
+                   failed(SpecAttrs::delegateVerify(attr.constraint, value))))
+      return false;
+    if (attr.slot) {
+      auto &captured = state.attrs[*attr.slot];
+      if (captured && captured != value)
+        return false;
+      captured = value;
+    }
+  }
+  return true;
+}
+
+/// Get the result types of a new op.
+void getResultTypes(const ResultNode &node, Operation *root,
+                    const MatchState &state, SmallVectorImpl<Type> &types) {
+  if (node.typesFromRoot) {
+    types.append(root->result_type_begin(), root->result_type_end());
+    return;
+  }
+  for (auto &type : node.types) {
+    if (!type.slot)
+      types.push_back(type.type);
+    else if (type.isAttr)
+      types.push_back(state.attrs[*type.slot].getType());
+    else
+      types.push_back(state.values[*type.slot].getType());
+  }
+}
+
+/// Create the ops of a result DAG, operands first.
+Operation *buildNode(const ResultNode &node, Operation *root,
+                     const MatchState &state, PatternRewriter &rewriter) {
+  OperationState result{root->getLoc(), node.opName};
+  for (auto &operand : node.operands) {
+    if (operand.op)
+      result.addOperands(
+          buildNode(*operand.op, root, state, rewriter)->getResults());
+    else
+      result.addOperands(state.values[operand.slot]);
+  }
+  for (auto &attr : node.attrs)
+    result.addAttribute(attr.name,
+                        attr.slot ? state.attrs[*attr.slot] : attr.value);
+  getResultTypes(node, root, state, result.types);
+  return rewriter.createOperation(result);
+}
+
+/// Applies a native pattern on behalf of the pattern driver.
+class NativePatternImpl : public RewritePattern {
+public:
+  explicit NativePatternImpl(const NativePattern &pattern,
+                             ArrayRef<StringRef> generatedOps,
+                             MLIRContext *ctx)
+      : RewritePattern{pattern.getRootName(), generatedOps,
+                       pattern.getBenefit(), ctx},
+        pattern{pattern} {}
+
+  LogicalResult matchAndRewrite(Operation *op,
+                                PatternRewriter &rewriter) const override {
+    return pattern.matchAndRewrite(op, rewriter);
+  }
+
+private:
+  const NativePattern &pattern;
+};
+
+} // end anonymous namespace
+
+NativePattern::NativePattern() = default;
+NativePattern::~NativePattern() = default;
+
+std::unique_ptr<NativePattern> NativePattern::compile(Location loc,
+                                                      StringRef name,
+                                                      StringRef source,
+                                                      StringRef rewrite,
+                                                      unsigned benefit) {
+  PatternParser parser{loc.getContext()};
+  std::unique_ptr<NativePattern> pattern{new NativePattern};
+  if (!parser.parseSource(source, pattern->source)) {
+    emitError(loc) << "invalid source of pattern '" << name << "': "
+                   << parser.getError();
+    return nullptr;
+  }
+  if (!parser.parseRewrite(rewrite, pattern->rewrite)) {
+    emitError(loc) << "invalid rewrite of pattern '" << name << "': "
+                   << parser.getError();
+    return nullptr;
+  }
+  pattern->name = name.str();
+  pattern->benefit = benefit;
+  pattern->numValues = parser.getNumValues();
+  pattern->numAttrs = parser.getNumAttrs();
+  pattern->generatedOps = parser.getGeneratedOps();
+  return pattern;
+}
+
+StringRef NativePattern::getRootName() const {
+  return source->opName;
+}
+
+LogicalResult
+NativePattern::matchAndRewrite(Operation *op,
+                               PatternRewriter &rewriter) const {
+  MatchState state;
+  state.values.resize(numValues);
+  state.attrs.resize(numAttrs);
+  if (!matchNode(*source, op, state))
+    return failure();
+
+  /// Check that the replacement values match the replaced results before
+  /// creating any ops.
+  if (!rewrite->op) {
+    auto value = state.values[rewrite->slot];
+    if (op->getNumResults() != 1 ||
+        op->getResult(0).getType() != value.getType())
+      return failure();
+    rewriter.replaceOp(op, value);
+    return success();
+  }
+  SmallVector<Type, 2> types;
+  getResultTypes(*rewrite->op, op, state, types);
+  if (!std::equal(types.begin(), types.end(), op->result_type_begin(),
+                  op->result_type_end()))
+    return failure();
+  rewriter.replaceOp(op, buildNode(*rewrite->op, op, state, rewriter)
+                     ->getResults());
+  return success();
+}
+
+void NativePattern::addTo(OwningRewritePatternList &patterns,
+                          MLIRContext *ctx) const {
+  SmallVector<StringRef, 4> generatedNames{generatedOps.begin(),
+                                           generatedOps.end()};
+  patterns.insert<NativePatternImpl>(*this, generatedNames, ctx);
+}
+
+} // end namespace py
+} // end namespace dmc
@@ -17,8 +17,9 @@ struct PyConstraintStorage {
   static llvm::hash_code hashKey(KeyTy key) { return hash_value(key); }
 
   StringRef expr;
-  /// Not part of the key, but store the function name. Initialize to empty.
-  std::string funcName{};
+  /// Not part of the key, but store the registered constraint. Initialize to
+  /// empty.
+  py::Constraint constraint{};
 };
 
 struct PyTypeStorage : public PyConstraintStorage, public TypeStorage {
@@ -44,16 +45,17 @@ struct PyAttrStorage : public PyConstraintStorage, public AttributeStorage {
 /// PyType implementation.
 PyType PyType::getChecked(Location loc, StringRef expr) {
   auto ret = Base::get(loc.getContext(), Kind, expr);
-  auto &funcName = ret.getImpl()->funcName;
-  if (funcName.empty()) {
-    if (failed(py::registerConstraint(loc, expr, funcName)))
-      return {};
-  }
+  if (failed(py::registerConstraint(loc, expr, ret.getImpl()->constraint)))
+    return {};
   return ret;
 }
 
 LogicalResult PyType::verify(Type ty) {
-  return py::evalConstraint(getImpl()->funcName, ty);
+  return py::evalConstraint(getImpl()->constraint, ty);
+}
+
+bool PyType::isNative() {
+  return getImpl()->constraint.native;
 }
 
 void PyType::print(DialectAsmPrinter &printer) {
@@ -63,16 +65,17 @@ void PyType::print(DialectAsmPrinter &printer) {
 /// PyAttr implementation.
 PyAttr PyAttr::getChecked(Location loc, StringRef expr) {
   auto ret = Base::get(loc.getContext(), Kind, expr);
-  auto &funcName = ret.getImpl()->funcName;
-  if (funcName.empty()) {
-    if (failed(py::registerConstraint(loc, expr, funcName)))
-      return {};
-  }
+  if (failed(py::registerConstraint(loc, expr, ret.getImpl()->constraint)))
+    return {};
   return ret;
 }
 
 LogicalResult PyAttr::verify(Attribute attr) {
-  return py::evalConstraint(getImpl()->funcName, attr);
+  return py::evalConstraint(getImpl()->constraint, attr);
+}
+
+bool PyAttr::isNative() {
+  return getImpl()->constraint.native;
 }
 
 void PyAttr::print(DialectAsmPrinter &printer) {
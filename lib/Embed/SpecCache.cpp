@@ -0,0 +1,152 @@
+#include "Scope.h"
+#include "dmc/Embed/SpecCache.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringExtras.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
+#include <pybind11/pybind11.h>
+
+#include <cstdlib>
+
+/// Defines DMC_BUILD_ID, the hash of the code generators, since the cached
+/// code depends on them.
+#include "SpecCacheBuildId.h"
+
+using namespace llvm;
+using namespace pybind11;
+
+namespace dmc {
+namespace py {
+
+class SpecCache::Impl {
+public:
+  /// The path of the entry, or empty if the cache is disabled.
+  SmallString<128> path;
+  bool warm{false};
+  /// The compiled sections of a warm entry.
+  dict sections;
+  /// The sources of a cold entry.
+  StringMap<std::string> sources;
+};
+
+/// Get the cache directory, or an empty path if the cache is disabled.
+static SmallString<128> getCacheDir() {
+  SmallString<128> dir;
+  auto *mode = std::getenv("DMC_SPEC_CACHE");
+  if (mode && StringRef{mode} == "off")
+    return dir;
+  if (auto *path = std::getenv("DMC_SPEC_CACHE_DIR")) {
+    dir = path;
+  } else if (sys::path::cache_directory(dir)) {
+    sys::path::append(dir, "dmc");
+  } else {
+    dir.clear();
+  }
+  return dir;
+}
+
+SpecCache::SpecCache(StringRef dialectName, uint64_t specHash)
+    : impl{std::make_unique<Impl>()} {
+  auto dir = getCacheDir();
+  if (dir.empty())
+    return;
+
+  std::string key;
+  raw_string_ostream os{key};
+  os << DMC_BUILD_ID << ":" << format_hex_no_prefix(specHash, 16);
+  impl->path = dir;
+  sys::path::append(impl->path, dialectName + "-" +
+                    utohexstr(xxHash64(os.str())) + ".dmcc");
+
+  auto file = MemoryBuffer::getFile(impl->path, /*FileSize=*/-1,
+                                    /*RequiresNullTerminator=*/false);
+  if (!file)
+    return;
+  /// An entry that cannot be read is regenerated.
+  try {
+    auto entry = module::import("marshal").attr("loads")(
+        bytes((*file)->getBufferStart(), (*file)->getBufferSize()))
+        .cast<dict>();
+    /// Code objects are specific to the Python version.
+    if (!entry.contains("python") ||
+        entry["python"].cast<unsigned long>() != PY_VERSION_HEX)
+      return;
+    impl->sections = entry["sections"].cast<dict>();
+    impl->warm = true;
+  } catch (const std::exception &) {
+  }
+}
+
+SpecCache::~SpecCache() = default;
+
+bool SpecCache::isWarm() {
+  return impl->warm;
+}
+
+void SpecCache::execDefs(StringRef section) {
+  auto name = str(section.str());
+  if (impl->sections.contains(name))
+    module::import("builtins").attr("exec")(impl->sections[name],
+                                            getInternalScope());
+}
+
+void SpecCache::execIn(StringRef section, module &m) {
+  auto name = str(section.str());
+  if (impl->sections.contains(name))
+    module::import("builtins").attr("exec")(impl->sections[name],
+                                            m.attr("__dict__"));
+}
+
+void SpecCache::addSource(StringRef section, StringRef source) {
+  impl->sources[section] += source;
+}
+
+void SpecCache::save() {
+  if (impl->warm || impl->path.empty())
+    return;
+
+  std::string data;
+  try {
+    auto compile = module::import("builtins").attr("compile");
+    dict sections;
+    for (auto &it : impl->sources) {
+      auto filename = ("<dmc:" + it.getKey() + ">").str();
+      sections[str(it.getKey().str())] = compile(it.second, filename, "exec");
+    }
+    dict entry;
+    entry["python"] = PY_VERSION_HEX;
+    entry["sections"] = sections;
+    data = module::import("marshal").attr("dumps")(entry).cast<std::string>();
+  } catch (const std::exception &) {
+    return;
+  }
+
+  /// Write to a temporary file first so that other processes never read a
+  /// partial entry.
+  if (sys::fs::create_directories(sys::path::parent_path(impl->path)))
+    return;
+  int fd;
+  SmallString<128> tmpPath;
+  if (sys::fs::createUniqueFile(Twine{impl->path} + ".%%%%%%.tmp", fd,
+                                tmpPath))
+    return;
+  bool ok;
+  {
+    raw_fd_ostream os{fd, /*shouldClose=*/true};
+    os << data;
+    os.close();
+    ok = !os.has_error();
+    os.clear_error();
+  }
+  if (!ok || sys::fs::rename(tmpPath, impl->path))
+    sys::fs::remove(tmpPath);
+}
+
+} // end namespace py
+} // end namespace dmc
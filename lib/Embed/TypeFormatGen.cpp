@@ -1,4 +1,5 @@
 #include "FormatUtils.h"
+#include "dmc/Embed/NativeTypeFormat.h"
 #include "dmc/Embed/PythonGen.h"
 #include "dmc/Spec/ParameterList.h"
 #include "dmc/Spec/SpecOps.h"
@@ -15,6 +16,7 @@ using mlir::NamedParameter;
 using mlir::NamedParameterRange;
 using mlir::FormatOp;
 using dmc::py::PythonGenStream;
+using dmc::py::NativeTypeFormat;
 
 namespace {
 class Parameters : public std::vector<NamedParameter> {
@@ -285,12 +287,50 @@ void ParserGen::genDimsDirectiveParser(DimsDirective *el) {
   s.line() << el->getVar()->getName() << "Param = ArrayAttr(dimAttrs)";
 }
 
-} // end anonymous namespace
+/// Lower a format to a native program, one instruction per element.
+class NativeGen {
+public:
+  explicit NativeGen(Parameters &params, NativeTypeFormat &program)
+      : params{params}, program{program} {}
 
-template <typename OpT, typename DynamicT>
-LogicalResult generateTypeFormat(OpT op, DynamicT *impl,
-                                 PythonGenStream &parserOs,
-                                 PythonGenStream &printerOs) {
+  void genProgram(const std::vector<std::unique_ptr<Element>> &elements);
+
+private:
+  unsigned getParamIdx(const NamedParameter *param) {
+    return param - params.data();
+  }
+
+  Parameters &params;
+  NativeTypeFormat &program;
+};
+
+void NativeGen::genProgram(
+    const std::vector<std::unique_ptr<Element>> &elements) {
+  for (auto &element : elements) {
+    auto *el = element.get();
+    switch (el->getKind()) {
+    case Kind::Literal:
+      program.push_back({NativeTypeFormat::Op::Literal, 0,
+                         cast<LiteralElement>(el)->getLiteral().str()});
+      break;
+    case FormatElement::ParameterVariable:
+      program.push_back({NativeTypeFormat::Op::Parameter,
+                         getParamIdx(cast<ParameterVariable>(el)->getVar())});
+      break;
+    case FormatElement::DimsDirective:
+      program.push_back({NativeTypeFormat::Op::Dims,
+                         getParamIdx(cast<DimsDirective>(el)->getVar())});
+      break;
+    default:
+      llvm_unreachable("unknown element kind");
+    }
+  }
+}
+
+/// Parse the format of a type or attribute.
+template <typename OpT>
+LogicalResult parseTypeFormat(OpT op, Parameters &parameters,
+                              std::vector<std::unique_ptr<Element>> &elements) {
   /// Ensure that the string is null-terminated. Ensure it is kept on the stack.
   auto fmtStr = op.getAssemblyFormat().getValue().str();
   SourceMgr mgr;
@@ -299,10 +339,19 @@ LogicalResult generateTypeFormat(OpT op, DynamicT *impl,
 
   /// Parse the format.
   Lexer lexer{mgr, op};
-  Parameters parameters{impl->getParamSpec()};
   FormatParser parser{lexer, parameters};
+  return parser.parse(elements);
+}
+
+} // end anonymous namespace
+
+template <typename OpT, typename DynamicT>
+LogicalResult generateTypeFormat(OpT op, DynamicT *impl,
+                                 PythonGenStream &parserOs,
+                                 PythonGenStream &printerOs) {
+  Parameters parameters{impl->getParamSpec()};
   std::vector<std::unique_ptr<Element>> elements;
-  if (failed(parser.parse(elements)))
+  if (failed(parseTypeFormat(op, parameters, elements)))
     return failure();
 
   PrinterGen printerGen{printerOs};
@@ -320,3 +369,21 @@ template LogicalResult generateTypeFormat(
 template LogicalResult generateTypeFormat(
     dmc::AttributeOp typeOp, dmc::DynamicAttributeImpl *impl,
     PythonGenStream &parserOs, PythonGenStream &printerOs);
+
+template <typename OpT, typename DynamicT>
+std::unique_ptr<NativeTypeFormat> compileTypeFormat(OpT op, DynamicT *impl) {
+  Parameters parameters{impl->getParamSpec()};
+  std::vector<std::unique_ptr<Element>> elements;
+  if (failed(parseTypeFormat(op, parameters, elements)))
+    return nullptr;
+
+  auto program = std::make_unique<NativeTypeFormat>(op.getName(),
+                                                    parameters.size());
+  NativeGen{parameters, *program}.genProgram(elements);
+  return program;
+}
+
+template std::unique_ptr<NativeTypeFormat> compileTypeFormat(
+    dmc::TypeOp typeOp, dmc::DynamicTypeImpl *impl);
+template std::unique_ptr<NativeTypeFormat> compileTypeFormat(
+    dmc::AttributeOp attrOp, dmc::DynamicAttributeImpl *impl);
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+namespace dmc {
+namespace bytecode {
+
+/// The kinds of entries in the type and attribute table.
+enum class EntryKind : uint8_t {
+  /// A type or attribute printed as text.
+  TypeText,
+  AttrText,
+
+  /// Dynamic types and attributes: dialect, name, and parameters.
+  DynamicType,
+  DynamicAttr,
+
+  /// Builtin types and attributes that may contain dynamic ones.
+  FunctionType,
+  TupleType,
+  RankedTensorType,
+  UnrankedTensorType,
+  ArrayAttr,
+  DictionaryAttr,
+  TypeAttr,
+
+  /// Common builtin attributes, which are cheaper to read than text.
+  StringAttr,
+  IntegerAttr,
+  FloatAttr,
+  BoolAttr,
+  UnitAttr,
+  SymbolRefAttr,
+
+  /// Locations.
+  UnknownLoc,
+  FileLineColLoc,
+  NameLoc,
+  CallSiteLoc,
+  FusedLoc,
+
+  LastKind = FusedLoc,
+};
+
+} // end namespace bytecode
+} // end namespace dmc
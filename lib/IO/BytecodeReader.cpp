@@ -0,0 +1,878 @@
+#include "BytecodeKinds.h"
+#include "dmc/IO/Bytecode.h"
+#include "dmc/Dynamic/DynamicContext.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicType.h"
+#include "dmc/Dynamic/DynamicAttribute.h"
+
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/StandardTypes.h>
+#include <mlir/IR/SymbolTable.h>
+#include <mlir/IR/Verifier.h>
+#include <mlir/Parser.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/Endian.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/MemoryBuffer.h>
+
+using namespace mlir;
+using namespace dmc::bytecode;
+
+namespace dmc {
+
+namespace {
+class BytecodeReader {
+public:
+  BytecodeReader(StringRef data, DynamicContext *dynCtx, bool lazy = false)
+      : data{data},
+        dynCtx{dynCtx},
+        ctx{dynCtx->getContext()},
+        unknownLoc{UnknownLoc::get(ctx)},
+        lazy{lazy} {}
+
+  /// Read the module. If the reader is lazy, chunks are skipped and the
+  /// module is not verified.
+  OwningModuleRef read();
+
+  /// Read a skipped chunk into the regions of its op.
+  LogicalResult materialize(Operation *op);
+  /// Get the number of chunks that were skipped.
+  unsigned getNumPending() { return pendingChunks.size(); }
+  bool isPending(Operation *op) { return pendingChunks.count(op); }
+
+private:
+  /// Primitive reads. Each returns failure and emits an error if the data is
+  /// malformed.
+  LogicalResult readVarint(uint64_t &value);
+  LogicalResult readVarint(unsigned &value);
+  LogicalResult readSigned(int64_t &value);
+  LogicalResult readFixed64(uint64_t &value);
+  LogicalResult readBytes(size_t size, StringRef &bytes);
+  LogicalResult readString(StringRef &str);
+  LogicalResult readType(Type &type);
+  LogicalResult readAttr(Attribute &attr);
+  template <typename T> LogicalResult readAttr(T &attr);
+  template <typename T, typename ReadFn>
+  LogicalResult readList(SmallVectorImpl<T> &list, ReadFn readFn);
+
+  /// Section reads.
+  LogicalResult readHeader();
+  LogicalResult readStrings();
+  LogicalResult readDialects();
+  LogicalResult readEntries();
+  LogicalResult readEntryAt(unsigned idx);
+  LogicalResult readEntry(Type &type, Attribute &attr);
+  LogicalResult readDynamicSymbol(DynamicDialect *&dialect, StringRef &name,
+                                  SmallVectorImpl<Attribute> &params);
+  Operation *readOp(Block *parent);
+  LogicalResult readRegion(Region &region);
+  LogicalResult readChunk(Operation *op, size_t end);
+  void dropForwardRefs();
+  LogicalResult readOperand(Value &value);
+  LogicalResult defineValue(Value value);
+
+  InFlightDiagnostic emitError() {
+    return mlir::emitError(unknownLoc) << "bytecode: ";
+  }
+
+  StringRef data;
+  size_t pos{};
+  DynamicContext *dynCtx;
+  MLIRContext *ctx;
+  Location unknownLoc;
+  bool lazy;
+
+  std::vector<StringRef> strings;
+
+  /// Entries are read on first use. An entry may only refer to entries
+  /// before the limit, which are the entries before it.
+  std::vector<size_t> entryOffsets;
+  std::vector<Type> types;
+  std::vector<Attribute> attrs;
+  unsigned entryLimit{};
+
+  /// The offsets of the start and end of the chunks that were skipped.
+  llvm::DenseMap<Operation *, std::pair<size_t, size_t>> pendingChunks;
+
+  /// Values in definition order, and placeholders for forward references.
+  std::vector<Value> values;
+  llvm::DenseMap<unsigned, Operation *> forwardRefs;
+};
+} // end anonymous namespace
+
+LogicalResult BytecodeReader::readVarint(uint64_t &value) {
+  unsigned size;
+  const char *error = nullptr;
+  auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+  value = llvm::decodeULEB128(bytes + pos, &size, bytes + data.size(), &error);
+  if (error)
+    return emitError() << error << " at offset " << pos;
+  pos += size;
+  return success();
+}
+
+LogicalResult BytecodeReader::readVarint(unsigned &value) {
+  uint64_t value64;
+  if (failed(readVarint(value64)))
+    return failure();
+  if (value64 > std::numeric_limits<unsigned>::max())
+    return emitError() << "integer out of range at offset " << pos;
+  value = value64;
+  return success();
+}
+
+LogicalResult BytecodeReader::readSigned(int64_t &value) {
+  unsigned size;
+  const char *error = nullptr;
+  auto *bytes = reinterpret_cast<const uint8_t *>(data.data());
+  value = llvm::decodeSLEB128(bytes + pos, &size, bytes + data.size(), &error);
+  if (error)
+    return emitError() << error << " at offset " << pos;
+  pos += size;
+  return success();
+}
+
+LogicalResult BytecodeReader::readFixed64(uint64_t &value) {
+  StringRef bytes;
+  if (failed(readBytes(sizeof(uint64_t), bytes)))
+    return failure();
+  value = llvm::support::endian::read<uint64_t, llvm::support::little>(
+      bytes.data());
+  return success();
+}
+
+LogicalResult BytecodeReader::readBytes(size_t size, StringRef &bytes) {
+  if (size > data.size() - pos)
+    return emitError() << "unexpected end of data at offset " << pos;
+  bytes = data.substr(pos, size);
+  pos += size;
+  return success();
+}
+
+LogicalResult BytecodeReader::readString(StringRef &str) {
+  unsigned idx;
+  if (failed(readVarint(idx)))
+    return failure();
+  if (idx >= strings.size())
+    return emitError() << "invalid string index " << idx;
+  str = strings[idx];
+  return success();
+}
+
+LogicalResult BytecodeReader::readType(Type &type) {
+  unsigned idx;
+  if (failed(readVarint(idx)) || failed(readEntryAt(idx)))
+    return failure();
+  if (!types[idx])
+    return emitError() << "entry " << idx << " is not a type";
+  type = types[idx];
+  return success();
+}
+
+LogicalResult BytecodeReader::readAttr(Attribute &attr) {
+  unsigned idx;
+  if (failed(readVarint(idx)) || failed(readEntryAt(idx)))
+    return failure();
+  if (!attrs[idx])
+    return emitError() << "entry " << idx << " is not an attribute";
+  attr = attrs[idx];
+  return success();
+}
+
+template <typename T> LogicalResult BytecodeReader::readAttr(T &attr) {
+  Attribute base;
+  if (failed(readAttr(base)))
+    return failure();
+  if (!(attr = base.dyn_cast<T>()))
+    return emitError() << "unexpected attribute kind at offset " << pos;
+  return success();
+}
+
+template <typename T, typename ReadFn>
+LogicalResult BytecodeReader::readList(SmallVectorImpl<T> &list,
+                                       ReadFn readFn) {
+  unsigned size;
+  if (failed(readVarint(size)))
+    return failure();
+  /// Every element takes at least one byte.
+  if (size > data.size() - pos)
+    return emitError() << "list size " << size << " out of range";
+  list.resize(size);
+  for (auto &elt : list) {
+    if (failed(readFn(elt)))
+      return failure();
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::readHeader() {
+  StringRef magic;
+  if (failed(readBytes(sizeof(Magic), magic)) ||
+      magic != StringRef{Magic, sizeof(Magic)})
+    return emitError() << "not a bytecode file";
+  unsigned version;
+  if (failed(readVarint(version)))
+    return failure();
+  if (version != Version)
+    return emitError() << "unsupported version " << version;
+  return success();
+}
+
+LogicalResult BytecodeReader::readStrings() {
+  unsigned numStrings;
+  if (failed(readVarint(numStrings)))
+    return failure();
+  strings.reserve(numStrings);
+  for (unsigned i = 0; i < numStrings; ++i) {
+    uint64_t size;
+    StringRef str;
+    if (failed(readVarint(size)) || failed(readBytes(size, str)))
+      return failure();
+    strings.push_back(str);
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::readDialects() {
+  unsigned numDialects;
+  if (failed(readVarint(numDialects)))
+    return failure();
+  for (unsigned i = 0; i < numDialects; ++i) {
+    StringRef name;
+    uint64_t hash;
+    if (failed(readString(name)) || failed(readFixed64(hash)))
+      return failure();
+    auto *dialect = dynCtx->lookupDialect(name);
+    if (!dialect)
+      return emitError() << "dynamic dialect '" << name
+                         << "' is not registered";
+    if (dialect->getSpecHash() != hash)
+      return emitError() << "dynamic dialect '" << name
+                         << "' was registered from a different spec";
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::readDynamicSymbol(
+    DynamicDialect *&dialect, StringRef &name,
+    SmallVectorImpl<Attribute> &params) {
+  StringRef dialectName;
+  if (failed(readString(dialectName)) || failed(readString(name)) ||
+      failed(readList(params, [&](Attribute &attr)
+                      { return readAttr(attr); })))
+    return failure();
+  /// The dialect was checked against its spec in the dialect section.
+  if (!(dialect = dynCtx->lookupDialect(dialectName)))
+    return emitError() << "dynamic dialect '" << dialectName
+                       << "' is not registered";
+  return success();
+}
+
+LogicalResult BytecodeReader::readEntries() {
+  unsigned numEntries;
+  if (failed(readVarint(numEntries)))
+    return failure();
+  if (numEntries > data.size() - pos)
+    return emitError() << "entry count " << numEntries << " out of range";
+  /// Only find where each entry starts.
+  entryOffsets.reserve(numEntries);
+  for (unsigned i = 0; i < numEntries; ++i) {
+    entryOffsets.push_back(pos);
+    StringRef kindByte, payload;
+    uint64_t size;
+    if (failed(readBytes(1, kindByte)) || failed(readVarint(size)) ||
+        failed(readBytes(size, payload)))
+      return failure();
+  }
+  types.resize(numEntries);
+  attrs.resize(numEntries);
+  entryLimit = numEntries;
+  return success();
+}
+
+LogicalResult BytecodeReader::readEntryAt(unsigned idx) {
+  if (idx >= entryLimit)
+    return emitError() << "invalid entry index " << idx;
+  if (types[idx] || attrs[idx])
+    return success();
+  /// Entries only refer to earlier entries, so this terminates.
+  auto outerPos = pos;
+  auto outerLimit = entryLimit;
+  pos = entryOffsets[idx];
+  entryLimit = idx;
+  auto result = readEntry(types[idx], attrs[idx]);
+  pos = outerPos;
+  entryLimit = outerLimit;
+  if (failed(result)) {
+    types[idx] = {};
+    attrs[idx] = {};
+  }
+  return result;
+}
+
+LogicalResult BytecodeReader::readEntry(Type &type, Attribute &attr) {
+  StringRef kindByte;
+  uint64_t size;
+  if (failed(readBytes(1, kindByte)) || failed(readVarint(size)))
+    return failure();
+  auto kind = static_cast<EntryKind>(kindByte.front());
+  if (kind > EntryKind::LastKind)
+    return emitError() << "unknown entry kind " << (unsigned) kind;
+  auto end = pos + size;
+
+  switch (kind) {
+  case EntryKind::TypeText: {
+    StringRef text;
+    if (failed(readString(text)))
+      return failure();
+    if (!(type = parseType(text, ctx)))
+      return emitError() << "failed to parse type '" << text << "'";
+    break;
+  }
+  case EntryKind::AttrText: {
+    StringRef text;
+    if (failed(readString(text)))
+      return failure();
+    if (!(attr = parseAttribute(text, ctx)))
+      return emitError() << "failed to parse attribute '" << text << "'";
+    break;
+  }
+  case EntryKind::DynamicType: {
+    DynamicDialect *dialect;
+    StringRef name;
+    SmallVector<Attribute, 4> params;
+    if (failed(readDynamicSymbol(dialect, name, params)))
+      return failure();
+    auto *impl = dialect->lookupType(name);
+    if (!impl)
+      return emitError() << "unknown type '" << name << "' in dialect '"
+                         << dialect->getNamespace() << "'";
+    type = DynamicType::get(impl, params);
+    break;
+  }
+  case EntryKind::DynamicAttr: {
+    DynamicDialect *dialect;
+    StringRef name;
+    SmallVector<Attribute, 4> params;
+    if (failed(readDynamicSymbol(dialect, name, params)))
+      return failure();
+    auto *impl = dialect->lookupAttr(name);
+    if (!impl)
+      return emitError() << "unknown attribute '" << name << "' in dialect '"
+                         << dialect->getNamespace() << "'";
+    attr = DynamicAttribute::get(impl, params);
+    break;
+  }
+  case EntryKind::FunctionType: {
+    SmallVector<Type, 4> inputs, results;
+    auto readFn = [&](Type &ty) { return readType(ty); };
+    if (failed(readList(inputs, readFn)) || failed(readList(results, readFn)))
+      return failure();
+    type = mlir::FunctionType::get(inputs, results, ctx);
+    break;
+  }
+  case EntryKind::TupleType: {
+    SmallVector<Type, 4> elTys;
+    if (failed(readList(elTys, [&](Type &ty) { return readType(ty); })))
+      return failure();
+    type = TupleType::get(elTys, ctx);
+    break;
+  }
+  case EntryKind::RankedTensorType: {
+    SmallVector<int64_t, 4> shape;
+    Type elTy;
+    if (failed(readList(shape, [&](int64_t &dim)
+                        { return readSigned(dim); })) ||
+        failed(readType(elTy)))
+      return failure();
+    type = RankedTensorType::getChecked(shape, elTy, unknownLoc);
+    break;
+  }
+  case EntryKind::UnrankedTensorType: {
+    Type elTy;
+    if (failed(readType(elTy)))
+      return failure();
+    type = UnrankedTensorType::getChecked(elTy, unknownLoc);
+    break;
+  }
+  case EntryKind::ArrayAttr: {
+    SmallVector<Attribute, 4> elts;
+    if (failed(readList(elts, [&](Attribute &elt) { return readAttr(elt); })))
+      return failure();
+    attr = mlir::ArrayAttr::get(elts, ctx);
+    break;
+  }
+  case EntryKind::DictionaryAttr: {
+    SmallVector<NamedAttribute, 4> elts;
+    if (failed(readList(elts, [&](NamedAttribute &elt) {
+      StringRef name;
+      if (failed(readString(name)) || failed(readAttr(elt.second)))
+        return failure();
+      elt.first = Identifier::get(name, ctx);
+      return success();
+    })))
+      return failure();
+    attr = mlir::DictionaryAttr::get(elts, ctx);
+    break;
+  }
+  case EntryKind::TypeAttr: {
+    Type value;
+    if (failed(readType(value)))
+      return failure();
+    attr = mlir::TypeAttr::get(value);
+    break;
+  }
+  case EntryKind::StringAttr: {
+    StringRef value;
+    Type strTy;
+    if (failed(readString(value)) || failed(readType(strTy)))
+      return failure();
+    attr = mlir::StringAttr::get(value, strTy);
+    break;
+  }
+  case EntryKind::IntegerAttr: {
+    Type intTy;
+    int64_t value;
+    if (failed(readType(intTy)) || failed(readSigned(value)))
+      return failure();
+    if (!intTy.isa<IntegerType>() && !intTy.isa<mlir::IndexType>())
+      return emitError() << "expected an integer or index type";
+    attr = mlir::IntegerAttr::get(intTy, value);
+    break;
+  }
+  case EntryKind::FloatAttr: {
+    Type fpTy;
+    uint64_t bits;
+    if (failed(readType(fpTy)) || failed(readFixed64(bits)))
+      return failure();
+    auto floatTy = fpTy.dyn_cast<FloatType>();
+    if (!floatTy)
+      return emitError() << "expected a float type";
+    llvm::APFloat value{floatTy.getFloatSemantics(),
+                        llvm::APInt{floatTy.getWidth(), bits}};
+    attr = mlir::FloatAttr::get(floatTy, value);
+    break;
+  }
+  case EntryKind::BoolAttr: {
+    unsigned value;
+    if (failed(readVarint(value)))
+      return failure();
+    attr = mlir::BoolAttr::get(value, ctx);
+    break;
+  }
+  case EntryKind::UnitAttr:
+    attr = mlir::UnitAttr::get(ctx);
+    break;
+  case EntryKind::SymbolRefAttr: {
+    StringRef root;
+    SmallVector<StringRef, 2> nested;
+    if (failed(readString(root)) ||
+        failed(readList(nested, [&](StringRef &ref)
+                        { return readString(ref); })))
+      return failure();
+    SmallVector<FlatSymbolRefAttr, 2> nestedRefs;
+    for (auto ref : nested)
+      nestedRefs.push_back(FlatSymbolRefAttr::get(ref, ctx));
+    attr = mlir::SymbolRefAttr::get(root, nestedRefs, ctx);
+    break;
+  }
+  case EntryKind::UnknownLoc:
+    attr = unknownLoc;
+    break;
+  case EntryKind::FileLineColLoc: {
+    StringRef filename;
+    unsigned line, col;
+    if (failed(readString(filename)) || failed(readVarint(line)) ||
+        failed(readVarint(col)))
+      return failure();
+    attr = FileLineColLoc::get(filename, line, col, ctx);
+    break;
+  }
+  case EntryKind::NameLoc: {
+    StringRef name;
+    LocationAttr child;
+    if (failed(readString(name)) || failed(readAttr(child)))
+      return failure();
+    attr = NameLoc::get(Identifier::get(name, ctx), child);
+    break;
+  }
+  case EntryKind::CallSiteLoc: {
+    LocationAttr callee, caller;
+    if (failed(readAttr(callee)) || failed(readAttr(caller)))
+      return failure();
+    attr = CallSiteLoc::get(callee, caller);
+    break;
+  }
+  case EntryKind::FusedLoc: {
+    SmallVector<Location, 4> locs;
+    if (failed(readList(locs, [&](Location &loc) {
+      LocationAttr locAttr;
+      if (failed(readAttr(locAttr)))
+        return failure();
+      loc = locAttr;
+      return success();
+    })))
+      return failure();
+    unsigned metadataIdx;
+    if (failed(readVarint(metadataIdx)))
+      return failure();
+    Attribute metadata;
+    if (metadataIdx) {
+      if (failed(readEntryAt(metadataIdx - 1)))
+        return failure();
+      if (!(metadata = attrs[metadataIdx - 1]))
+        return emitError() << "invalid fused location metadata";
+    }
+    attr = FusedLoc::get(locs, metadata, ctx);
+    break;
+  }
+  }
+
+  if (!type && !attr)
+    return failure();
+  if (pos != end)
+    return emitError() << "entry size mismatch at offset " << pos;
+  return success();
+}
+
+LogicalResult BytecodeReader::defineValue(Value value) {
+  auto id = values.size();
+  values.push_back(value);
+  /// Replace the placeholder of a forward reference.
+  if (auto *placeholder = forwardRefs.lookup(id)) {
+    if (placeholder->getResult(0).getType() != value.getType())
+      return emitError() << "value #" << id << " was referenced with type "
+                         << placeholder->getResult(0).getType()
+                         << " but defined with type " << value.getType();
+    placeholder->getResult(0).replaceAllUsesWith(value);
+    placeholder->destroy();
+    forwardRefs.erase(id);
+  }
+  return success();
+}
+
+LogicalResult BytecodeReader::readOperand(Value &value) {
+  unsigned id;
+  if (failed(readVarint(id)))
+    return failure();
+  if (id < values.size()) {
+    value = values[id];
+    return success();
+  }
+  /// A forward reference is followed by its type.
+  Type type;
+  if (failed(readType(type)))
+    return failure();
+  auto &placeholder = forwardRefs[id];
+  if (!placeholder) {
+    OperationState state{unknownLoc, "dmc.bytecode.placeholder"};
+    state.addTypes(type);
+    placeholder = Operation::create(state);
+  }
+  value = placeholder->getResult(0);
+  return success();
+}
+
+Operation *BytecodeReader::readOp(Block *parent) {
+  StringRef name;
+  LocationAttr loc;
+  if (failed(readString(name)) || failed(readAttr(loc)))
+    return nullptr;
+  OperationState state{loc, name};
+
+  SmallVector<Value, 4> operands;
+  SmallVector<Type, 4> resultTys;
+  mlir::DictionaryAttr opAttrs;
+  if (failed(readList(operands, [&](Value &value)
+                      { return readOperand(value); })) ||
+      failed(readList(resultTys, [&](Type &ty) { return readType(ty); })) ||
+      failed(readAttr(opAttrs)))
+    return nullptr;
+  state.addOperands(operands);
+  state.addTypes(resultTys);
+  state.addAttributes(opAttrs.getValue());
+
+  /// Successors refer to the blocks of the parent region.
+  SmallVector<unsigned, 2> succs;
+  if (failed(readList(succs, [&](unsigned &idx) { return readVarint(idx); })))
+    return nullptr;
+  if (!succs.empty()) {
+    SmallVector<Block *, 8> blocks;
+    if (parent) {
+      for (auto &block : *parent->getParent())
+        blocks.push_back(&block);
+    }
+    for (auto idx : succs) {
+      if (idx >= blocks.size()) {
+        emitError() << "invalid successor " << idx;
+        return nullptr;
+      }
+      state.addSuccessors(blocks[idx]);
+    }
+  }
+
+  /// The low bit marks regions that are written as a chunk.
+  unsigned regionsAndChunk;
+  uint64_t chunkSize{};
+  if (failed(readVarint(regionsAndChunk)))
+    return nullptr;
+  bool chunk = regionsAndChunk & 1;
+  if (chunk && (failed(readVarint(chunkSize)) ||
+                chunkSize > data.size() - pos)) {
+    emitError() << "invalid chunk at offset " << pos;
+    return nullptr;
+  }
+  for (unsigned i = 0, e = regionsAndChunk >> 1; i < e; ++i)
+    state.addRegion();
+
+  /// An op in a block is owned by the block even if reading fails.
+  auto *op = Operation::create(state);
+  if (parent)
+    parent->push_back(op);
+  auto fail = [&]() -> Operation * {
+    if (!parent)
+      op->destroy();
+    return nullptr;
+  };
+  for (auto result : op->getResults()) {
+    if (failed(defineValue(result)))
+      return fail();
+  }
+  if (chunk && lazy) {
+    pendingChunks.try_emplace(op, pos, pos + chunkSize);
+    pos += chunkSize;
+  } else if (chunk) {
+    if (failed(readChunk(op, pos + chunkSize)))
+      return fail();
+  } else {
+    for (auto &region : op->getRegions()) {
+      if (failed(readRegion(region)))
+        return fail();
+    }
+  }
+  return op;
+}
+
+LogicalResult BytecodeReader::readChunk(Operation *op, size_t end) {
+  /// Values in a chunk are numbered from zero and cannot refer to values
+  /// outside of it.
+  std::vector<Value> outerValues;
+  llvm::DenseMap<unsigned, Operation *> outerForwardRefs;
+  std::swap(values, outerValues);
+  std::swap(forwardRefs, outerForwardRefs);
+
+  LogicalResult result = success();
+  for (auto &region : op->getRegions()) {
+    if (failed(result = readRegion(region)))
+      break;
+  }
+  if (succeeded(result) && !forwardRefs.empty())
+    result = emitError() << "value #" << forwardRefs.begin()->first
+                         << " is used but never defined";
+  if (succeeded(result) && pos != end)
+    result = emitError() << "chunk size mismatch at offset " << pos;
+  if (failed(result)) {
+    for (auto &region : op->getRegions())
+      region.dropAllReferences();
+    dropForwardRefs();
+    for (auto &region : op->getRegions())
+      region.getBlocks().clear();
+  }
+
+  std::swap(values, outerValues);
+  std::swap(forwardRefs, outerForwardRefs);
+  return result;
+}
+
+void BytecodeReader::dropForwardRefs() {
+  for (auto &it : forwardRefs) {
+    it.second->getResult(0).dropAllUses();
+    it.second->destroy();
+  }
+  forwardRefs.clear();
+}
+
+LogicalResult BytecodeReader::materialize(Operation *op) {
+  auto it = pendingChunks.find(op);
+  if (it == std::end(pendingChunks))
+    return success();
+  auto [begin, end] = it->second;
+  pendingChunks.erase(it);
+  auto outerPos = pos;
+  pos = begin;
+  auto result = readChunk(op, end);
+  pos = outerPos;
+  return result;
+}
+
+LogicalResult BytecodeReader::readRegion(Region &region) {
+  unsigned numBlocks;
+  if (failed(readVarint(numBlocks)))
+    return failure();
+  if (numBlocks > data.size() - pos)
+    return emitError() << "block count " << numBlocks << " out of range";
+  /// Create every block first, since successors may refer to later blocks.
+  for (unsigned i = 0; i < numBlocks; ++i)
+    region.push_back(new Block);
+  for (auto &block : region) {
+    SmallVector<Type, 4> argTys;
+    if (failed(readList(argTys, [&](Type &ty) { return readType(ty); })))
+      return failure();
+    for (auto argTy : argTys) {
+      if (failed(defineValue(block.addArgument(argTy))))
+        return failure();
+    }
+    unsigned numOps;
+    if (failed(readVarint(numOps)))
+      return failure();
+    for (unsigned i = 0; i < numOps; ++i) {
+      if (!readOp(&block))
+        return failure();
+    }
+  }
+  return success();
+}
+
+OwningModuleRef BytecodeReader::read() {
+  if (failed(readHeader()) || failed(readStrings()) ||
+      failed(readDialects()) || failed(readEntries()))
+    return {};
+
+  auto *op = readOp(nullptr);
+  if (op && !forwardRefs.empty()) {
+    emitError() << "value #" << forwardRefs.begin()->first
+                << " is used but never defined";
+    op->destroy();
+    op = nullptr;
+  }
+  if (!op) {
+    /// The placeholders are owned by the reader until they are replaced.
+    dropForwardRefs();
+    return {};
+  }
+
+  OwningModuleRef module{dyn_cast<ModuleOp>(op)};
+  if (!module) {
+    emitError() << "expected a module, got '" << op->getName() << "'";
+    op->destroy();
+    return {};
+  }
+  if (pos != data.size()) {
+    emitError() << "unexpected data after the module at offset " << pos;
+    return {};
+  }
+  if (!lazy && failed(verify(*module)))
+    return {};
+  return module;
+}
+
+OwningModuleRef parseBytecode(StringRef data, DynamicContext *ctx) {
+  return BytecodeReader{data, ctx}.read();
+}
+
+/// Open a bytecode file. Large files are memory-mapped.
+static std::unique_ptr<llvm::MemoryBuffer> openFile(StringRef filename,
+                                                    DynamicContext *ctx) {
+  auto file = llvm::MemoryBuffer::getFile(filename, /*FileSize=*/-1,
+                                          /*RequiresNullTerminator=*/false);
+  if (!file) {
+    mlir::emitError(UnknownLoc::get(ctx->getContext()))
+        << "failed to open '" << filename << "': "
+        << file.getError().message();
+    return nullptr;
+  }
+  return std::move(*file);
+}
+
+OwningModuleRef parseBytecodeFile(StringRef filename, DynamicContext *ctx) {
+  auto file = openFile(filename, ctx);
+  if (!file)
+    return {};
+  return parseBytecode(file->getBuffer(), ctx);
+}
+
+class LazyModule::Impl {
+public:
+  Impl(std::unique_ptr<llvm::MemoryBuffer> file, DynamicContext *ctx)
+      : file{std::move(file)},
+        reader{this->file->getBuffer(), ctx, /*lazy=*/true} {}
+
+  /// The reader refers to strings in the file.
+  std::unique_ptr<llvm::MemoryBuffer> file;
+  BytecodeReader reader;
+  OwningModuleRef module;
+  /// Index the top-level symbols.
+  llvm::StringMap<Operation *> symbols;
+};
+
+LazyModule::LazyModule(std::unique_ptr<Impl> impl) : impl{std::move(impl)} {}
+
+LazyModule::~LazyModule() = default;
+
+std::unique_ptr<LazyModule> LazyModule::load(StringRef filename,
+                                             DynamicContext *ctx) {
+  auto file = openFile(filename, ctx);
+  if (!file)
+    return nullptr;
+  auto impl = std::make_unique<Impl>(std::move(file), ctx);
+  if (!(impl->module = impl->reader.read()))
+    return nullptr;
+  for (auto &op : *impl->module->getBody()) {
+    if (auto name = op.getAttrOfType<mlir::StringAttr>(
+            SymbolTable::getSymbolAttrName()))
+      impl->symbols.try_emplace(name.getValue(), &op);
+  }
+  return std::unique_ptr<LazyModule>{new LazyModule{std::move(impl)}};
+}
+
+ModuleOp LazyModule::getModule() {
+  return *impl->module;
+}
+
+Operation *LazyModule::lookup(StringRef name) {
+  auto *op = impl->symbols.lookup(name);
+  if (!op || failed(materialize(op)))
+    return nullptr;
+  return op;
+}
+
+LogicalResult LazyModule::materialize(Operation *op) {
+  if (!impl->reader.isPending(op))
+    return success();
+  if (failed(impl->reader.materialize(op)))
+    return failure();
+  return verify(op);
+}
+
+LogicalResult LazyModule::materializeAll() {
+  for (auto &op : *impl->module->getBody()) {
+    if (failed(impl->reader.materialize(&op)))
+      return failure();
+  }
+  return verify(*impl->module);
+}
+
+unsigned LazyModule::getNumUnmaterialized() {
+  return impl->reader.getNumPending();
+}
+
+LogicalResult LazyModule::print(llvm::raw_ostream &os, OpPrintingFlags flags) {
+  if (failed(materializeAll()))
+    return failure();
+  impl->module->print(os, flags);
+  return success();
+}
+
+LogicalResult LazyModule::writeBytecode(llvm::raw_ostream &os) {
+  if (failed(materializeAll()))
+    return failure();
+  return dmc::writeBytecode(*impl->module, os);
+}
+
+LogicalResult LazyModule::writeBytecodeFile(StringRef filename) {
+  if (failed(materializeAll()))
+    return failure();
+  return dmc::writeBytecodeFile(*impl->module, filename);
+}
+
+} // end namespace dmc
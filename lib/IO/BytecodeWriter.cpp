@@ -0,0 +1,383 @@
+#include "BytecodeKinds.h"
+#include "dmc/IO/Bytecode.h"
+#include "dmc/Dynamic/DynamicContext.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicType.h"
+#include "dmc/Dynamic/DynamicAttribute.h"
+
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/StandardTypes.h>
+#include <llvm/ADT/MapVector.h>
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/EndianStream.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/LEB128.h>
+
+using namespace mlir;
+using namespace dmc::bytecode;
+
+namespace dmc {
+
+namespace {
+class BytecodeWriter {
+public:
+  explicit BytecodeWriter(MLIRContext *ctx)
+      : dynCtx{ctx->getRegisteredDialect<DynamicContext>()} {}
+
+  void write(ModuleOp module, llvm::raw_ostream &os);
+
+private:
+  /// Get the index of a string, type, or attribute, adding it to its table
+  /// if it is new. Types and attributes are added after their children.
+  unsigned getString(StringRef str);
+  unsigned getEntry(Type type);
+  unsigned getEntry(Attribute attr);
+  unsigned addEntry(const void *key, EntryKind kind, StringRef payload);
+  template <typename RangeT>
+  void writeEntries(llvm::raw_ostream &os, RangeT &&range);
+
+  /// Record a dynamic dialect used by the module.
+  void addDialect(DynamicDialect *dialect);
+
+  /// Number the values defined by an op and its regions in the order that
+  /// they are defined when read.
+  void numberValues(Operation *op, unsigned &nextId);
+  /// Whether the regions of an op are written as a chunk: the op is isolated
+  /// from above and at the top level of the module.
+  bool isChunk(Operation *op);
+  void writeOp(llvm::raw_ostream &os, Operation *op);
+  void writeRegion(llvm::raw_ostream &os, Region &region);
+  void writeOperand(llvm::raw_ostream &os, Value value);
+
+  DynamicContext *dynCtx;
+  Operation *root{};
+
+  llvm::StringMap<unsigned> stringIds;
+  std::vector<StringRef> strings;
+
+  llvm::DenseMap<const void *, unsigned> entryIds;
+  std::string entries;
+  unsigned numEntries{};
+
+  /// The string index and the spec hash of each dynamic dialect.
+  llvm::MapVector<DynamicDialect *, std::pair<unsigned, uint64_t>> dialects;
+
+  llvm::DenseMap<Value, unsigned> valueIds;
+  llvm::DenseMap<Block *, unsigned> blockIds;
+  unsigned numDefined{};
+};
+} // end anonymous namespace
+
+static void writeVarint(llvm::raw_ostream &os, uint64_t value) {
+  llvm::encodeULEB128(value, os);
+}
+
+unsigned BytecodeWriter::getString(StringRef str) {
+  auto [it, inserted] = stringIds.try_emplace(str, strings.size());
+  if (inserted)
+    strings.push_back(it->getKey());
+  return it->second;
+}
+
+unsigned BytecodeWriter::addEntry(const void *key, EntryKind kind,
+                                  StringRef payload) {
+  /// Entries are sized so that the reader can skip them until they are used.
+  entries.push_back(static_cast<char>(kind));
+  llvm::raw_string_ostream os{entries};
+  writeVarint(os, payload.size());
+  os << payload;
+  os.flush();
+  entryIds.try_emplace(key, numEntries);
+  return numEntries++;
+}
+
+template <typename RangeT>
+void BytecodeWriter::writeEntries(llvm::raw_ostream &os, RangeT &&range) {
+  writeVarint(os, llvm::size(range));
+  for (auto elt : range)
+    writeVarint(os, getEntry(elt));
+}
+
+void BytecodeWriter::addDialect(DynamicDialect *dialect) {
+  if (!dialects.count(dialect))
+    dialects.insert({dialect, {getString(dialect->getNamespace()),
+                               dialect->getSpecHash()}});
+}
+
+unsigned BytecodeWriter::getEntry(Type type) {
+  auto it = entryIds.find(type.getAsOpaquePointer());
+  if (it != std::end(entryIds))
+    return it->second;
+
+  /// Children are added to the table while the payload is written.
+  std::string payload;
+  llvm::raw_string_ostream os{payload};
+  EntryKind kind;
+  if (auto dynTy = type.dyn_cast<DynamicType>()) {
+    kind = EntryKind::DynamicType;
+    auto *impl = dynTy.getDynImpl();
+    addDialect(impl->getDialect());
+    writeVarint(os, getString(impl->getDialect()->getNamespace()));
+    writeVarint(os, getString(impl->getName()));
+    writeEntries(os, dynTy.getParams());
+  } else if (auto fcnTy = type.dyn_cast<mlir::FunctionType>()) {
+    kind = EntryKind::FunctionType;
+    writeEntries(os, fcnTy.getInputs());
+    writeEntries(os, fcnTy.getResults());
+  } else if (auto tupleTy = type.dyn_cast<TupleType>()) {
+    kind = EntryKind::TupleType;
+    writeEntries(os, tupleTy.getTypes());
+  } else if (auto tensorTy = type.dyn_cast<RankedTensorType>()) {
+    kind = EntryKind::RankedTensorType;
+    writeVarint(os, tensorTy.getRank());
+    for (auto dim : tensorTy.getShape())
+      llvm::encodeSLEB128(dim, os);
+    writeVarint(os, getEntry(tensorTy.getElementType()));
+  } else if (auto tensorTy = type.dyn_cast<UnrankedTensorType>()) {
+    kind = EntryKind::UnrankedTensorType;
+    writeVarint(os, getEntry(tensorTy.getElementType()));
+  } else {
+    kind = EntryKind::TypeText;
+    std::string text;
+    llvm::raw_string_ostream textOs{text};
+    type.print(textOs);
+    writeVarint(os, getString(textOs.str()));
+  }
+  return addEntry(type.getAsOpaquePointer(), kind, os.str());
+}
+
+unsigned BytecodeWriter::getEntry(Attribute attr) {
+  auto it = entryIds.find(attr.getAsOpaquePointer());
+  if (it != std::end(entryIds))
+    return it->second;
+
+  std::string payload;
+  llvm::raw_string_ostream os{payload};
+  EntryKind kind;
+  if (auto dynAttr = attr.dyn_cast<DynamicAttribute>()) {
+    kind = EntryKind::DynamicAttr;
+    auto *impl = dynAttr.getDynImpl();
+    addDialect(impl->getDialect());
+    writeVarint(os, getString(impl->getDialect()->getNamespace()));
+    writeVarint(os, getString(impl->getName()));
+    writeEntries(os, dynAttr.getParams());
+  } else if (auto arrAttr = attr.dyn_cast<mlir::ArrayAttr>()) {
+    kind = EntryKind::ArrayAttr;
+    writeEntries(os, arrAttr.getValue());
+  } else if (auto dictAttr = attr.dyn_cast<mlir::DictionaryAttr>()) {
+    kind = EntryKind::DictionaryAttr;
+    writeVarint(os, dictAttr.size());
+    for (auto &[name, value] : dictAttr.getValue()) {
+      writeVarint(os, getString(name.strref()));
+      writeVarint(os, getEntry(value));
+    }
+  } else if (auto typeAttr = attr.dyn_cast<mlir::TypeAttr>()) {
+    kind = EntryKind::TypeAttr;
+    writeVarint(os, getEntry(typeAttr.getValue()));
+  } else if (auto strAttr = attr.dyn_cast<mlir::StringAttr>()) {
+    kind = EntryKind::StringAttr;
+    writeVarint(os, getString(strAttr.getValue()));
+    writeVarint(os, getEntry(strAttr.getType()));
+  } else if (attr.isa<mlir::IntegerAttr>() &&
+             attr.cast<mlir::IntegerAttr>().getValue().getBitWidth() <= 64) {
+    kind = EntryKind::IntegerAttr;
+    auto intAttr = attr.cast<mlir::IntegerAttr>();
+    writeVarint(os, getEntry(intAttr.getType()));
+    llvm::encodeSLEB128(intAttr.getValue().getSExtValue(), os);
+  } else if (attr.isa<mlir::FloatAttr>() &&
+             attr.cast<mlir::FloatAttr>().getType().getIntOrFloatBitWidth()
+                 <= 64) {
+    kind = EntryKind::FloatAttr;
+    auto fpAttr = attr.cast<mlir::FloatAttr>();
+    writeVarint(os, getEntry(fpAttr.getType()));
+    llvm::support::endian::write<uint64_t>(
+        os, fpAttr.getValue().bitcastToAPInt().getZExtValue(),
+        llvm::support::little);
+  } else if (auto boolAttr = attr.dyn_cast<mlir::BoolAttr>()) {
+    kind = EntryKind::BoolAttr;
+    writeVarint(os, boolAttr.getValue());
+  } else if (attr.isa<mlir::UnitAttr>()) {
+    kind = EntryKind::UnitAttr;
+  } else if (auto symAttr = attr.dyn_cast<mlir::SymbolRefAttr>()) {
+    kind = EntryKind::SymbolRefAttr;
+    writeVarint(os, getString(symAttr.getRootReference()));
+    auto nested = symAttr.getNestedReferences();
+    writeVarint(os, nested.size());
+    for (auto nestedRef : nested)
+      writeVarint(os, getString(nestedRef.getValue()));
+  } else if (attr.isa<UnknownLoc>()) {
+    kind = EntryKind::UnknownLoc;
+  } else if (auto fileLoc = attr.dyn_cast<FileLineColLoc>()) {
+    kind = EntryKind::FileLineColLoc;
+    writeVarint(os, getString(fileLoc.getFilename()));
+    writeVarint(os, fileLoc.getLine());
+    writeVarint(os, fileLoc.getColumn());
+  } else if (auto nameLoc = attr.dyn_cast<NameLoc>()) {
+    kind = EntryKind::NameLoc;
+    writeVarint(os, getString(nameLoc.getName().strref()));
+    writeVarint(os, getEntry(LocationAttr(nameLoc.getChildLoc())));
+  } else if (auto callLoc = attr.dyn_cast<CallSiteLoc>()) {
+    kind = EntryKind::CallSiteLoc;
+    writeVarint(os, getEntry(LocationAttr(callLoc.getCallee())));
+    writeVarint(os, getEntry(LocationAttr(callLoc.getCaller())));
+  } else if (auto fusedLoc = attr.dyn_cast<FusedLoc>()) {
+    kind = EntryKind::FusedLoc;
+    auto locs = fusedLoc.getLocations();
+    writeVarint(os, locs.size());
+    for (auto loc : locs)
+      writeVarint(os, getEntry(LocationAttr(loc)));
+    /// The metadata is optional, so its index is offset by one.
+    auto metadata = fusedLoc.getMetadata();
+    writeVarint(os, metadata ? getEntry(metadata) + 1 : 0);
+  } else if (attr.isa<LocationAttr>()) {
+    /// Opaque locations cannot be serialized.
+    return getEntry(UnknownLoc::get(attr.getContext()));
+  } else {
+    kind = EntryKind::AttrText;
+    std::string text;
+    llvm::raw_string_ostream textOs{text};
+    attr.print(textOs);
+    writeVarint(os, getString(textOs.str()));
+  }
+  return addEntry(attr.getAsOpaquePointer(), kind, os.str());
+}
+
+bool BytecodeWriter::isChunk(Operation *op) {
+  return op->getParentOp() == root && op->getNumRegions() &&
+         op->isKnownIsolatedFromAbove();
+}
+
+void BytecodeWriter::numberValues(Operation *op, unsigned &nextId) {
+  for (auto result : op->getResults())
+    valueIds.try_emplace(result, nextId++);
+  /// Values in a chunk are numbered from zero.
+  unsigned chunkId = 0;
+  auto &regionId = isChunk(op) ? chunkId : nextId;
+  for (auto &region : op->getRegions()) {
+    unsigned blockId = 0;
+    for (auto &block : region) {
+      blockIds.try_emplace(&block, blockId++);
+      for (auto arg : block.getArguments())
+        valueIds.try_emplace(arg, regionId++);
+      for (auto &childOp : block)
+        numberValues(&childOp, regionId);
+    }
+  }
+}
+
+void BytecodeWriter::writeOperand(llvm::raw_ostream &os, Value value) {
+  auto id = valueIds.lookup(value);
+  writeVarint(os, id);
+  /// The reader needs the type of a forward reference for its placeholder.
+  if (id >= numDefined)
+    writeVarint(os, getEntry(value.getType()));
+}
+
+void BytecodeWriter::writeOp(llvm::raw_ostream &os, Operation *op) {
+  writeVarint(os, getString(op->getName().getStringRef()));
+  writeVarint(os, getEntry(LocationAttr(op->getLoc())));
+  if (auto *dialect = dynCtx ? dynCtx->lookupDialect(op->getName().getDialect())
+                            : nullptr)
+    addDialect(dialect);
+
+  /// Operands are written before the results are defined.
+  writeVarint(os, op->getNumOperands());
+  for (auto operand : op->getOperands())
+    writeOperand(os, operand);
+  writeEntries(os, op->getResultTypes());
+  numDefined += op->getNumResults();
+
+  writeVarint(os, getEntry(
+      mlir::DictionaryAttr::get(op->getAttrs(), op->getContext())));
+
+  /// Successors are blocks in the parent region of the op.
+  writeVarint(os, op->getNumSuccessors());
+  for (auto *succ : op->getSuccessors())
+    writeVarint(os, blockIds.lookup(succ));
+
+  /// The low bit marks regions that are written as a chunk.
+  auto chunk = isChunk(op);
+  writeVarint(os, op->getNumRegions() << 1 | chunk);
+  if (!chunk) {
+    for (auto &region : op->getRegions())
+      writeRegion(os, region);
+    return;
+  }
+
+  /// A chunk is prefixed with its size so that the reader can skip it.
+  std::string regions;
+  llvm::raw_string_ostream regionsOs{regions};
+  auto outerDefined = numDefined;
+  numDefined = 0;
+  for (auto &region : op->getRegions())
+    writeRegion(regionsOs, region);
+  numDefined = outerDefined;
+  writeVarint(os, regionsOs.str().size());
+  os << regions;
+}
+
+void BytecodeWriter::writeRegion(llvm::raw_ostream &os, Region &region) {
+  writeVarint(os, llvm::size(region));
+  for (auto &block : region) {
+    writeEntries(os, llvm::map_range(block.getArguments(),
+                                     [](BlockArgument arg)
+                                     { return arg.getType(); }));
+    numDefined += block.getNumArguments();
+    writeVarint(os, llvm::size(block));
+    for (auto &op : block)
+      writeOp(os, &op);
+  }
+}
+
+void BytecodeWriter::write(ModuleOp module, llvm::raw_ostream &os) {
+  /// The body is written first to collect the tables.
+  root = module.getOperation();
+  unsigned nextId = 0;
+  numberValues(module, nextId);
+  std::string body;
+  llvm::raw_string_ostream bodyOs{body};
+  writeOp(bodyOs, module);
+  bodyOs.flush();
+
+  os.write(Magic, sizeof(Magic));
+  writeVarint(os, Version);
+
+  writeVarint(os, strings.size());
+  for (auto str : strings) {
+    writeVarint(os, str.size());
+    os << str;
+  }
+
+  writeVarint(os, dialects.size());
+  for (auto &[dialect, data] : dialects) {
+    writeVarint(os, data.first);
+    llvm::support::endian::write<uint64_t>(os, data.second,
+                                           llvm::support::little);
+  }
+
+  writeVarint(os, numEntries);
+  os << entries;
+  os << body;
+}
+
+LogicalResult writeBytecode(ModuleOp module, llvm::raw_ostream &os) {
+  BytecodeWriter{module.getContext()}.write(module, os);
+  return success();
+}
+
+LogicalResult writeBytecodeFile(ModuleOp module, StringRef filename) {
+  std::error_code ec;
+  llvm::raw_fd_ostream os{filename, ec, llvm::sys::fs::OF_None};
+  if (ec)
+    return emitError(module.getLoc()) << "failed to open '" << filename
+                                      << "': " << ec.message();
+  if (failed(writeBytecode(module, os)))
+    return failure();
+  os.close();
+  if (os.has_error())
+    return emitError(module.getLoc()) << "failed to write '" << filename
+                                      << "'";
+  return success();
+}
+
+} // end namespace dmc
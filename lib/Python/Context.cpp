@@ -5,6 +5,8 @@
 #include <mlir/IR/MLIRContext.h>
 #include <mlir/InitAllDialects.h>
 
+#include <vector>
+
 namespace mlir {
 namespace py {
 
@@ -32,7 +34,16 @@ private:
   MLIRContext *ptr{&context};
 };
 
+/// The contexts entered on this thread, innermost last.
+static thread_local std::vector<MLIRContext *> contextStack;
+
 MLIRContext *getMLIRContext() {
+  if (!contextStack.empty())
+    return contextStack.back();
+  return GlobalContextHandle::instance().getContext();
+}
+
+MLIRContext *getGlobalMLIRContext() {
   return GlobalContextHandle::instance().getContext();
 }
 
@@ -40,5 +51,16 @@ void setMLIRContext(MLIRContext *ctx) {
   GlobalContextHandle::instance().setContext(ctx);
 }
 
+void pushMLIRContext(MLIRContext *ctx) {
+  contextStack.push_back(ctx);
+}
+
+bool popMLIRContext(MLIRContext *ctx) {
+  if (contextStack.empty() || contextStack.back() != ctx)
+    return false;
+  contextStack.pop_back();
+  return true;
+}
+
 } // end namespace py
 } // end namespace mlir
@@ -5,10 +5,20 @@
 namespace mlir {
 namespace py {
 
-/// Store a global MLIR context instance. All calls to MLIR functions through
-/// the Python API will use this instance. This simplifies the Python API as
-/// users will not need to pass a context handle to all function calls.
+/// Get the current MLIR context of this thread. All calls to MLIR functions
+/// through the Python API will use this instance. This simplifies the Python
+/// API as users will not need to pass a context handle to all function calls.
+///
+/// The current context is the innermost one entered on this thread, or the
+/// global context if none is entered.
 MLIRContext *getMLIRContext();
+MLIRContext *getGlobalMLIRContext();
+
+/// Enter and exit a context on this thread. Contexts must be exited in the
+/// reverse order that they are entered. Exiting a context that is not the
+/// innermost one leaves the stack unchanged and returns false.
+void pushMLIRContext(MLIRContext *ctx);
+bool popMLIRContext(MLIRContext *ctx);
 
 } // end namespace py
 } // end namespace mlir
@@ -2,6 +2,7 @@
 #include "dmc/Dynamic/DynamicType.h"
 #include "dmc/Dynamic/DynamicAttribute.h"
 
+#include <mlir/IR/DialectImplementation.h>
 #include <pybind11/pybind11.h>
 
 using namespace pybind11;
@@ -18,6 +19,25 @@ TypeWrap::TypeWrap(DynamicAttribute attr)
     : params{attr.getParams()},
       paramSpec{attr.getDynImpl()->getParamSpec()} {}
 
+void printDimensionListOrRaw(DialectAsmPrinter &printer, Attribute attr) {
+  auto arr = attr.dyn_cast<ArrayAttr>();
+  if (!arr) {
+    printer.printAttribute(attr);
+    return;
+  }
+  llvm::interleave(arr, printer, [&](Attribute el) {
+    if (auto i = el.dyn_cast<IntegerAttr>()) {
+      if (i.getValue().getSExtValue() == -1)
+        printer << '?';
+      else
+        printer << i.getValue().getZExtValue();
+    } else {
+      printer << el;
+    }
+  }, "x");
+  printer << "x";
+}
+
 void exposeTypeWrap(module &m) {
   class_<TypeWrap>(m, "TypeWrap")
       .def("getParameter", [](TypeWrap &wrap, std::string name) {
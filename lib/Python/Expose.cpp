@@ -8,6 +8,7 @@ namespace mlir {
 namespace py {
 
 void getModule(module &m) {
+  exposeContext(m);
   exposeParser(m);
   auto type = exposeTypeBase(m);
   exposeAttribute(m);
@@ -13,6 +13,7 @@ using AttrClass = pybind11::class_<Attribute>;
 using TypeClass = pybind11::class_<Type>;
 using OpClass = pybind11::class_<dmc::BaseOp>;
 
+void exposeContext(pybind11::module &m);
 void exposeParser(pybind11::module &m);
 /// pybind11 needs Type to be exposed before it can be used in default args.
 TypeClass exposeTypeBase(pybind11::module &m);
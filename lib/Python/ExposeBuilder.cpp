@@ -13,6 +13,10 @@
 #include <mlir/Conversion/StandardToLLVM/ConvertStandardToLLVM.h>
 #include <mlir/Conversion/StandardToLLVM/ConvertStandardToLLVMPass.h>
 
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+
 using namespace pybind11;
 
 namespace mlir {
@@ -50,74 +54,199 @@ bool operationIsa(Operation *op, object cls) {
       cls.attr("getName")().cast<std::string>();
 }
 
+/// Get the name of an op from its name or its Python class.
+static std::string getOpName(handle nameOrCls) {
+  if (isinstance<str>(nameOrCls))
+    return nameOrCls.cast<std::string>();
+  return nameOrCls.attr("getName")().cast<std::string>();
+}
+
+/// A filter of a Python pattern that is checked natively, before calling
+/// into Python, so that patterns with the same root are not all called.
+struct PatternFilter {
+  /// Attributes that must be equal to the given value.
+  std::vector<std::pair<std::string, Attribute>> attrs;
+  /// The exact number of operands, if given.
+  llvm::Optional<unsigned> numOperands;
+  /// Operands that must be defined by an op with the given name.
+  std::vector<std::pair<unsigned, std::string>> operandOps;
+};
+
+/// Counters of a pattern. Copies of a pattern share its counters, so they
+/// are visible from Python after the pattern is applied.
+struct PatternStats {
+  /// The number of ops the pattern was applied to.
+  std::size_t attempts{};
+  /// The number of those rejected by the filter.
+  std::size_t filtered{};
+  /// The number of successful rewrites.
+  std::size_t successes{};
+  /// The time spent in the Python function, in seconds.
+  double pythonTime{};
+};
+
+/// Op names are resolved once, when the pattern is created, so that pattern
+/// lists can be built without calling into Python.
 struct PyPattern {
-  PyPattern(object cls, object fcn, list generated, unsigned benefit)
-      : cls{cls}, fcn{fcn}, generated{generated}, benefit{benefit} {}
+  PyPattern(object cls, object fcn, list generated, unsigned benefit,
+            dict attrs, object numOperands, dict operandOps)
+      : cls{cls}, fcn{fcn}, rootName{getOpName(cls)}, benefit{benefit},
+        stats{std::make_shared<PatternStats>()} {
+    for (auto opCls : generated)
+      generatedNames.push_back(getOpName(opCls));
+    for (auto [name, value] : attrs)
+      filter.attrs.emplace_back(name.cast<std::string>(),
+                                value.cast<Attribute>());
+    if (!numOperands.is_none())
+      filter.numOperands = numOperands.cast<unsigned>();
+    for (auto [idx, nameOrCls] : operandOps)
+      filter.operandOps.emplace_back(idx.cast<unsigned>(),
+                                     getOpName(nameOrCls));
+  }
 
   object cls, fcn;
-  list generated;
+  std::string rootName;
+  std::vector<std::string> generatedNames;
   unsigned benefit;
+  PatternFilter filter;
+  std::shared_ptr<PatternStats> stats;
 };
 
-static ArrayRef<StringRef> getGeneratedOps(list generated) {
-  // Need to keep references alive until RewritePattern constructor is done
-  thread_local std::vector<std::string> names;
-  thread_local std::vector<StringRef> ret;
-  ret.clear();
-  names.clear();
-  ret.reserve(generated.size());
-  names.reserve(generated.size());
-  for (auto cls : generated) {
-    names.push_back(cls.attr("getName")().cast<std::string>());
-    ret.push_back(names.back());
-  }
-  return ret;
+static SmallVector<StringRef, 4> getGeneratedOps(const PyPattern &pattern) {
+  return {pattern.generatedNames.begin(), pattern.generatedNames.end()};
 }
 
 struct PyPatternImpl : public RewritePattern {
-  explicit PyPatternImpl(PyPattern &pattern)
-      : RewritePattern{pattern.cls.attr("getName")().cast<std::string>(),
-                       py::getGeneratedOps(pattern.generated),
-                       pattern.benefit, getMLIRContext()},
-        cls{pattern.cls}, fcn{pattern.fcn} {}
+  explicit PyPatternImpl(PyPattern &pattern, MLIRContext *ctx)
+      : RewritePattern{pattern.rootName, getGeneratedOps(pattern),
+                       pattern.benefit, ctx},
+        cls{pattern.cls}, fcn{pattern.fcn},
+        numOperands{pattern.filter.numOperands}, stats{pattern.stats} {
+    for (auto &[name, value] : pattern.filter.attrs)
+      attrs.emplace_back(Identifier::get(name, ctx), value);
+    for (auto &[idx, name] : pattern.filter.operandOps)
+      operandOps.emplace_back(idx, OperationName{name, ctx});
+  }
+
+  bool matchesFilter(Operation *op) const {
+    if (numOperands && op->getNumOperands() != *numOperands)
+      return false;
+    for (auto &[name, value] : attrs) {
+      if (op->getAttr(name) != value)
+        return false;
+    }
+    for (auto &[idx, name] : operandOps) {
+      if (idx >= op->getNumOperands())
+        return false;
+      auto *defOp = op->getOperand(idx).getDefiningOp();
+      if (!defOp || defOp->getName() != name)
+        return false;
+    }
+    return true;
+  }
 
   LogicalResult
   matchAndRewrite(Operation *op, PatternRewriter &rewriter) const override {
+    ++stats->attempts;
+    if (!matchesFilter(op)) {
+      ++stats->filtered;
+      return failure();
+    }
+    auto start = std::chrono::steady_clock::now();
     auto concreteOp = cls(op);
-    return success(fcn.operator()<return_value_policy::reference>(
-        concreteOp, static_cast<PatternRewriter &>(rewriter)).cast<bool>());
+    auto ret = fcn.operator()<return_value_policy::reference>(
+        concreteOp, static_cast<PatternRewriter &>(rewriter)).cast<bool>();
+    stats->pythonTime += std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    stats->successes += ret;
+    return success(ret);
   }
 
   object cls, fcn;
+  /// The filter, with names resolved in the context of the pattern.
+  SmallVector<std::pair<Identifier, Attribute>, 2> attrs;
+  llvm::Optional<unsigned> numOperands;
+  SmallVector<std::pair<unsigned, OperationName>, 2> operandOps;
+  std::shared_ptr<PatternStats> stats;
 };
 
-static auto getPatternList(std::vector<PyPattern> patterns) {
+/// Patterns are created in the context of the op that they are applied to.
+/// Patterns of higher benefit come first; the order of patterns of equal
+/// benefit is kept.
+static auto getPatternList(std::vector<PyPattern> patterns,
+                           MLIRContext *ctx) {
+  std::stable_sort(patterns.begin(), patterns.end(),
+                   [](const PyPattern &lhs, const PyPattern &rhs) {
+    return lhs.benefit > rhs.benefit;
+  });
   OwningRewritePatternList patternList;
   for (auto &pattern : patterns) {
-    patternList.insert<PyPatternImpl>(pattern);
+    patternList.insert<PyPatternImpl>(pattern, ctx);
   }
   return patternList;
 }
 
+/// A pattern list that is built once and applied many times, to avoid
+/// rebuilding it from Python patterns on every call.
+class PatternSet {
+public:
+  PatternSet(std::vector<PyPattern> patterns, MLIRContext *ctx)
+      : ctx{ctx}, numPatterns{patterns.size()},
+        patternList{getPatternList(std::move(patterns), ctx)} {}
+
+  std::size_t size() const { return numPatterns; }
+
+  /// Get the patterns to apply to an op, which must be in the context of the
+  /// set.
+  const OwningRewritePatternList &getPatternsFor(Operation *op) const {
+    if (op->getContext() != ctx)
+      throw std::invalid_argument{
+          "PatternSet applied to an op of a different context"};
+    return patternList;
+  }
+
+private:
+  MLIRContext *ctx;
+  std::size_t numPatterns;
+  OwningRewritePatternList patternList;
+};
+
 bool applyOptPatterns(Operation *op, std::vector<PyPattern> patterns) {
-  auto patternList = getPatternList(std::move(patterns));
+  auto patternList = getPatternList(std::move(patterns), op->getContext());
   return succeeded(applyPatternsAndFoldGreedily(op, patternList));
 }
 
 bool applyPartialConversion(Operation *op, std::vector<PyPattern> patterns,
                             ConversionTarget &target) {
-  auto patternList = getPatternList(std::move(patterns));
+  auto patternList = getPatternList(std::move(patterns), op->getContext());
   return succeeded(applyPartialConversion(op, target, patternList));
 }
 
 bool applyFullConversion(Operation *op, std::vector<PyPattern> patterns,
                          ConversionTarget &target) {
-  auto patternList = getPatternList(std::move(patterns));
+  auto patternList = getPatternList(std::move(patterns), op->getContext());
   return succeeded(applyFullConversion(op, target, patternList));
 }
 
+bool applyOptPatternSet(Operation *op, const PatternSet &patterns) {
+  return succeeded(applyPatternsAndFoldGreedily(
+      op, patterns.getPatternsFor(op)));
+}
+
+bool applyPartialConversionSet(Operation *op, const PatternSet &patterns,
+                               ConversionTarget &target) {
+  return succeeded(applyPartialConversion(op, target,
+                                          patterns.getPatternsFor(op)));
+}
+
+bool applyFullConversionSet(Operation *op, const PatternSet &patterns,
+                            ConversionTarget &target) {
+  return succeeded(applyFullConversion(op, target,
+                                       patterns.getPatternsFor(op)));
+}
+
 bool lowerSCFToStandard(ModuleOp module) {
-  PassManager mgr{getMLIRContext()};
+  PassManager mgr{module.getContext()};
   mgr.addPass(createLowerToCFGPass());
   return succeeded(mgr.run(module));
 }
@@ -160,7 +289,7 @@ struct LLVMLoweringPass : public OperationPass<ModuleOp> {
     populateStdToLLVMConversionPatterns(typeConverter, patterns);
 
     for (auto &pattern : extraPatterns) {
-      patterns.insert<PyPatternImpl>(pattern);
+      patterns.insert<PyPatternImpl>(pattern, &getContext());
     }
 
     if (failed(applyPartialConversion(m, target, patterns)))
@@ -176,20 +305,20 @@ struct LLVMLoweringPass : public OperationPass<ModuleOp> {
 bool lowerToLLVM(ModuleOp module, ConversionTarget &target,
                  std::vector<PyPattern> extraPatterns,
                  list typeConverters) {
-  PassManager mgr{getMLIRContext()};
+  PassManager mgr{module.getContext()};
   mgr.addPass(std::make_unique<LLVM::LLVMLoweringPass>(
       target, std::move(extraPatterns), typeConverters));
   return succeeded(mgr.run(module));
 }
 
 bool applyLICM(ModuleOp module) {
-  PassManager mgr{getMLIRContext()};
+  PassManager mgr{module.getContext()};
   mgr.addPass(mlir::createLoopInvariantCodeMotionPass());
   return succeeded(mgr.run(module));
 }
 
 bool applyCSE(ModuleOp module, object callback) {
-  PassManager mgr{getMLIRContext()};
+  PassManager mgr{module.getContext()};
   std::unique_ptr<Pass> pass;
   if (callback) {
     pass = mlir::createCSEPass([callback](Operation *op) {
@@ -203,7 +332,7 @@ bool applyCSE(ModuleOp module, object callback) {
 }
 
 bool runAllOpts(ModuleOp module) {
-  PassManager mgr{getMLIRContext()};
+  PassManager mgr{module.getContext()};
   mgr.addPass(mlir::createSymbolDCEPass());
   mgr.addPass(mlir::createCanonicalizerPass());
   mgr.addPass(mlir::createInlinerPass());
@@ -304,10 +433,41 @@ void exposeBuilder(module &m) {
   });
   m.def("isa", &operationIsa);
   m.def("applyOptPatterns", &applyOptPatterns);
+  m.def("applyOptPatterns", &applyOptPatternSet);
+
+  class_<PatternStats>(m, "PatternStats")
+      .def_readonly("attempts", &PatternStats::attempts)
+      .def_readonly("filtered", &PatternStats::filtered)
+      .def_readonly("successes", &PatternStats::successes)
+      .def_readonly("pythonTime", &PatternStats::pythonTime)
+      .def("__repr__", [](const PatternStats &stats) {
+        std::string buf;
+        llvm::raw_string_ostream os{buf};
+        os << "PatternStats(attempts=" << stats.attempts
+           << ", filtered=" << stats.filtered
+           << ", successes=" << stats.successes
+           << ", pythonTime=" << stats.pythonTime << ")";
+        return os.str();
+      });
 
   class_<PyPattern>(m, "Pattern")
-      .def(init<object, object, list, unsigned>(), "cls"_a, "matchFcn"_a,
-           "generatedOps"_a = list{}, "benefit"_a = 0);
+      .def(init<object, object, list, unsigned, dict, object, dict>(),
+           "cls"_a, "matchFcn"_a, "generatedOps"_a = list{}, "benefit"_a = 0,
+           "attrs"_a = dict{},
+           "numOperands"_a = pybind11::none(),
+           "operandOps"_a = dict{})
+      .def_property_readonly("stats", [](const PyPattern &pattern) {
+        return *pattern.stats;
+      })
+      .def("resetStats", [](PyPattern &pattern) {
+        *pattern.stats = PatternStats{};
+      });
+
+  class_<PatternSet>(m, "PatternSet")
+      .def(init([](std::vector<PyPattern> patterns) {
+        return new PatternSet{std::move(patterns), getMLIRContext()};
+      }), "patterns"_a)
+      .def("__len__", &PatternSet::size);
 
   class_<ConversionTarget>(m, "ConversionTarget")
       .def(init([]() { return new ConversionTarget{*getMLIRContext()}; }))
@@ -365,7 +525,9 @@ void exposeBuilder(module &m) {
       });
 
   m.def("applyPartialConversion", &applyPartialConversion);
+  m.def("applyPartialConversion", &applyPartialConversionSet);
   m.def("applyFullConversion", &applyFullConversion);
+  m.def("applyFullConversion", &applyFullConversionSet);
   m.def("lowerSCFToStandard", &lowerSCFToStandard);
   m.def("lowerToLLVM", &lowerToLLVM);
   m.def("LLVMConversionTarget", []() -> ConversionTarget * {
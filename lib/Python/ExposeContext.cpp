@@ -0,0 +1,31 @@
+#include "Context.h"
+
+#include <pybind11/pybind11.h>
+
+#include <stdexcept>
+
+using namespace pybind11;
+
+namespace mlir {
+namespace py {
+
+void exposeContext(module &m) {
+  // Contexts created from Python are owned by Python. Objects created in a
+  // context must not be used after it is destroyed.
+  class_<MLIRContext, std::unique_ptr<MLIRContext>>(m, "Context")
+      .def(init<>())
+      .def("__enter__", [](MLIRContext *ctx) {
+        pushMLIRContext(ctx);
+        return ctx;
+      }, return_value_policy::reference)
+      .def("__exit__", [](MLIRContext *ctx, object, object, object) {
+        if (!popMLIRContext(ctx))
+          throw std::runtime_error{"contexts must be exited in reverse order"};
+      });
+  m.def("getContext", &getMLIRContext, return_value_policy::reference);
+  m.def("getGlobalContext", &getGlobalMLIRContext,
+        return_value_policy::reference);
+}
+
+} // end namespace py
+} // end namespace mlir
@@ -1,5 +1,6 @@
 #include "Utility.h"
 #include "AsmUtils.h"
+#include "dmc/Python/DialectAsm.h"
 
 #include <mlir/IR/DialectImplementation.h>
 #include <llvm/ADT/STLExtras.h>
@@ -18,27 +19,6 @@ extern void exposeTypeWrap(module &m);
 namespace mlir {
 namespace py {
 
-namespace {
-static void printDimensionListOrRaw(DialectAsmPrinter &p, Attribute attr) {
-  if (auto arr = attr.dyn_cast<ArrayAttr>()) {
-    interleave(arr, p, [&](Attribute el) {
-      if (auto i = el.dyn_cast<IntegerAttr>()) {
-        if (i.getValue().getSExtValue() == -1) {
-          p << '?';
-        } else {
-          p << i.getValue().getZExtValue();
-        }
-      } else {
-        p << el;
-      }
-    }, "x");
-    p << "x";
-  } else {
-    p.printAttribute(attr);
-  }
-}
-} // end anonymous namespace
-
 void exposeDialectAsm(module &m) {
   class_<DialectAsmPrinter, std::unique_ptr<DialectAsmPrinter, nodelete>>
       (m, "DialectAsmPrinter")
@@ -46,7 +26,7 @@ void exposeDialectAsm(module &m) {
         p << val;
       })
       .def("printAttribute", &DialectAsmPrinter::printAttribute)
-      .def("printDimensionListOrRaw", &printDimensionListOrRaw);
+      .def("printDimensionListOrRaw", &dmc::py::printDimensionListOrRaw);
 
   class_<DialectAsmParser, std::unique_ptr<DialectAsmParser, nodelete>>
       parserCls{m, "DialectAsmParser"};
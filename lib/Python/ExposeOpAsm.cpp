@@ -26,12 +26,13 @@ namespace py {
 
 namespace {
 
-auto transformAttrStorage(AttrDictRef attrs, StringListRef elidedAttrs) {
-  /// Convert unordered_map<string, Attribute> -> vector<{Identifier, Attribute}>
-  /// and vector<string> -> vector<StringRef>
+auto transformAttrStorage(const dict &attrs, StringListRef elidedAttrs) {
+  /// Convert dict[str, Attribute] -> vector<{Identifier, Attribute}>, in the
+  /// dict's order, and vector<string> -> vector<StringRef>
   NamedAttrList namedAttrs;
-  for (auto &[name, attr] : attrs)
-    namedAttrs.push_back({getIdentifierChecked(name), attr});
+  for (auto [name, attr] : attrs)
+    namedAttrs.push_back({getIdentifierChecked(name.cast<std::string>()),
+                          attr.cast<Attribute>()});
   std::vector<StringRef> refs;
   refs.reserve(std::size(elidedAttrs));
   for (auto &elidedAttr : elidedAttrs)
@@ -116,13 +117,15 @@ void exposeOpAsm(module &m) {
                                           ValueListRef succOperands) {
         printer.printSuccessorAndUseList(successor, succOperands);
       })
-      .def("printOptionalAttrDict", [](OpAsmPrinter &printer, AttrDictRef attrs,
+      .def("printOptionalAttrDict", [](OpAsmPrinter &printer,
+                                       const dict &attrs,
                                        StringListRef elidedAttrs) {
         auto [namedAttrs, refs] = transformAttrStorage(attrs, elidedAttrs);
         printer.printOptionalAttrDict(namedAttrs, refs);
       }, "attrs"_a, "elidedAttrs"_a = StringList{})
       .def("printOptionalAttrDictWithKeyword",
-           [](OpAsmPrinter &printer, AttrDictRef attrs, StringListRef elidedAttrs) {
+           [](OpAsmPrinter &printer, const dict &attrs,
+              StringListRef elidedAttrs) {
         auto [namedAttrs, refs] = transformAttrStorage(attrs, elidedAttrs);
         printer.printOptionalAttrDictWithKeyword(namedAttrs, refs);
       }, "attrs"_a, "elidedAttrs"_a = StringList{})
@@ -182,11 +182,11 @@ void defOpMethods(class_<T, ExtraTs...> &cls) {
         return make_iterator(op->result_type_begin(), op->result_type_end());
       }, keep_alive<0, 1>())
       .def("getAttrs", [](Operation *op) {
-        auto opAttrs = op->getAttrs();
-        std::unordered_map<std::string, Attribute> attrs{std::size(opAttrs)};
-        for (auto &[name, attr] : opAttrs) {
-          attrs.emplace(name.str(), attr);
-        }
+        /// Python dicts keep insertion order, so the op's attribute order is
+        /// preserved for printers.
+        dict attrs;
+        for (auto &[name, attr] : op->getAttrs())
+          attrs[pybind11::str(name.str())] = pybind11::cast(attr);
         return attrs;
       })
       .def("getAttr", [](Operation *op, const std::string &name) {
@@ -1,6 +1,7 @@
 #include "Parser.h"
 
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 using namespace pybind11;
 
@@ -9,6 +10,9 @@ namespace py {
 
 void exposeParser(module &m) {
   m.def("parseSourceFile", &parseSourceFile);
+  // A thread count of zero uses every hardware thread.
+  m.def("parseSourceFiles", &parseSourceFiles, arg("filenames"),
+        arg("threads") = 0);
 }
 
 } // end namespace py
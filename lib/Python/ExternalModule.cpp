@@ -1,22 +1,33 @@
 #include "dmc/Python/PyMLIR.h"
 #include "dmc/Dynamic/DynamicContext.h"
 #include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/ParallelVerifier.h"
 #include "dmc/Spec/DialectGen.h"
 #include "dmc/Spec/SpecOps.h"
 #include "dmc/Embed/Expose.h"
+#include "dmc/Embed/Constraints.h"
+#include "dmc/IO/Bytecode.h"
 
 #include <pybind11/embed.h>
+#include <pybind11/stl.h>
 
 using namespace dmc;
 using namespace mlir;
 using namespace pybind11;
 
+/// Get the dynamic context of the current context. Dynamic dialects are
+/// registered separately in each context.
+static DynamicContext *getDynContext() {
+  // ownership is given to MLIRContext
+  return mlir::py::getMLIRContext()->getOrCreateDialect<DynamicContext>();
+}
+
 PYBIND11_MODULE(mlir, m) {
   mlir::py::getModule(m);
-  // ownership is given to MLIRContext
-  auto *ctx = mlir::py::getMLIRContext()->getOrCreateDialect<DynamicContext>();
+  getDynContext();
 
-  m.def("registerDynamicDialects", [ctx](ModuleOp module) {
+  m.def("registerDynamicDialects", [](ModuleOp module) {
+    auto *ctx = getDynContext();
     list ret;
     std::vector<StringRef> scope;
     for (auto dialectOp : module.getOps<DialectOp>()) {
@@ -31,4 +42,65 @@ PYBIND11_MODULE(mlir, m) {
     }
     return ret;
   });
+
+  // Report constraint expressions that are evaluated by the interpreter.
+  m.def("getInterpretedConstraints", &dmc::py::getInterpretedConstraints);
+
+  // Verify the functions of a module in parallel. The GIL is released while
+  // native-only ops are verified.
+  m.def("verifyParallel", [](ModuleOp module, unsigned threads) {
+    return succeeded(verifyParallel(module, threads));
+  }, arg("module"), arg("threads") = 0);
+
+  // Bytecode serialization of modules with dynamic ops. `ModuleOp` is
+  // exposed by pymlir, which does not know about dynamic dialects.
+  auto moduleCls = m.attr("ModuleOp");
+  setattr(moduleCls, "writeBytecode", cpp_function(
+      [](ModuleOp module, std::string filename) {
+        if (failed(writeBytecodeFile(module, filename)))
+          throw std::runtime_error{"Failed to write bytecode: " + filename};
+      }, name("writeBytecode"), is_method(moduleCls), arg("filename")));
+  m.def("parseBytecodeFile", [](std::string filename) {
+    auto module = parseBytecodeFile(filename, getDynContext());
+    if (!module)
+      throw std::invalid_argument{"Failed to parse bytecode: " + filename};
+    return module.release();
+  });
+
+  // Lazily loaded bytecode modules. Top-level symbols are indexed, so
+  // `lookup` is constant time, and each function body is read on first
+  // access. Printing and writing materialize the whole module first.
+  class_<LazyModule>(m, "LazyModule")
+      .def_property_readonly("module", &LazyModule::getModule,
+                             keep_alive<0, 1>())
+      .def("lookup", [](LazyModule &lazy, std::string name) {
+        return lazy.lookup(name);
+      }, return_value_policy::reference, keep_alive<0, 1>(), arg("name"))
+      .def("materialize", [](LazyModule &lazy, Operation *op) {
+        if (failed(lazy.materialize(op)))
+          throw std::runtime_error{"Failed to materialize op"};
+      }, arg("op"))
+      .def("materializeAll", [](LazyModule &lazy) {
+        if (failed(lazy.materializeAll()))
+          throw std::runtime_error{"Failed to materialize module"};
+      })
+      .def_property_readonly("numUnmaterialized",
+                             &LazyModule::getNumUnmaterialized)
+      .def("__str__", [](LazyModule &lazy) {
+        std::string buf;
+        llvm::raw_string_ostream os{buf};
+        if (failed(lazy.print(os)))
+          throw std::runtime_error{"Failed to materialize module"};
+        return os.str();
+      })
+      .def("writeBytecode", [](LazyModule &lazy, std::string filename) {
+        if (failed(lazy.writeBytecodeFile(filename)))
+          throw std::runtime_error{"Failed to write bytecode: " + filename};
+      }, arg("filename"));
+  m.def("loadBytecodeFile", [](std::string filename) {
+    auto lazy = LazyModule::load(filename, getDynContext());
+    if (!lazy)
+      throw std::invalid_argument{"Failed to load bytecode: " + filename};
+    return lazy;
+  });
 }
@@ -13,31 +13,12 @@ namespace py {
 
 namespace {
 
-template <typename SizedT, typename SameT, typename GetSingleFcn>
-ValueRange getGroup(OperationWrap &op, unsigned idx, GetSingleFcn getSingle) {
-  if (op.getSpec()->getTrait<SizedT>()) {
-    return SizedT::getGroup(op.getOp(), idx);
-  } else if (op.getSpec()->getTrait<SameT>()) {
-    return SameT::getGroup(op.getOp(), idx);
-  } else {
-    return getSingle(op.getOp(), idx);
-  }
-}
-
 ValueRange getOperandGroup(OperationWrap &op, unsigned idx) {
-  return getGroup<dmc::SizedOperandSegments, dmc::SameVariadicOperandSizes>(
-      op, idx, [](Operation *op, unsigned idx) {
-        auto it = std::next(op->operand_begin(), idx);
-        return OperandRange{it, std::next(it)};
-      });
+  return op.getSpec()->getOperandGroup(op.getOp(), idx);
 }
 
 ValueRange getResultGroup(OperationWrap &op, unsigned idx) {
-  return getGroup<dmc::SizedResultSegments, dmc::SameVariadicResultSizes>(
-      op, idx, [](Operation *op, unsigned idx) {
-        auto it = std::next(op->result_begin(), idx);
-        return ResultRange{it, std::next(it)};
-      });
+  return op.getSpec()->getResultGroup(op.getOp(), idx);
 }
 
 Value getOperand(OperationWrap &op, unsigned idx) {
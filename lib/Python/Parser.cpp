@@ -1,24 +1,68 @@
 #include "Context.h"
 #include "Utility.h"
+#include "dmc/Python/PyMLIR.h"
 
 #include <mlir/Parser.h>
+#include <mlir/IR/Diagnostics.h>
 #include <mlir/IR/Module.h>
 #include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/ThreadPool.h>
+#include <pybind11/pybind11.h>
 
 using namespace llvm;
 
 namespace mlir {
 namespace py {
 
-/// Parse a source file from a given filename. Provide a source manager and
-/// a diagnostic handler for the parse.
+/// Parse a source file from a given filename. Parse errors are reported with
+/// the source lines. Diagnostics emitted later, e.g. by the verifier, only
+/// refer to file locations.
 ModuleOp parseSourceFile(std::string filename) {
-  // TODO 100% a memory leak. The SourceMgr needs to be kept alive. Make python
-  // manage the lifetime of the SourceMgr.
-  auto *sourceMgr = new SourceMgr;
-  new SourceMgrDiagnosticHandler{*sourceMgr, getMLIRContext()};
-  auto ret = parseSourceFile(filename, *sourceMgr, getMLIRContext());
-  return ret.release();
+  SourceMgr sourceMgr;
+  SourceMgrDiagnosticHandler handler{sourceMgr, getMLIRContext()};
+  return mlir::parseSourceFile(filename, sourceMgr, getMLIRContext())
+      .release();
+}
+
+/// Parse source files concurrently into the context. Modules are returned
+/// in order, with null modules for files that failed to parse, and
+/// diagnostics are reported in file order.
+std::vector<ModuleOp> parseSourceFiles(std::vector<std::string> filenames,
+                                       unsigned threads) {
+  auto *ctx = getMLIRContext();
+  std::vector<ModuleOp> modules(filenames.size());
+  /// The handler loads the source lines of a diagnostic from its file.
+  SourceMgr sourceMgr;
+  SourceMgrDiagnosticHandler handler{sourceMgr, ctx};
+  {
+    ParallelDiagnosticHandler parallelHandler{ctx};
+    /// Dynamic ops with Python formats take the GIL while they are parsed.
+    pybind11::gil_scoped_release release;
+    ThreadPool pool{hardware_concurrency(threads)};
+    for (unsigned i = 0, e = filenames.size(); i < e; ++i) {
+      pool.async([&, i] {
+        /// The order ID must be erased even if the parse throws.
+        struct OrderIDScope {
+          OrderIDScope(ParallelDiagnosticHandler &handler, unsigned id)
+              : handler{handler} { handler.setOrderIDForThread(id); }
+          ~OrderIDScope() { handler.eraseOrderIDForThread(); }
+          ParallelDiagnosticHandler &handler;
+        } orderID{parallelHandler, i};
+        ContextScope scope{ctx};
+        SourceMgr fileSourceMgr;
+        /// Exceptions from Python parsers would be lost in the task's future.
+        try {
+          modules[i] = mlir::parseSourceFile(filenames[i], fileSourceMgr, ctx)
+              .release();
+        } catch (const std::exception &e) {
+          emitError(FileLineColLoc::get(filenames[i], 0, 0, ctx))
+              << "failed to parse '" << filenames[i] << "': " << e.what();
+        }
+      });
+    }
+    pool.wait();
+  }
+  return modules;
 }
 
 } // end namespace py
@@ -4,6 +4,8 @@ namespace mlir {
 namespace py {
 
 ModuleOp parseSourceFile(std::string filename);
+std::vector<ModuleOp> parseSourceFiles(std::vector<std::string> filenames,
+                                       unsigned threads);
 
 } // end namespace py
 } // end namespace mlir
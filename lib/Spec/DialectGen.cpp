@@ -12,6 +12,13 @@
 #include "dmc/Embed/TypeFormatGen.h"
 #include "dmc/Embed/InMemoryDef.h"
 #include "dmc/Embed/Expose.h"
+#include "dmc/Embed/SpecCache.h"
+#include "dmc/Embed/PatternCompiler.h"
+
+#include <mlir/IR/Diagnostics.h>
+#include <llvm/Support/Parallel.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/xxhash.h>
 
 using namespace mlir;
 
@@ -22,9 +29,45 @@ unsigned countNonVariadicValues(TypeRange tys) {
   return llvm::count_if(tys, [](Type ty) { return !ty.isa<VariadicType>(); });
 }
 
-LogicalResult registerOp(OperationOp opOp, DynamicDialect *dialect) {
+/// Check that the targets of value memory effects name operands or results.
+template <typename TraitT>
+LogicalResult verifyEffectTargets(OperationOp opOp, DynamicOperation *op) {
+  auto *trait = op->getTrait<TraitT>();
+  if (!trait)
+    return success();
+  auto opTy = opOp.getOpType();
+  auto hasName = [](ArrayRef<NamedType> values, StringRef name) {
+    return llvm::any_of(values, [name](const NamedType &value)
+                        { return value.name == name; });
+  };
+  for (auto target : trait->getTargets()) {
+    if (!hasName(opTy.getOperands(), target) &&
+        !hasName(opTy.getResults(), target))
+      return opOp.emitOpError("memory effect target '") << target
+          << "' is neither an operand nor a result";
+  }
+  return success();
+}
+
+namespace {
+/// An op prepared for registration. The op is built serially, in spec order,
+/// but its format is generated in parallel. The generated Python is collected
+/// and executed in one batch before the ops are committed.
+struct PreparedOp {
+  OperationOp opOp;
+  std::unique_ptr<DynamicOperation> op{};
+  /// The generated parser and printer, if the op has a custom format.
+  std::string parserName{}, printerName{};
+  std::string source{};
+};
+} // end anonymous namespace
+
+/// Build the dynamic op of a reparsed op spec and its traits.
+static LogicalResult buildOp(PreparedOp &prepared, DynamicDialect *dialect) {
+  auto opOp = prepared.opOp;
   /// Create the dynamic op.
-  auto op = dialect->createDynamicOp(opOp.getName());
+  auto &op = prepared.op;
+  op = dialect->createDynamicOp(opOp.getName());
 
   /// Process user-defined traits.
   auto *registry = dialect->getContext()
@@ -95,17 +138,65 @@ LogicalResult registerOp(OperationOp opOp, DynamicDialect *dialect) {
   op->addOpTrait<RegionConstraintTrait>(opRegions);
   op->addOpTrait<SuccessorConstraintTrait>(opSuccs);
 
-  /// Generate a custom op format, if one is specified.
+  /// Memory effects are resolved to operand and result groups on finalize.
+  if (failed(verifyEffectTargets<Alloc>(opOp, op.get())) ||
+      failed(verifyEffectTargets<Free>(opOp, op.get())) ||
+      failed(verifyEffectTargets<ReadFrom>(opOp, op.get())) ||
+      failed(verifyEffectTargets<WriteTo>(opOp, op.get())))
+    return failure();
+
+  /// Compile the native fold. The Python fold must already be defined, but it
+  /// is looked up when called.
+  auto foldExprs = opOp.getFoldExprs();
+  std::unique_ptr<py::NativeFold> fold;
+  if (!foldExprs.empty()) {
+    fold = py::NativeFold::compile(opOp.getLoc(), foldExprs, opTy,
+                                   opOp.getOpAttrs());
+    if (!fold)
+      return failure();
+  }
+  auto pyFold = opOp.getPyFold().getValueOr("").str();
+  if (!pyFold.empty() && failed(py::checkPyFold(opOp.getLoc(), pyFold)))
+    return failure();
+  op->setFold(std::move(fold), std::move(pyFold));
+  return success();
+}
+
+/// Generate the Python parser and printer of an op with a custom format. Only
+/// the spec op is read, so ops are generated in parallel. If the dialect is
+/// cached, the format is already defined.
+static LogicalResult generateOp(PreparedOp &prepared, DynamicDialect *dialect,
+                                bool generate) {
+  auto opOp = prepared.opOp;
   if (opOp.getAssemblyFormat()) {
     auto prefix = ("__" + dialect->getNamespace() + "__op__" +
                    opOp.getName()).str();
-    auto parserName = "parse" + prefix;
-    auto printerName = "print" + prefix;
-    py::InMemoryDef parser{parserName, "(parser, result)"};
-    py::InMemoryDef printer{printerName, "(p, op)"};
+    prepared.parserName = "parse" + prefix;
+    prepared.printerName = "print" + prefix;
+    if (!generate)
+      return success();
+    py::DeferredDef parser{prepared.parserName, "(parser, result)"};
+    py::DeferredDef printer{prepared.printerName, "(p, op)"};
     if (failed(generateOpFormat(opOp, parser.stream(), printer.stream())))
       return failure();
-    op->setOpFormat(std::move(parserName), std::move(printerName));
+    prepared.source = parser.finish() + printer.finish();
+  }
+  return success();
+}
+
+/// Register a prepared op once its Python functions have been defined.
+static LogicalResult commitOp(PreparedOp &prepared, DynamicDialect *dialect) {
+  auto opOp = prepared.opOp;
+  auto &op = prepared.op;
+  if (!prepared.parserName.empty()) {
+    if (failed(op->setOpFormat(opOp.getLoc(), std::move(prepared.parserName),
+                               std::move(prepared.printerName))))
+      return failure();
+    /// Formats that cannot be compiled natively keep the Python backend.
+    if (dialect->getFormatBackend() == py::FormatBackend::Native) {
+      if (auto native = compileOpFormat(opOp))
+        op->setNativeOpFormat(std::move(native));
+    }
   }
 
   /// Finally, register the Op.
@@ -118,38 +209,54 @@ LogicalResult registerOp(OperationOp opOp, DynamicDialect *dialect) {
 
 template <typename OpT, typename DynamicT>
 LogicalResult generateFormat(StringRef dialect, OpT op, DynamicT *impl,
-                             const char *val) {
+                             const char *val, py::SpecCache &cache) {
   auto prefix = ("__" + dialect + "__" + val + "__" + op.getName()).str();
   auto parserName = "parse" + prefix;
   auto printerName = "print" + prefix;
-  py::InMemoryDef parser{parserName, "(parser, result)"};
-  py::InMemoryDef printer{printerName, "(p, type)"};
-  if (failed(generateTypeFormat(op, impl, parser.stream(), printer.stream())))
+  /// Later specs may use the format, so it is defined immediately. If the
+  /// dialect is cached, the format is already defined.
+  if (!cache.isWarm()) {
+    py::DeferredDef parser{parserName, "(parser, result)"};
+    py::DeferredDef printer{printerName, "(p, type)"};
+    if (failed(generateTypeFormat(op, impl, parser.stream(),
+                                  printer.stream())))
+      return failure();
+    auto source = parser.finish() + printer.finish();
+    py::execDefs(source);
+    cache.addSource("formats", source);
+  }
+  if (failed(impl->setFormat(op.getLoc(), std::move(parserName),
+                             std::move(printerName))))
     return failure();
-  impl->setFormat(std::move(parserName), std::move(printerName));
+  if (impl->getDialect()->getFormatBackend() == py::FormatBackend::Native)
+    impl->setNativeFormat(compileTypeFormat(op, impl));
   return success();
 }
 
-LogicalResult registerType(TypeOp typeOp, DynamicDialect *dialect) {
+LogicalResult registerType(TypeOp typeOp, DynamicDialect *dialect,
+                           py::SpecCache &cache) {
   if (failed(dialect->createDynamicType(typeOp.getName(),
                                         typeOp.getParameters())))
     return typeOp.emitOpError("a type with this name already exists");
 
   if (typeOp.getAssemblyFormat()) {
     auto *impl = dialect->lookupType(typeOp.getName());
-    return generateFormat(dialect->getNamespace(), typeOp, impl, "type");
+    return generateFormat(dialect->getNamespace(), typeOp, impl, "type",
+                          cache);
   }
   return success();
 }
 
-LogicalResult registerAttr(AttributeOp attrOp, DynamicDialect *dialect) {
+LogicalResult registerAttr(AttributeOp attrOp, DynamicDialect *dialect,
+                           py::SpecCache &cache) {
   if (failed(dialect->createDynamicAttr(attrOp.getName(),
                                         attrOp.getParameters())))
     return attrOp.emitOpError("an attribute with this name already exists");
 
   if (attrOp.getAssemblyFormat()) {
     auto *impl = dialect->lookupAttr(attrOp.getName());
-    return generateFormat(dialect->getNamespace(), attrOp, impl, "attr");
+    return generateFormat(dialect->getNamespace(), attrOp, impl, "attr",
+                          cache);
   }
   return success();
 }
@@ -174,43 +281,179 @@ LogicalResult registerAlias(AliasOp aliasOp, DynamicDialect *dialect) {
   return success();
 }
 
-LogicalResult registerDialect(DialectOp dialectOp, DynamicContext *ctx,
-                              ArrayRef<StringRef> scope) {
+namespace {
+/// A dialect whose types, attributes, and aliases are registered and whose
+/// ops are pending.
+struct PendingDialect {
+  DynamicDialect *dialect;
+  std::vector<PreparedOp> ops{};
+  /// Patterns are compiled once the ops they refer to are registered.
+  std::vector<PatternOp> patterns{};
+  /// The Python code generated for the dialect.
+  std::unique_ptr<py::SpecCache> cache{};
+};
+} // end anonymous namespace
+
+/// Fingerprint a dialect spec as written, before any of its ops are reparsed.
+static uint64_t hashSpec(DialectOp dialectOp) {
+  std::string buf;
+  llvm::raw_string_ostream os{buf};
+  dialectOp.print(os);
+  return llvm::xxHash64(os.str());
+}
+
+/// Create the dynamic dialect and register its types, attributes, and
+/// aliases, and build its ops, in order. Op formats are generated later.
+static LogicalResult registerDialectSymbols(DialectOp dialectOp,
+                                            DynamicContext *ctx,
+                                            PendingDialect &pending) {
   /// Create the dynamic dialect
   auto *dialect = ctx->createDynamicDialect(dialectOp.getName());
   dialect->allowUnknownOperations(dialectOp.allowsUnknownOps());
   dialect->allowUnknownTypes(dialectOp.allowsUnknownTypes());
+  if (auto backend = dialectOp.getFormatBackend())
+    dialect->setFormatBackend(*py::symbolizeFormatBackend(*backend));
+  else
+    dialect->setFormatBackend(py::getDefaultFormatBackend());
+  dialect->setSpecHash(hashSpec(dialectOp));
+  pending.dialect = dialect;
+
+  /// Define the cached type and attribute formats before they are used.
+  pending.cache = std::make_unique<py::SpecCache>(dialect->getNamespace(),
+                                                  dialect->getSpecHash());
+  auto &cache = *pending.cache;
+  cache.execDefs("formats");
 
   /// Walk the children operations.
   for (auto &specOp : dialectOp) {
+    if (auto patternOp = dyn_cast<PatternOp>(&specOp)) {
+      pending.patterns.push_back(patternOp);
+      continue;
+    }
     /// If the op can be reparsed, do so.
     if (auto reparseOp = dyn_cast<ReparseOpInterface>(&specOp))
       if (failed(reparseOp.reparse()))
         return failure();
     /// Op-specific actions.
     if (auto opOp = dyn_cast<OperationOp>(&specOp)) {
-      if (failed(registerOp(opOp, dialect)))
+      pending.ops.push_back({opOp});
+      if (failed(buildOp(pending.ops.back(), dialect)))
         return failure();
     } else if (auto typeOp = dyn_cast<TypeOp>(&specOp)) {
-      if (failed(registerType(typeOp, dialect)))
+      if (failed(registerType(typeOp, dialect, cache)))
         return failure();
     } else if (auto attrOp = dyn_cast<AttributeOp>(&specOp)) {
-      if (failed(registerAttr(attrOp, dialect)))
+      if (failed(registerAttr(attrOp, dialect, cache)))
         return failure();
     } else if (auto aliasOp = dyn_cast<AliasOp>(&specOp)) {
       if (failed(registerAlias(aliasOp, dialect)))
         return failure();
     }
   }
-  py::exposeDialectInternal(dialect, scope);
   return success();
 }
 
+/// Generate the op formats of the pending dialects in parallel, then define
+/// all of their Python functions at once.
+static LogicalResult generateOps(MLIRContext *ctx,
+                                 MutableArrayRef<PendingDialect> pending) {
+  std::vector<std::pair<PreparedOp *, PendingDialect *>> ops;
+  for (auto &dialect : pending) {
+    for (auto &op : dialect.ops)
+      ops.emplace_back(&op, &dialect);
+  }
+
+  /// Diagnostics are reported in op order. Generation does not call into
+  /// Python, so the workers do not need the GIL.
+  std::vector<char> failures(ops.size());
+  {
+    ParallelDiagnosticHandler handler{ctx};
+    llvm::parallelForEachN(0, ops.size(), [&](std::size_t i) {
+      handler.setOrderIDForThread(i);
+      auto [op, dialect] = ops[i];
+      try {
+        failures[i] = failed(generateOp(*op, dialect->dialect,
+                                        !dialect->cache->isWarm()));
+      } catch (const std::exception &e) {
+        op->opOp.emitOpError("failed to generate format: ") << e.what();
+        failures[i] = true;
+      }
+      handler.eraseOrderIDForThread();
+    });
+  }
+  if (llvm::is_contained(failures, true))
+    return failure();
+
+  /// Cached op formats are defined with the rest of the dialect's code.
+  std::string source;
+  for (auto [op, dialect] : ops) {
+    source += op->source;
+    dialect->cache->addSource("ops", op->source);
+  }
+  if (!source.empty())
+    py::execDefs(source);
+  for (auto &dialect : pending)
+    dialect.cache->execDefs("ops");
+  return success();
+}
+
+/// Register the prepared ops of a dialect and expose it to Python.
+static LogicalResult commitDialect(PendingDialect &pending,
+                                   ArrayRef<StringRef> scope) {
+  for (auto &op : pending.ops) {
+    if (failed(commitOp(op, pending.dialect)))
+      return failure();
+  }
+  py::exposeDialectInternal(pending.dialect, scope, *pending.cache);
+  pending.cache->save();
+  return success();
+}
+
+/// Compile the patterns of a dialect. Patterns may refer to the ops of any
+/// dialect, so this is done after all ops are committed.
+static LogicalResult compilePatterns(PendingDialect &pending) {
+  for (auto patternOp : pending.patterns) {
+    auto pattern = py::NativePattern::compile(
+        patternOp.getLoc(), patternOp.getName(), patternOp.getSource(),
+        patternOp.getRewrite(), patternOp.getBenefit());
+    if (!pattern)
+      return failure();
+    pending.dialect->addPattern(std::move(pattern));
+  }
+  return success();
+}
+
+LogicalResult registerDialect(DialectOp dialectOp, DynamicContext *ctx,
+                              ArrayRef<StringRef> scope) {
+  PendingDialect pending;
+  if (failed(registerDialectSymbols(dialectOp, ctx, pending)) ||
+      failed(generateOps(ctx->getContext(), pending)) ||
+      failed(commitDialect(pending, scope)))
+    return failure();
+  return compilePatterns(pending);
+}
+
 LogicalResult registerAllDialects(ModuleOp dialects, DynamicContext *ctx) {
-  std::vector<StringRef> scope;
+  /// Specs may refer to the symbols of earlier dialects and are registered
+  /// serially. The op formats of all dialects are then generated together.
+  std::vector<PendingDialect> pending;
   for (auto dialectOp : dialects.getOps<DialectOp>()) {
+    pending.emplace_back();
+    if (failed(registerDialectSymbols(dialectOp, ctx, pending.back())))
+      return failure();
+  }
+  if (failed(generateOps(ctx->getContext(), pending)))
+    return failure();
+
+  std::vector<StringRef> scope;
+  for (auto [dialectOp, dialect] :
+       llvm::zip(dialects.getOps<DialectOp>(), pending)) {
     scope.push_back(dialectOp.getName());
-    if (failed(registerDialect(dialectOp, ctx, scope)))
+    if (failed(commitDialect(dialect, scope)))
+      return failure();
+  }
+  for (auto &dialect : pending) {
+    if (failed(compilePatterns(dialect)))
       return failure();
   }
   return success();
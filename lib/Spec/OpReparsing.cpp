@@ -1,6 +1,17 @@
 #include "dmc/Spec/SpecOps.h"
+#include "dmc/Spec/SpecTypes.h"
+#include "dmc/Spec/SpecAttrs.h"
+#include "dmc/Spec/SymbolResolver.h"
+#include "dmc/Dynamic/Alias.h"
+#include "dmc/Dynamic/DynamicContext.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicType.h"
+#include "dmc/Dynamic/DynamicAttribute.h"
 
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/StandardTypes.h>
 #include <mlir/Parser.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/Support/raw_ostream.h>
 
 using namespace mlir;
@@ -28,15 +39,283 @@ Attribute reparseAttr(Attribute attr) {
 }
 } // end namespace impl
 
+/// SymbolResolver implementation.
+namespace {
+/// Check if an opaque payload is a bare symbol name, which the dynamic dialect
+/// parser would read as a single keyword.
+bool isBareSymbol(StringRef data) {
+  if (data.empty() || !(llvm::isAlpha(data.front()) || data.front() == '_'))
+    return false;
+  return llvm::all_of(data.drop_front(), [](char c) {
+    return llvm::isAlnum(c) || c == '_' || c == '$' || c == '.';
+  });
+}
+
+/// Resolve the children of a type or attribute and rebuild it only if a child
+/// was replaced. Returns null if a child could not be resolved.
+template <typename BaseT, typename ChildT, typename BuildFn>
+BaseT rebuild(SymbolResolver &resolver, BaseT base, ArrayRef<ChildT> children,
+              BuildFn &&build) {
+  SmallVector<ChildT, 4> newChildren;
+  newChildren.reserve(children.size());
+  bool changed = false;
+  for (auto child : children) {
+    auto newChild = resolver.resolve(child);
+    if (!newChild)
+      return {};
+    changed |= newChild != child;
+    newChildren.push_back(newChild);
+  }
+  if (!changed)
+    return base;
+  return build(ArrayRef<ChildT>{newChildren});
+}
+} // end anonymous namespace
+
+SymbolResolver::SymbolResolver(Location loc)
+    : loc{loc},
+      ctx{loc.getContext()->getRegisteredDialect<DynamicContext>()} {}
+
+Type SymbolResolver::resolve(Type type) {
+  auto it = types.find(type);
+  if (it != std::end(types))
+    return it->second;
+  auto newType = resolveType(type);
+  types.try_emplace(type, newType);
+  return newType;
+}
+
+Attribute SymbolResolver::resolve(Attribute attr) {
+  auto it = attrs.find(attr);
+  if (it != std::end(attrs))
+    return it->second;
+  auto newAttr = resolveAttr(attr);
+  attrs.try_emplace(attr, newAttr);
+  return newAttr;
+}
+
+Type SymbolResolver::resolveType(Type type) {
+  if (type.isa<mlir::OpaqueType>())
+    return resolveOpaqueType(type);
+
+  /// Spec type constraints that contain types.
+  if (auto anyOfTy = type.dyn_cast<AnyOfType>())
+    return rebuild(*this, type, anyOfTy.getTypes(), [&](ArrayRef<Type> tys)
+                   { return AnyOfType::getChecked(loc, tys); });
+  if (auto allOfTy = type.dyn_cast<AllOfType>())
+    return rebuild(*this, type, allOfTy.getTypes(), [&](ArrayRef<Type> tys)
+                   { return AllOfType::getChecked(loc, tys); });
+  if (auto complexTy = type.dyn_cast<ComplexType>()) {
+    auto elTy = complexTy.getElementType();
+    return rebuild(*this, type, llvm::makeArrayRef(elTy),
+                   [&](ArrayRef<Type> tys)
+                   { return ComplexType::getChecked(loc, tys.front()); });
+  }
+  if (auto variadicTy = type.dyn_cast<VariadicType>()) {
+    auto baseTy = variadicTy.getBaseType();
+    return rebuild(*this, type, llvm::makeArrayRef(baseTy),
+                   [&](ArrayRef<Type> tys)
+                   { return VariadicType::get(tys.front()); });
+  }
+  /// Other spec types and dynamic types have nothing to resolve.
+  if (SpecTypes::is(type) || type.isa<DynamicType>())
+    return type;
+
+  /// Builtin types that may contain dynamic types.
+  if (auto fcnTy = type.dyn_cast<mlir::FunctionType>()) {
+    SmallVector<Type, 8> fcnTys(fcnTy.getInputs().begin(),
+                                fcnTy.getInputs().end());
+    fcnTys.append(fcnTy.getResults().begin(), fcnTy.getResults().end());
+    auto numInputs = fcnTy.getNumInputs();
+    return rebuild(*this, type, ArrayRef<Type>{fcnTys},
+                   [&](ArrayRef<Type> tys) {
+      return mlir::FunctionType::get(tys.take_front(numInputs),
+                                     tys.drop_front(numInputs),
+                                     type.getContext());
+    });
+  }
+  if (auto tupleTy = type.dyn_cast<mlir::TupleType>())
+    return rebuild(*this, type, tupleTy.getTypes(), [&](ArrayRef<Type> tys)
+                   { return mlir::TupleType::get(tys, type.getContext()); });
+  if (auto tensorTy = type.dyn_cast<mlir::RankedTensorType>()) {
+    auto elTy = tensorTy.getElementType();
+    return rebuild(*this, type, llvm::makeArrayRef(elTy),
+                   [&](ArrayRef<Type> tys) {
+      return mlir::RankedTensorType::get(tensorTy.getShape(), tys.front());
+    });
+  }
+  if (auto tensorTy = type.dyn_cast<mlir::UnrankedTensorType>()) {
+    auto elTy = tensorTy.getElementType();
+    return rebuild(*this, type, llvm::makeArrayRef(elTy),
+                   [&](ArrayRef<Type> tys)
+                   { return mlir::UnrankedTensorType::get(tys.front()); });
+  }
+  /// Builtin types that cannot contain dynamic types.
+  if (type.isa<mlir::IntegerType>() || type.isa<mlir::FloatType>() ||
+      type.isa<mlir::IndexType>() || type.isa<mlir::NoneType>() ||
+      type.isa<mlir::VectorType>() || type.isa<mlir::ComplexType>())
+    return type;
+
+  /// Fall back to reparsing anything else.
+  return reparse(type);
+}
+
+Attribute SymbolResolver::resolveAttr(Attribute attr) {
+  if (attr.isa<mlir::OpaqueAttr>())
+    return resolveOpaqueAttr(attr);
+
+  /// Spec attribute constraints that contain types or attributes.
+  if (auto arrayOfAttr = attr.dyn_cast<ArrayOfAttr>()) {
+    auto constraint = arrayOfAttr.getConstraint();
+    return rebuild(*this, attr, llvm::makeArrayRef(constraint),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return ArrayOfAttr::getChecked(loc, attrs.front()); });
+  }
+  if (auto constAttr = attr.dyn_cast<ConstantAttr>()) {
+    auto value = constAttr.getValue();
+    return rebuild(*this, attr, llvm::makeArrayRef(value),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return ConstantAttr::get(attrs.front()); });
+  }
+  if (auto anyOfAttr = attr.dyn_cast<AnyOfAttr>())
+    return rebuild(*this, attr, anyOfAttr.getAttrs(),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return AnyOfAttr::getChecked(loc, attrs); });
+  if (auto allOfAttr = attr.dyn_cast<AllOfAttr>())
+    return rebuild(*this, attr, allOfAttr.getAttrs(),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return AllOfAttr::getChecked(loc, attrs); });
+  if (auto optAttr = attr.dyn_cast<OptionalAttr>()) {
+    auto baseAttr = optAttr.getBaseAttr();
+    return rebuild(*this, attr, llvm::makeArrayRef(baseAttr),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return OptionalAttr::get(attrs.front()); });
+  }
+  if (auto defaultAttr = attr.dyn_cast<DefaultAttr>()) {
+    Attribute children[] = {defaultAttr.getBaseAttr(),
+                            defaultAttr.getDefaultValue()};
+    return rebuild(*this, attr, llvm::makeArrayRef(children),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return DefaultAttr::get(attrs[0], attrs[1]); });
+  }
+  if (auto ofTypeAttr = attr.dyn_cast<OfTypeAttr>()) {
+    auto type = ofTypeAttr.getConstraintType();
+    return rebuild(*this, attr, llvm::makeArrayRef(type),
+                   [&](ArrayRef<Type> tys)
+                   { return OfTypeAttr::get(tys.front()); });
+  }
+  if (auto elementsOfAttr = attr.dyn_cast<ElementsOfAttr>()) {
+    auto elTy = elementsOfAttr.getElementType();
+    return rebuild(*this, attr, llvm::makeArrayRef(elTy),
+                   [&](ArrayRef<Type> tys)
+                   { return ElementsOfAttr::get(tys.front()); });
+  }
+  /// Other spec attributes and dynamic attributes have nothing to resolve.
+  if (SpecAttrs::is(attr) || attr.isa<DynamicAttribute>())
+    return attr;
+
+  /// Builtin attributes that may contain dynamic types or attributes.
+  if (auto arrAttr = attr.dyn_cast<mlir::ArrayAttr>())
+    return rebuild(*this, attr, arrAttr.getValue(),
+                   [&](ArrayRef<Attribute> attrs)
+                   { return mlir::ArrayAttr::get(attrs, attr.getContext()); });
+  if (auto dictAttr = attr.dyn_cast<mlir::DictionaryAttr>()) {
+    SmallVector<Attribute, 4> values;
+    for (auto namedAttr : dictAttr.getValue())
+      values.push_back(namedAttr.second);
+    return rebuild(*this, attr, ArrayRef<Attribute>{values},
+                   [&](ArrayRef<Attribute> attrs) {
+      NamedAttrList newAttrs;
+      for (auto it : llvm::zip(dictAttr.getValue(), attrs))
+        newAttrs.push_back({std::get<0>(it).first, std::get<1>(it)});
+      return mlir::DictionaryAttr::get(newAttrs, attr.getContext());
+    });
+  }
+  if (auto typeAttr = attr.dyn_cast<mlir::TypeAttr>()) {
+    auto type = typeAttr.getValue();
+    return rebuild(*this, attr, llvm::makeArrayRef(type),
+                   [&](ArrayRef<Type> tys)
+                   { return mlir::TypeAttr::get(tys.front()); });
+  }
+  /// Builtin attributes that cannot contain dynamic types or attributes.
+  if (attr.isa<mlir::BoolAttr>() || attr.isa<mlir::IntegerAttr>() ||
+      attr.isa<mlir::FloatAttr>() || attr.isa<mlir::StringAttr>() ||
+      attr.isa<mlir::UnitAttr>() || attr.isa<mlir::SymbolRefAttr>() ||
+      attr.isa<mlir::ElementsAttr>() || attr.isa<mlir::AffineMapAttr>())
+    return attr;
+
+  /// Fall back to reparsing anything else.
+  return reparse(attr);
+}
+
+Type SymbolResolver::resolveOpaqueType(Type type) {
+  auto opaqueTy = type.cast<mlir::OpaqueType>();
+  auto dialectName = opaqueTy.getDialectNamespace().strref();
+  /// The dialect is still unknown. Reparsing would return the same type.
+  if (!type.getContext()->getRegisteredDialect(dialectName))
+    return type;
+
+  /// Look up bare symbol names in the dynamic dialect. Types with a custom
+  /// format might parse a bare name differently.
+  auto *dialect = ctx ? ctx->lookupDialect(dialectName) : nullptr;
+  auto name = opaqueTy.getTypeData();
+  if (dialect && isBareSymbol(name)) {
+    if (auto *typeAlias = dialect->lookupTypeAlias(name))
+      return typeAlias->getAliasedType();
+    auto *typeImpl = dialect->lookupType(name);
+    if (!typeImpl) {
+      emitError(loc) << "Unknown type name: " << name;
+      return {};
+    }
+    if (!typeImpl->hasCustomFormat())
+      return DynamicType::getChecked(loc, typeImpl, llvm::None);
+  }
+  return reparse(type);
+}
+
+Attribute SymbolResolver::resolveOpaqueAttr(Attribute attr) {
+  auto opaqueAttr = attr.cast<mlir::OpaqueAttr>();
+  auto dialectName = opaqueAttr.getDialectNamespace().strref();
+  if (!attr.getContext()->getRegisteredDialect(dialectName))
+    return attr;
+
+  /// Dynamic attributes are untyped.
+  auto *dialect = ctx ? ctx->lookupDialect(dialectName) : nullptr;
+  auto name = opaqueAttr.getAttrData();
+  if (dialect && attr.getType().isa<mlir::NoneType>() && isBareSymbol(name)) {
+    if (auto *attrAlias = dialect->lookupAttrAlias(name))
+      return attrAlias->getAliasedAttr();
+    auto *attrImpl = dialect->lookupAttr(name);
+    if (!attrImpl) {
+      emitError(loc) << "Unknown attribute name: " << name;
+      return {};
+    }
+    if (!attrImpl->hasCustomFormat())
+      return DynamicAttribute::getChecked(loc, attrImpl, llvm::None);
+  }
+  return reparse(attr);
+}
+
+Type SymbolResolver::reparse(Type type) {
+  ++numReparsed;
+  return impl::reparseType(type);
+}
+
+Attribute SymbolResolver::reparse(Attribute attr) {
+  ++numReparsed;
+  return impl::reparseAttr(attr);
+}
+
 /// OperationOp reparsing.
 namespace {
 template <typename NamedTypeRange, typename TypeContainerT>
-ParseResult reparseTypeRange(OperationOp op, NamedTypeRange types,
-                             TypeContainerT &newTypes, StringRef name) {
+ParseResult reparseTypeRange(OperationOp op, SymbolResolver &resolver,
+                             NamedTypeRange types, TypeContainerT &newTypes,
+                             StringRef name) {
   newTypes.reserve(llvm::size(types));
   unsigned idx = 0;
   for (auto ty : types) {
-    if (auto newType = impl::reparseType(ty.type)) {
+    if (auto newType = resolver.resolve(ty.type)) {
       newTypes.push_back({ty.name, newType});
     } else {
       return op.emitOpError("failed to parse type for ") << name
@@ -48,10 +327,10 @@ ParseResult reparseTypeRange(OperationOp op, NamedTypeRange types,
 }
 
 template <typename NamedAttrRange>
-ParseResult reparseNamedAttrs(OperationOp op, NamedAttrRange attrs,
-                              NamedAttrList &newAttrs) {
+ParseResult reparseNamedAttrs(OperationOp op, SymbolResolver &resolver,
+                              NamedAttrRange attrs, NamedAttrList &newAttrs) {
   for (auto [name, attr] : attrs) {
-    if (auto newAttr = impl::reparseAttr(attr)) {
+    if (auto newAttr = resolver.resolve(attr)) {
       newAttrs.push_back({name, newAttr});
     } else {
       return op.emitOpError("failed to parse attribute '") << name << '\'';
@@ -63,10 +342,12 @@ ParseResult reparseNamedAttrs(OperationOp op, NamedAttrRange attrs,
 
 ParseResult OperationOp::reparse() {
   /// Reparse operation type. Names will remain the same.
+  SymbolResolver resolver{getLoc()};
   auto opTy = getOpType();
   SmallVector<NamedType, 4> argTys, retTys;
-  if (reparseTypeRange(*this, opTy.getOperands(), argTys, "operand") ||
-      reparseTypeRange(*this, opTy.getResults(), retTys, "result"))
+  if (reparseTypeRange(*this, resolver, opTy.getOperands(), argTys,
+                       "operand") ||
+      reparseTypeRange(*this, resolver, opTy.getResults(), retTys, "result"))
     return failure();
   auto newOpTy = OpType::getChecked(getLoc(), argTys, retTys);
   if (newOpTy != opTy)
@@ -75,7 +356,7 @@ ParseResult OperationOp::reparse() {
   /// Reparse operation attributes.
   auto opAttrs = getOpAttrs();
   NamedAttrList attrs;
-  if (failed(reparseNamedAttrs(*this, opAttrs.getValue(), attrs)))
+  if (failed(reparseNamedAttrs(*this, resolver, opAttrs.getValue(), attrs)))
     return failure();
   auto newOpAttrs = mlir::DictionaryAttr::get(attrs, getContext());
   if (newOpAttrs != opAttrs)
@@ -89,11 +370,12 @@ template <typename OpT, typename ParamRange, typename ParamListT>
 ParseResult reparseParameters(OpT op, ParamRange params,
                               ParamListT &newParams) {
   using mlir::NamedParameter;
+  SymbolResolver resolver{op.getLoc()};
   newParams.reserve(llvm::size(params));
   unsigned idx = 0;
   for (auto paramAttr : params) {
     auto param = paramAttr.template cast<NamedParameter>();
-    if (auto newParam = impl::reparseAttr(param.getConstraint())) {
+    if (auto newParam = resolver.resolve(param.getConstraint())) {
       newParams.push_back(NamedParameter::get(param.getName(), newParam));
     } else {
       return op.emitOpError("failed to parse parameter #") << idx;
@@ -126,14 +408,15 @@ ParseResult AttributeOp::reparse() {
 /// AliasOp reparsing.
 ParseResult AliasOp::reparse() {
   /// Reparse either the aliased type or attribute.
+  SymbolResolver resolver{getLoc()};
   if (auto type = getAliasedType()) {
-    if (auto newType = impl::reparseType(type)) {
+    if (auto newType = resolver.resolve(type)) {
       setAttr(getAliasedTypeAttrName(), mlir::TypeAttr::get(newType));
     } else {
       return emitOpError("failed to parse aliased type");
     }
   } else {
-    if (auto newAttr = impl::reparseAttr(getAliasedAttr())) {
+    if (auto newAttr = resolver.resolve(getAliasedAttr())) {
       setAttr(getAliasedAttributeAttrName(), newAttr);
     } else {
       return emitOpError("failed to parse aliased attribute");
@@ -141,7 +424,7 @@ ParseResult AliasOp::reparse() {
   }
   /// Reparse the type if it exists.
   if (auto type = getAttrType()) {
-    if (auto newType = impl::reparseType(type)) {
+    if (auto newType = resolver.resolve(type)) {
       setAttr(getTypeAttrName(), mlir::TypeAttr::get(newType));
     } else {
       return emitOpError("failed to parse attribute type");
@@ -19,6 +19,28 @@ LogicalResult delegateVerify(Attribute base, Attribute attr) {
   return SpecAttrs::kindSwitch(action, base);
 }
 
+bool isInterpreted(Attribute base) {
+  if (!is(base))
+    return false;
+  if (auto pyAttr = base.dyn_cast<PyAttr>())
+    return !pyAttr.isNative();
+  if (auto anyOf = base.dyn_cast<AnyOfAttr>())
+    return llvm::any_of(anyOf.getAttrs(), isInterpreted);
+  if (auto allOf = base.dyn_cast<AllOfAttr>())
+    return llvm::any_of(allOf.getAttrs(), isInterpreted);
+  if (auto arrayOf = base.dyn_cast<ArrayOfAttr>())
+    return isInterpreted(arrayOf.getConstraint());
+  if (auto optional = base.dyn_cast<OptionalAttr>())
+    return isInterpreted(optional.getBaseAttr());
+  if (auto def = base.dyn_cast<DefaultAttr>())
+    return isInterpreted(def.getBaseAttr());
+  if (auto ofType = base.dyn_cast<OfTypeAttr>())
+    return SpecTypes::isInterpreted(ofType.getConstraintType());
+  if (auto elementsOf = base.dyn_cast<ElementsOfAttr>())
+    return SpecTypes::isInterpreted(elementsOf.getElementType());
+  return false;
+}
+
 } // end namespace SpecAttrs
 
 namespace impl {
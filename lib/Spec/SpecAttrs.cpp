@@ -141,6 +141,8 @@ ElementsOfAttr ElementsOfAttr::get(Type elTy) {
   return Base::get(elTy.getContext(), Kind, elTy);
 }
 
+Type ElementsOfAttr::getElementType() { return getImpl()->type; }
+
 LogicalResult ElementsOfAttr::verify(Attribute attr) {
   if (auto elementsAttr = attr.dyn_cast<mlir::ElementsAttr>()) {
     auto baseTy = getImpl()->type;
@@ -176,6 +178,8 @@ ArrayOfAttr ArrayOfAttr::getChecked(Location loc, Attribute constraint) {
   return Base::getChecked(loc, Kind, constraint);
 }
 
+Attribute ArrayOfAttr::getConstraint() { return getImpl()->attr; }
+
 LogicalResult ArrayOfAttr::verifyConstructionInvariants(Location loc,
                                                         Attribute constraint) {
   if (!SpecAttrs::is(constraint))
@@ -198,6 +202,8 @@ ConstantAttr ConstantAttr::get(Attribute attr) {
   return Base::get(attr.getContext(), Kind, attr);
 }
 
+Attribute ConstantAttr::getValue() { return getImpl()->attr; }
+
 LogicalResult ConstantAttr::verify(Attribute attr) {
   return success(attr == getImpl()->attr);
 }
@@ -224,6 +230,8 @@ AnyOfAttr AnyOfAttr::getChecked(Location loc, ArrayRef<Attribute> attrs) {
   return Base::getChecked(loc, Kind, getSortedAttrs(attrs));
 }
 
+ArrayRef<Attribute> AnyOfAttr::getAttrs() { return getImpl()->attrs; }
+
 LogicalResult AnyOfAttr::verifyConstructionInvariants(
     Location loc, ArrayRef<Attribute> attrs) {
   return impl::verifyAttrList(loc, attrs);
@@ -242,6 +250,8 @@ AllOfAttr AllOfAttr::getChecked(Location loc, ArrayRef<Attribute> attrs) {
   return Base::getChecked(loc, Kind, getSortedAttrs(attrs));
 }
 
+ArrayRef<Attribute> AllOfAttr::getAttrs() { return getImpl()->attrs; }
+
 LogicalResult AllOfAttr::verifyConstructionInvariants(
     Location loc, ArrayRef<Attribute> attrs) {
   return impl::verifyAttrList(loc, attrs);
@@ -260,6 +270,8 @@ OfTypeAttr OfTypeAttr::get(Type ty) {
   return Base::get(ty.getContext(), Kind, ty);
 }
 
+Type OfTypeAttr::getConstraintType() { return getImpl()->type; }
+
 LogicalResult OfTypeAttr::verify(Attribute attr) {
   return SpecTypes::delegateVerify(getImpl()->type, attr.getType());
 }
@@ -269,6 +281,8 @@ OptionalAttr OptionalAttr::get(Attribute baseAttr) {
   return Base::get(baseAttr.getContext(), Kind, baseAttr);
 }
 
+Attribute OptionalAttr::getBaseAttr() { return getImpl()->attr; }
+
 /// TODO assert that this constraint is top-level
 LogicalResult OptionalAttr::verify(Attribute attr) {
   if (!attr) // null attribute is acceptable
@@ -289,6 +303,10 @@ LogicalResult DefaultAttr::verify(Attribute attr) {
   return success(baseAttr == attr);
 }
 
+Attribute DefaultAttr::getBaseAttr() {
+  return getImpl()->baseAttr;
+}
+
 Attribute DefaultAttr::getDefaultValue() {
   return getImpl()->defaultAttr;
 }
@@ -18,7 +18,7 @@ SpecDialect::SpecDialect(MLIRContext *ctx)
     : Dialect{getDialectNamespace(), ctx, TypeID::get<SpecDialect>()} {
   addOperations<
       DialectOp, DialectTerminatorOp, OperationOp, TypeOp, AttributeOp,
-      AliasOp
+      AliasOp, PatternOp
   >();
   addTypes<
       AnyType, NoneType, AnyOfType, AllOfType,
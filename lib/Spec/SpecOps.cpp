@@ -7,6 +7,7 @@
 #include "dmc/Traits/SpecTraits.h"
 #include "dmc/Traits/StandardTraits.h"
 #include "dmc/Traits/Registry.h"
+#include "dmc/Embed/FormatBackend.h"
 
 #include <mlir/IR/Builders.h>
 #include <mlir/IR/OpImplementation.h>
@@ -85,6 +86,12 @@ LogicalResult DialectOp::verify() {
   if (!getAttrOfType<mlir::BoolAttr>(getAllowUnknownTypesAttrName()))
     return emitOpError("expected BoolAttr named: ")
         << getAllowUnknownTypesAttrName();
+  if (auto backend = getAttr(getFormatBackendAttrName())) {
+    auto backendStr = backend.dyn_cast<mlir::StringAttr>();
+    if (!backendStr || !py::symbolizeFormatBackend(backendStr.getValue()))
+      return emitOpError("expected '") << getFormatBackendAttrName()
+          << "' to be one of \"python\" or \"native\"";
+  }
   return success();
 }
 
@@ -101,6 +108,13 @@ bool DialectOp::allowsUnknownTypes() {
       .getValue();
 }
 
+Optional<StringRef> DialectOp::getFormatBackend() {
+  if (auto backend = getAttrOfType<mlir::StringAttr>(
+        getFormatBackendAttrName()))
+    return backend.getValue();
+  return llvm::None;
+}
+
 /// OperationOp
 void OperationOp::setOpType(OpType opTy) {
   setAttr(getOpTypeAttrName(), mlir::TypeAttr::get(opTy));
@@ -208,6 +222,24 @@ OpTraitsAttr OperationOp::getOpTraits() {
   return getAttrOfType<OpTraitsAttr>(getOpTraitsAttrName());
 }
 
+SmallVector<StringRef, 2> OperationOp::getFoldExprs() {
+  SmallVector<StringRef, 2> exprs;
+  auto fold = getAttr(getFoldAttrName());
+  if (auto expr = fold.dyn_cast_or_null<mlir::StringAttr>()) {
+    exprs.push_back(expr.getValue());
+  } else if (auto alts = fold.dyn_cast_or_null<mlir::ArrayAttr>()) {
+    for (auto alt : alts.getAsRange<mlir::StringAttr>())
+      exprs.push_back(alt.getValue());
+  }
+  return exprs;
+}
+
+Optional<StringRef> OperationOp::getPyFold() {
+  if (auto fcn = getAttrOfType<mlir::StringAttr>(getPyFoldAttrName()))
+    return fcn.getValue();
+  return llvm::None;
+}
+
 std::unique_ptr<DynamicTrait> OperationOp::getTrait(StringRef name) {
   auto *registry = getContext()->getRegisteredDialect<TraitRegistry>();
   for (auto trait : getOpTraits().getValue()) {
@@ -317,6 +349,20 @@ LogicalResult OperationOp::verify() {
   if (llvm::size(opSuccs) && !impl::hasTrait<IsTerminator>(opTraits))
     return emitOpError("an operation with successors must be a terminator");
 
+  /// A fold is a string or a non-empty array of strings.
+  if (auto fold = getAttr(getFoldAttrName())) {
+    auto alts = fold.dyn_cast<mlir::ArrayAttr>();
+    if (!fold.isa<mlir::StringAttr>() &&
+        (!alts || !alts.size() || llvm::any_of(alts, [](Attribute alt)
+                                  { return !alt.isa<mlir::StringAttr>(); })))
+      return emitOpError("expected '") << getFoldAttrName()
+          << "' to be a string or a non-empty array of strings";
+  }
+  auto pyFold = getAttr(getPyFoldAttrName());
+  if (pyFold && !pyFold.isa<mlir::StringAttr>())
+    return emitOpError("expected '") << getPyFoldAttrName()
+        << "' to be a string attribute";
+
   return success();
 }
 
@@ -480,4 +526,72 @@ Type AliasOp::getAttrType() {
   return typeAttr ? typeAttr.getValue() : Type{};
 }
 
+/// PatternOp.
+void PatternOp::build(OpBuilder &builder, OperationState &result,
+                      StringRef name, StringRef source, StringRef rewrite,
+                      unsigned benefit) {
+  result.addAttribute(SymbolTable::getSymbolAttrName(),
+                      builder.getStringAttr(name));
+  result.addAttribute(getSourceAttrName(), builder.getStringAttr(source));
+  result.addAttribute(getRewriteAttrName(), builder.getStringAttr(rewrite));
+  result.addAttribute(getBenefitAttrName(),
+                      builder.getI64IntegerAttr(benefit));
+}
+
+/// pattern ::= `dmc.Pattern` `@`pattern-name string `->` string attr-dict?
+ParseResult PatternOp::parse(OpAsmParser &parser, OperationState &result) {
+  mlir::StringAttr nameAttr, sourceAttr, rewriteAttr;
+  if (parser.parseSymbolName(nameAttr, SymbolTable::getSymbolAttrName(),
+                             result.attributes) ||
+      parser.parseAttribute(sourceAttr, getSourceAttrName(),
+                            result.attributes) ||
+      parser.parseArrow() ||
+      parser.parseAttribute(rewriteAttr, getRewriteAttrName(),
+                            result.attributes) ||
+      parser.parseOptionalAttrDict(result.attributes))
+    return failure();
+  return success();
+}
+
+void PatternOp::print(OpAsmPrinter &printer) {
+  printer << getOperationName().drop_front(dmcDotLen) << ' ';
+  printer.printSymbolName(getName());
+  printer << ' ';
+  printer.printAttribute(getAttr(getSourceAttrName()));
+  printer << " -> ";
+  printer.printAttribute(getAttr(getRewriteAttrName()));
+  printer.printOptionalAttrDict(getAttrs(), {
+      SymbolTable::getSymbolAttrName(), getSourceAttrName(),
+      getRewriteAttrName()});
+}
+
+LogicalResult PatternOp::verify() {
+  if (!getAttrOfType<mlir::StringAttr>(getSourceAttrName()))
+    return emitOpError("expected a string attribute named: ")
+        << getSourceAttrName();
+  if (!getAttrOfType<mlir::StringAttr>(getRewriteAttrName()))
+    return emitOpError("expected a string attribute named: ")
+        << getRewriteAttrName();
+  auto benefit = getAttr(getBenefitAttrName());
+  if (benefit && !benefit.isa<mlir::IntegerAttr>())
+    return emitOpError("expected an integer attribute for `")
+        << getBenefitAttrName() << "`";
+  return success();
+}
+
+StringRef PatternOp::getSource() {
+  return getAttrOfType<mlir::StringAttr>(getSourceAttrName()).getValue();
+}
+
+StringRef PatternOp::getRewrite() {
+  return getAttrOfType<mlir::StringAttr>(getRewriteAttrName()).getValue();
+}
+
+unsigned PatternOp::getBenefit() {
+  /// Patterns default to a benefit of one, as in TableGen.
+  if (auto benefit = getAttrOfType<mlir::IntegerAttr>(getBenefitAttrName()))
+    return benefit.getValue().getZExtValue();
+  return 1;
+}
+
 } // end namespace dmc
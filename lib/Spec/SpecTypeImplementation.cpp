@@ -21,6 +21,22 @@ LogicalResult delegateVerify(Type base, Type ty) {
   return SpecTypes::kindSwitch(action, base);
 }
 
+bool isInterpreted(Type base) {
+  if (!is(base))
+    return false;
+  if (auto pyTy = base.dyn_cast<PyType>())
+    return !pyTy.isNative();
+  if (auto anyOf = base.dyn_cast<AnyOfType>())
+    return llvm::any_of(anyOf.getTypes(), isInterpreted);
+  if (auto allOf = base.dyn_cast<AllOfType>())
+    return llvm::any_of(allOf.getTypes(), isInterpreted);
+  if (auto variadic = base.dyn_cast<VariadicType>())
+    return isInterpreted(variadic.getBaseType());
+  if (auto complex = base.dyn_cast<ComplexType>())
+    return isInterpreted(complex.getElementType());
+  return false;
+}
+
 } // end namespace SpecTypes
 
 /// Type verification.
@@ -153,6 +153,8 @@ AnyOfType AnyOfType::getChecked(Location loc, ArrayRef<Type> tys) {
   return Base::getChecked(loc, Kind, getSortedTypes(tys));
 }
 
+ArrayRef<Type> AnyOfType::getTypes() { return getImpl()->types; }
+
 LogicalResult AnyOfType::verifyConstructionInvariants(
     Location loc, ArrayRef<Type> tys) {
   return impl::verifyTypeList(loc, tys);
@@ -175,6 +177,8 @@ AllOfType AllOfType::getChecked(Location loc, ArrayRef<Type> tys) {
   return Base::getChecked(loc, Kind, getSortedTypes(tys));
 }
 
+ArrayRef<Type> AllOfType::getTypes() { return getImpl()->types; }
+
 LogicalResult AllOfType::verifyConstructionInvariants(
     Location loc, ArrayRef<Type> tys) {
   return impl::verifyTypeList(loc, tys);
@@ -266,6 +270,8 @@ ComplexType ComplexType::getChecked(Location loc, Type elTy) {
   return Base::getChecked(loc, Kind, elTy);
 }
 
+Type ComplexType::getElementType() { return getImpl()->type; }
+
 LogicalResult ComplexType::verify(Type ty) {
   // Check that the Type is a ComplexType
   if (auto complexTy = ty.dyn_cast<mlir::ComplexType>()) {
@@ -304,6 +310,8 @@ VariadicType VariadicType::get(Type ty) {
   return Base::get(ty.getContext(), Kind, ty);
 }
 
+Type VariadicType::getBaseType() { return getImpl()->type; }
+
 /// TODO Need to assert that Variadic is used only as a top-level Type
 /// constraint, since it is more of a marker than a constraint. This is how
 /// TableGen does it. Nesting Variadic is illegal but a no-op anyway.
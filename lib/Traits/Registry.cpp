@@ -93,6 +93,8 @@ void TraitRegistry::registerTrait(StringRef name, TraitConstructor &&getter) {
   auto [it, inserted] = traitRegistry.try_emplace(
       name, std::forward<TraitConstructor>(getter));
   assert(inserted && "Trait has already been registered");
+  /// Assign the trait an ID so that dynamic ops can index their traits.
+  getTraitID(name);
 }
 
 TraitConstructor TraitRegistry::lookupTrait(StringRef name) {
@@ -157,4 +157,19 @@ ValueRange SizedResultSegments::getGroup(
       op->getResults(), idx, getSegmentSizesAttr(op));
 }
 
+bool TypeConstraintTrait::verifiesInPython() const {
+  auto ty = opTy;
+  auto isInterpreted = [](Type base) {
+    return SpecTypes::isInterpreted(base);
+  };
+  return llvm::any_of(ty.getOperandTypes(), isInterpreted) ||
+      llvm::any_of(ty.getResultTypes(), isInterpreted);
+}
+
+bool AttrConstraintTrait::verifiesInPython() const {
+  return llvm::any_of(opAttrs.getValue(), [](const NamedAttribute &attr) {
+    return SpecAttrs::isInterpreted(attr.second);
+  });
+}
+
 } // end namespace dmc
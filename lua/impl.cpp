@@ -2,10 +2,21 @@
 #include "impl.h"
 
 #include <vector>
-#include <unordered_map>
 #include <array>
 #include <iostream>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
 
 static_assert(sizeof(TObject) == 16, "expected TObject to be 16 bytes");
 
@@ -24,7 +35,7 @@ struct LuaHash {
     case NUM:
       return std::hash<double>{}(val.num);
     case STR:
-      return std::hash<std::string>{}(*((std::string *) val.impl));
+      return static_cast<LuaString *>(val.impl)->hash;
     default:
       return std::hash<int64_t>{}(val.u);
     }
@@ -41,7 +52,8 @@ struct LuaEq {
     case NUM:
       return lhs.num == rhs.num;
     case STR:
-      return *((std::string *) lhs.impl) == *((std::string *) rhs.impl);
+      // strings are interned
+      return lhs.impl == rhs.impl;
     default:
       return lhs.u == rhs.u;
     }
@@ -57,125 +69,606 @@ using prealloc_t = std::array<TObject, PREALLOC>;
 static_assert(sizeof(prealloc_t) == PREALLOC * sizeof(TObject),
               "mismatched prealloc size");
 
+/// A float key with an integral value is the same key as the integer.
+TObject normalize_key(TObject key) {
+  if (key.type == NUM && std::trunc(key.num) == key.num &&
+      std::fabs(key.num) < 0x1p63) {
+    key.type = INT;
+    key.u = static_cast<int64_t>(key.num);
+  }
+  return key;
+}
+
+/// A table with an array part, for keys 1 to `array_size()`, and an open
+/// addressing hash part for all other keys. The array part grows when a key
+/// is appended to it, and when the hash part is rehashed, to the largest
+/// power of two that is more than half full, as in Lua.
 struct LuaTable {
-  prealloc_t prealloc;
-  //std::vector<TObject> trailing;
-  //std::unordered_map<TObject, TObject, LuaHash, LuaEq> table;
+  /// The first entries of the array part. Compiled code indexes these
+  /// directly through the table pointer, so they must come first.
+  prealloc_t prealloc{};
+  /// The rest of the array part.
+  std::vector<TObject> trailing;
+
+  /// A slot of the hash part. The slot is free if the key is nil. Keys
+  /// assigned nil keep their slot until the next rehash.
+  struct Node {
+    TObject key;
+    TObject val;
+    /// The hash of the key, so that keys are never rehashed.
+    std::size_t hash;
+  };
+  /// The hash part, whose size is zero or a power of two.
+  std::vector<Node> nodes;
+  /// The number of slots with a key.
+  std::size_t num_used{};
+
+  /// Mix the hash, since integers and pointers hash to themselves and the
+  /// slot is given by the low bits.
+  static std::size_t hash_key(TObject key) {
+    auto hash = LuaHash{}(key);
+    hash ^= hash >> 33;
+    hash *= 0xff51afd7ed558ccdULL;
+    hash ^= hash >> 33;
+    return hash;
+  }
+
+  int64_t array_size() const { return PREALLOC + trailing.size(); }
+
+  /// Get an array slot, for a key between 1 and the array size.
+  TObject *array_slot(int64_t iv) {
+    --iv;
+    return iv < (int64_t) PREALLOC ? &prealloc[iv] : &trailing[iv - PREALLOC];
+  }
+  const TObject *array_slot(int64_t iv) const {
+    return const_cast<LuaTable *>(this)->array_slot(iv);
+  }
+
+  Node *find(TObject key, std::size_t hash) {
+    if (nodes.empty())
+      return nullptr;
+    auto mask = nodes.size() - 1;
+    for (auto idx = hash & mask; nodes[idx].key.type != NIL;
+         idx = (idx + 1) & mask) {
+      auto &node = nodes[idx];
+      if (node.hash == hash && LuaEq{}(node.key, key))
+        return &node;
+    }
+    return nullptr;
+  }
+  const Node *find(TObject key, std::size_t hash) const {
+    return const_cast<LuaTable *>(this)->find(key, hash);
+  }
+
+  /// Insert a key that is not in the hash part, which must have a free slot.
+  void insert_node(TObject key, std::size_t hash, TObject val) {
+    auto mask = nodes.size() - 1;
+    auto idx = hash & mask;
+    while (nodes[idx].key.type != NIL)
+      idx = (idx + 1) & mask;
+    nodes[idx] = Node{key, val, hash};
+    ++num_used;
+  }
+
+  TObject get_int(int64_t iv) const {
+    if (iv >= 1 && iv <= array_size())
+      return *array_slot(iv);
+    TObject key{};
+    key.type = INT;
+    key.u = iv;
+    if (auto *node = find(key, hash_key(key)))
+      return node->val;
+    return TObject{};
+  }
+
+  /// Find the hash node of an integer key.
+  Node *find_int(int64_t iv) {
+    TObject key{};
+    key.type = INT;
+    key.u = iv;
+    return find(key, hash_key(key));
+  }
+
+  /// Move the keys that follow the array part out of the hash part.
+  void migrate_to_array() {
+    while (num_used) {
+      auto *node = find_int(array_size() + 1);
+      if (!node || node->val.type == NIL)
+        return;
+      trailing.push_back(node->val);
+      node->val = TObject{};
+    }
+  }
+
+  /// Append to the array part. A hash node for the appended key is cleared,
+  /// so that it cannot later shadow the new value.
+  void append(TObject val) {
+    if (num_used)
+      if (auto *node = find_int(array_size() + 1))
+        node->val = TObject{};
+    trailing.push_back(val);
+    migrate_to_array();
+  }
+
+  /// Resize the array and hash parts to fit their keys and a new key.
+  void rehash(TObject new_key) {
+    /// Count the integer keys in the ranges (2^(i-1), 2^i].
+    std::array<int64_t, 64> counts{};
+    auto count_key = [&](TObject key) {
+      if (key.type == INT && key.u >= 1)
+        ++counts[key.u == 1 ? 0 : 64 - __builtin_clzll(key.u - 1)];
+    };
+    std::size_t num_keys = 1;
+    count_key(new_key);
+    for (int64_t iv = 1; iv <= array_size(); ++iv) {
+      if (array_slot(iv)->type != NIL) {
+        TObject key{};
+        key.type = INT;
+        key.u = iv;
+        count_key(key);
+      }
+    }
+    for (auto &node : nodes) {
+      if (node.key.type != NIL && node.val.type != NIL) {
+        count_key(node.key);
+        ++num_keys;
+      }
+    }
+
+    /// The array part only grows, to keep the preallocated slots.
+    int64_t new_size = array_size();
+    int64_t num_ints = 0;
+    for (unsigned i = 0; i < counts.size(); ++i) {
+      num_ints += counts[i];
+      int64_t bound = int64_t{1} << i;
+      if (bound > (int64_t{1} << 40))
+        break;
+      if (num_ints > bound / 2 && bound > new_size)
+        new_size = bound;
+    }
+    trailing.resize(new_size - PREALLOC);
+
+    std::vector<Node> old;
+    old.swap(nodes);
+    num_used = 0;
+    std::size_t capacity = 4;
+    while (capacity * 3 < num_keys * 4)
+      capacity *= 2;
+    nodes.resize(capacity);
+    for (auto &node : old) {
+      if (node.key.type == NIL || node.val.type == NIL)
+        continue;
+      if (node.key.type == INT && node.key.u >= 1 &&
+          node.key.u <= array_size())
+        *array_slot(node.key.u) = node.val;
+      else
+        insert_node(node.key, node.hash, node.val);
+    }
+    migrate_to_array();
+  }
 
   TObject prealloc_get_or_alloc(int64_t iv) {
     return prealloc[iv];
   }
 
-  //TObject list_get_or_alloc(int64_t iv) {
-  //  --iv;
-  //  if (iv < PREALLOC) {
-  //    return prealloc_get_or_alloc(iv);
-  //  }
-  //  iv -= PREALLOC;
-  //  if (trailing.size() <= iv) {
-  //    trailing.resize(1 + iv * 2);
-  //  }
-  //  return trailing[iv];
-  //}
-
-  TObject get_or_alloc(TObject key) {
-    return prealloc_get_or_alloc(key.u - 1);
-    //if (key.type == INT) {
-    //  auto iv = key.u;
-    //  if (iv > 0) {
-    //    return list_get_or_alloc(iv);
-    //  }
-    //}
-    //if (auto it = table.find(key); it != table.end()) {
-    //  return it->second;
-    //} else {
-    //  TObject nil{NIL};
-    //  table.emplace_hint(it, key, nil);
-    //  return nil;
-    //}
+  TObject get(TObject key) const {
+    key = normalize_key(key);
+    if (key.type == INT)
+      return get_int(key.u);
+    if (key.type == NIL)
+      return TObject{};
+    if (auto *node = find(key, hash_key(key)))
+      return node->val;
+    return TObject{};
   }
 
   void prealloc_insert_or_assign(int64_t iv, TObject val) {
     prealloc[iv] = val;
   }
 
-  //void list_insert_or_assign(int64_t iv, TObject val) {
-  //  --iv;
-  //  if (iv < PREALLOC) {
-  //    prealloc_insert_or_assign(iv, val);
-  //    return;
-  //  }
-  //  iv -= PREALLOC;
-  //  if (trailing.size() <= iv) {
-  //    trailing.resize(1 + iv * 2);
-  //  }
-  //  trailing[iv] = val;
-  //}
-
   void insert_or_assign(TObject key, TObject val) {
-    prealloc_insert_or_assign(key.u - 1, val);
-    //if (key.type == INT) {
-    //  auto iv = key.u;
-    //  if (iv > 0) {
-    //    list_insert_or_assign(iv, val);
-    //    return;
-    //  }
-    //}
-    //table.insert_or_assign(key, val);
-  }
-
-  //int64_t get_list_size() {
-  //  int64_t size = 0;
-  //  for (size_t i = 0; i < PREALLOC; ++i) {
-  //    if (prealloc[i].type != NIL) {
-  //      ++size;
-  //    } else {
-  //      return size;
-  //    }
-  //  }
-  //  for (size_t i = 0; i < trailing.size(); ++i) {
-  //    if (trailing[i].type != NIL) {
-  //      ++size;
-  //    } else {
-  //      return size;
-  //    }
-  //  }
-  //  return size;
-  //}
+    key = normalize_key(key);
+    if (key.type == INT && key.u >= 1) {
+      if (key.u <= array_size()) {
+        *array_slot(key.u) = val;
+        return;
+      }
+      if (key.u == array_size() + 1 && val.type != NIL) {
+        append(val);
+        return;
+      }
+    }
+    assert(key.type != NIL && "table index is nil");
+    auto hash = hash_key(key);
+    if (auto *node = find(key, hash)) {
+      node->val = val;
+      return;
+    }
+    if (val.type == NIL)
+      return;
+    if ((num_used + 1) * 4 > nodes.size() * 3) {
+      /// The key may now belong to the array part.
+      rehash(key);
+      insert_or_assign(key, val);
+      return;
+    }
+    insert_node(key, hash, val);
+  }
+
+  /// Find a border: an index whose value is not nil, followed by nil, or
+  /// zero if the first value is nil. Binary search in the array part if it
+  /// ends with nil, otherwise unbound search in the hash part.
+  int64_t get_list_size() const {
+    int64_t i = 0;
+    int64_t j = array_size();
+    if (array_slot(j)->type == NIL) {
+      while (j - i > 1) {
+        auto m = i + (j - i) / 2;
+        if (array_slot(m)->type == NIL)
+          j = m;
+        else
+          i = m;
+      }
+      return i;
+    }
+    if (!num_used)
+      return j;
+    i = j++;
+    while (get_int(j).type != NIL) {
+      i = j;
+      if (j > std::numeric_limits<int64_t>::max() / 2) {
+        /// Pathological table: fall back to a linear search.
+        for (i = 1; get_int(i).type != NIL; ++i)
+          ;
+        return i - 1;
+      }
+      j *= 2;
+    }
+    while (j - i > 1) {
+      auto m = i + (j - i) / 2;
+      if (get_int(m).type == NIL)
+        j = m;
+      else
+        i = m;
+    }
+    return i;
+  }
+};
+
+/// The pack arena holds the argument packs of unknown size and the return
+/// packs of compiled functions, which bump allocate from its top. Like the
+/// stack, it is reserved up front, so memory is only committed once used,
+/// and it is followed by a guard page, so that overflowing it faults.
+static constexpr std::size_t PACK_ARENA_SLOTS = std::size_t{1} << 22;
+
+TObject *reserve_pack_arena() {
+  auto page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  auto size = PACK_ARENA_SLOTS * sizeof(TObject);
+  auto *mem = static_cast<char *>(
+      mmap(nullptr, size + page, PROT_READ | PROT_WRITE,
+           MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+  if (mem == MAP_FAILED || mprotect(mem + size, page, PROT_NONE)) {
+    std::cerr << "failed to reserve the pack arena" << std::endl;
+    std::abort();
+  }
+  return reinterpret_cast<TObject *>(mem);
+}
+
+TObject *const pack_arena_base = reserve_pack_arena();
+
+/// A mark-sweep garbage collector. Every collected object is preceded by a
+/// header with its kind, so that objects are traced precisely. Roots are
+/// found conservatively: any word on the stack, in a callee-saved register,
+/// or in a registered root range that is the address of an object keeps it
+/// alive, since compiled code keeps values in allocas and registers. The
+/// packs in the arena below its top are also roots.
+namespace gc {
+
+enum class Kind : uint8_t { String, Table, Closure, Capture };
+
+struct alignas(16) Header {
+  Header *next;
+  /// The number of slots of a capture pack.
+  uint32_t length;
+  Kind kind;
+  bool marked;
+};
+static_assert(sizeof(Header) == 16, "expected Header to be 16 bytes");
+
+void *payload(Header *header) { return header + 1; }
+Header *header_of(const void *obj) {
+  return const_cast<Header *>(static_cast<const Header *>(obj) - 1);
+}
+
+/// Collect once this many objects were allocated since the last collection,
+/// or as many as survived it, if more.
+static constexpr std::size_t MIN_THRESHOLD = 1 << 16;
+
+struct Heap {
+  /// All objects, newest first.
+  Header *objects = nullptr;
+  /// The addresses of all objects, to check words found by the scan.
+  std::unordered_set<const void *> addrs;
+  /// Ranges of values that are roots, besides the pack arena.
+  std::vector<std::pair<TObject *, std::size_t>> roots;
+  /// The interned strings by contents. Strings are removed when collected.
+  std::unordered_map<std::string_view, LuaString *> strings;
+  /// The strings of literals by the address of their data, which are never
+  /// collected.
+  std::unordered_map<const char *, LuaString *> literals;
+  std::vector<const void *> worklist;
+  const char *stack_top = nullptr;
+  std::size_t allocated = 0;
+  std::size_t threshold = MIN_THRESHOLD;
+  bool enabled = true;
+
+  /// Statistics, reported at exit if LUA_GC_STATS is set.
+  std::size_t collections = 0;
+  std::size_t freed = 0;
+  double total_pause = 0;
+  double max_pause = 0;
+
+  Heap() {
+    pthread_attr_t attr;
+    pthread_getattr_np(pthread_self(), &attr);
+    void *addr;
+    std::size_t size;
+    pthread_attr_getstack(&attr, &addr, &size);
+    pthread_attr_destroy(&attr);
+    stack_top = static_cast<const char *>(addr) + size;
+
+    if (auto *gc = std::getenv("LUA_GC"); gc && std::string{gc} == "off")
+      enabled = false;
+    if (std::getenv("LUA_GC_STATS"))
+      std::atexit(&Heap::report);
+  }
+
+  static void report();
+
+  void mark(const void *obj) {
+    if (!addrs.count(obj))
+      return;
+    auto *header = header_of(obj);
+    if (header->marked)
+      return;
+    header->marked = true;
+    worklist.push_back(obj);
+  }
+
+  void mark(const TObject &val) {
+    if (val.type == STR || val.type == TBL || val.type == FCN)
+      mark(val.impl);
+  }
+
+  /// Mark the objects whose addresses are in a range of memory. The range
+  /// may hold anything, so it is not instrumented.
+  __attribute__((no_sanitize_address)) void scan(const char *begin, const char *end) {
+    auto align = sizeof(void *) - 1;
+    auto *it = reinterpret_cast<const char *>(
+        (reinterpret_cast<uintptr_t>(begin) + align) & ~align);
+    for (; it + sizeof(void *) <= end; it += sizeof(void *))
+      mark(*reinterpret_cast<const void *const *>(it));
+  }
+
+  void trace(const void *obj) {
+    auto *header = header_of(obj);
+    switch (header->kind) {
+    case Kind::String:
+      break;
+    case Kind::Table: {
+      auto *tbl = static_cast<const LuaTable *>(obj);
+      for (auto &val : tbl->prealloc)
+        mark(val);
+      for (auto &val : tbl->trailing)
+        mark(val);
+      for (auto &node : tbl->nodes) {
+        mark(node.key);
+        mark(node.val);
+      }
+      break;
+    }
+    case Kind::Closure:
+      mark(static_cast<const TClosure *>(obj)->capture);
+      break;
+    case Kind::Capture: {
+      /// Captured variables are pointers to values.
+      auto *slots = static_cast<TObject *const *>(obj);
+      for (uint32_t i = 0; i < header->length; ++i) {
+        if (slots[i]) {
+          mark(slots[i]);
+          mark(*slots[i]);
+        }
+      }
+      break;
+    }
+    }
+  }
+
+  /// Scan the stack from the frame of this function, which is below the
+  /// registers spilled by the caller.
+  __attribute__((noinline)) void scan_stack() {
+    const char *sp = reinterpret_cast<const char *>(__builtin_frame_address(0));
+    scan(sp, stack_top);
+  }
+
+  void destroy(Header *header) {
+    auto *obj = payload(header);
+    switch (header->kind) {
+    case Kind::String:
+      strings.erase(static_cast<LuaString *>(obj)->str);
+      static_cast<LuaString *>(obj)->~LuaString();
+      break;
+    case Kind::Table:
+      static_cast<LuaTable *>(obj)->~LuaTable();
+      break;
+    case Kind::Closure:
+    case Kind::Capture:
+      break;
+    }
+    addrs.erase(obj);
+    std::free(header);
+  }
+
+  __attribute__((noinline)) void collect() {
+    auto start = std::chrono::steady_clock::now();
+    /// Spill the callee-saved registers, which may hold the only reference
+    /// to an object, to the stack.
+    __builtin_unwind_init();
+    scan_stack();
+    for (auto &[begin, size] : roots) {
+      for (std::size_t i = 0; i < size; ++i)
+        mark(begin[i]);
+    }
+    for (auto *it = pack_arena_base; it != lua_pack_arena_top; ++it)
+      mark(*it);
+    for (auto &[data, str] : literals)
+      mark(str);
+    while (!worklist.empty()) {
+      auto *obj = worklist.back();
+      worklist.pop_back();
+      trace(obj);
+    }
+
+    std::size_t live = 0;
+    for (auto **link = &objects; *link;) {
+      auto *header = *link;
+      if (header->marked) {
+        header->marked = false;
+        link = &header->next;
+        ++live;
+      } else {
+        *link = header->next;
+        destroy(header);
+        ++freed;
+      }
+    }
+    allocated = 0;
+    threshold = std::max(MIN_THRESHOLD, live);
+
+    std::chrono::duration<double, std::milli> pause{
+        std::chrono::steady_clock::now() - start};
+    ++collections;
+    total_pause += pause.count();
+    max_pause = std::max(max_pause, pause.count());
+  }
+
+  Header *allocate(Kind kind, std::size_t size, uint32_t length = 0) {
+    if (enabled && ++allocated >= threshold)
+      collect();
+    auto *header = static_cast<Header *>(
+        std::calloc(1, sizeof(Header) + size));
+    header->next = objects;
+    header->length = length;
+    header->kind = kind;
+    header->marked = false;
+    objects = header;
+    addrs.insert(payload(header));
+    return header;
+  }
 };
 
+/// The heap is never destroyed, so that it outlives the exit handlers.
+Heap &heap() {
+  static auto *heap = new Heap;
+  return *heap;
+}
+
+void Heap::report() {
+  auto &heap = gc::heap();
+  rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  std::cerr << "gc: " << heap.collections << " collections, "
+            << heap.freed << " objects freed, "
+            << heap.addrs.size() << " live\n"
+            << "gc: pause total " << heap.total_pause << " ms, max "
+            << heap.max_pause << " ms\n"
+            << "gc: peak RSS " << usage.ru_maxrss / 1024 << " MB"
+            << std::endl;
+}
+
+template <typename T, typename... ArgTs>
+T *make(Kind kind, ArgTs &&... args) {
+  auto *header = heap().allocate(kind, sizeof(T));
+  return new (payload(header)) T{std::forward<ArgTs>(args)...};
+}
+
+} // end namespace gc
+
 } // end anonymous namespace
+
+LuaString *intern_string(std::string str) {
+  auto &heap = gc::heap();
+  if (auto it = heap.strings.find(str); it != heap.strings.end())
+    return it->second;
+  auto hash = std::hash<std::string>{}(str);
+  auto *interned = gc::make<LuaString>(gc::Kind::String, std::move(str), hash);
+  heap.strings.emplace(interned->str, interned);
+  return interned;
+}
+
 } // end namespace lua
 
+/// Entry points that compiled code calls in its hot paths. When the runtime
+/// is linked into the compiled module as bitcode, they are always inlined.
+#ifdef LUA_INLINE_RUNTIME
+#define LUA_ACCESSOR __attribute__((always_inline))
+#else
+#define LUA_ACCESSOR
+#endif
+
 extern "C" {
 
+TObject *lua_pack_arena_top = lua::pack_arena_base;
+
 void *lua_make_fcn_impl(lua_fcn_t addr, TCapture capture) {
-  return new TClosure{addr, capture};
+  return lua::gc::make<TClosure>(lua::gc::Kind::Closure, addr, capture);
+}
+
+TObject **lua_new_capture_impl(int32_t size) {
+  auto &heap = lua::gc::heap();
+  auto *header = heap.allocate(lua::gc::Kind::Capture,
+                               size * sizeof(TObject *), size);
+  return static_cast<TObject **>(lua::gc::payload(header));
+}
+
+void lua_gc_add_root(TObject *begin, int32_t size) {
+  lua::gc::heap().roots.emplace_back(begin, size);
+}
+
+void lua_gc_collect(void) {
+  lua::gc::heap().collect();
 }
 
 void *lua_new_table_impl(void) {
-  return (void *) new lua::LuaTable;
+  return lua::gc::make<lua::LuaTable>(lua::gc::Kind::Table);
 }
-void lua_table_set_impl(void *impl, TObject key, TObject val) {
+LUA_ACCESSOR void lua_table_set_impl(void *impl, TObject key, TObject val) {
   ((lua::LuaTable *) impl)->insert_or_assign(key, val);
 }
-TObject lua_table_get_impl(void *impl, TObject key) {
-  return ((lua::LuaTable *) impl)->get_or_alloc(key);
+LUA_ACCESSOR TObject lua_table_get_impl(void *impl, TObject key) {
+  return ((lua::LuaTable *) impl)->get(key);
 }
-void lua_table_set_prealloc_impl(void *impl, int64_t iv, TObject val) {
+LUA_ACCESSOR void lua_table_set_prealloc_impl(void *impl, int64_t iv,
+                                              TObject val) {
   ((lua::LuaTable *) impl)->prealloc_insert_or_assign(iv, val);
 }
-TObject lua_table_get_prealloc_impl(void *impl, int64_t iv) {
+LUA_ACCESSOR TObject lua_table_get_prealloc_impl(void *impl, int64_t iv) {
   return ((lua::LuaTable *) impl)->prealloc_get_or_alloc(iv);
 }
 
-int64_t lua_list_size_impl(void *impl) {
-  assert(false);
-  //return ((lua::LuaTable *) impl)->get_list_size();
+LUA_ACCESSOR int64_t lua_list_size_impl(void *impl) {
+  return ((lua::LuaTable *) impl)->get_list_size();
 }
 
+/// String literals are deduplicated by luac, so each is loaded by the address
+/// of its data.
 void *lua_load_string_impl(const char *data, uint64_t len) {
-  return new std::string{data, len};
+  auto &literals = lua::gc::heap().literals;
+  if (auto it = literals.find(data); it != literals.end())
+    return it->second;
+  auto *str = lua::intern_string(std::string{data, len});
+  literals.emplace(data, str);
+  return str;
 }
 
 bool lua_eq_impl(TObject lhs, TObject rhs) {
@@ -187,7 +680,7 @@ TObject lua_strcat_impl(void* lhs, void *rhs) {
   TObject ret;
   ret.type = STR;
   auto catted = *((std::string *) lhs) + *((std::string *) rhs);
-  ret.impl = new std::string{std::move(catted)};
+  ret.impl = lua::intern_string(std::move(catted));
   return ret;
 }
 
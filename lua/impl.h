@@ -4,6 +4,17 @@
 
 namespace lua {
 
+/// A runtime string. Strings are interned, so equal strings are the same
+/// object and compare by pointer, and each carries its hash. The string
+/// comes first, so that the impl of a string value is a `std::string *`.
+struct LuaString {
+  std::string str;
+  std::size_t hash;
+};
+
+/// Get the interned string with the given contents, creating it if needed.
+LuaString *intern_string(std::string str);
+
 std::string &as_std_string(TObject *val);
 
 } // end namespace lua
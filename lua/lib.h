@@ -86,6 +86,9 @@ void lua_add_capture(TCapture capture, TObject *ptr, int32_t idx);
 TPack lua_get_ret_pack(int32_t size);
 TPack lua_get_arg_pack(int32_t size);
 
+/// The top of the pack arena, which compiled code allocates packs from.
+extern TObject *lua_pack_arena_top;
+
 void lua_pack_insert(TPack pack, TObject val, int32_t idx);
 void lua_pack_insert_all(TPack pack, TPack tail, int32_t idx);
 TObject lua_pack_get(TPack pack, int32_t idx);
@@ -103,6 +106,13 @@ void lua_table_set(TObject tbl, TObject key, TObject val);
 TObject lua_list_size(TObject tbl);
 TObject lua_load_string(const char *data, uint64_t len);
 
+/*******************************************************************************
+ * Garbage Collection
+ ******************************************************************************/
+
+void lua_gc_add_root(TObject *begin, int32_t size);
+void lua_gc_collect(void);
+
 #ifdef __cplusplus
 }
 #endif
@@ -281,17 +281,39 @@ module {
     return %ret_b : i1
   }
 
+  // A return pack reuses the arena memory released by the function, which
+  // may hold the tail, so the values are copied backwards if they move up.
   func @lua_pack_insert_all(%pack: !lua.pack, %tail: !lua.pack, %idx: i32) {
     %zero = constant 0 : index
     %step = constant 1 : index
 
     %tailSz = luac.pack_get_size %tail
     %upper = index_cast %tailSz : i32 to index
-    scf.for %i = %zero to %upper step %step {
-      %tailIdx = index_cast %i : index to i32
-      %obj = luac.pack_get_unsafe %tail[%tailIdx]
-      %packIdx = addi %idx, %tailIdx : i32
-      luac.pack_insert %pack[%packIdx] = %obj
+
+    %packAddr = luac.pack_get_addr %pack
+    %tailAddr = luac.pack_get_addr %tail
+    %idx64 = sexti %idx : i32 to i64
+    %objSz = constant 16 : i64
+    %offset = muli %idx64, %objSz : i64
+    %dstAddr = addi %packAddr, %offset : i64
+    %backwards = cmpi "ugt", %dstAddr, %tailAddr : i64
+
+    scf.if %backwards {
+      %last = subi %upper, %step : index
+      scf.for %i = %zero to %upper step %step {
+        %j = subi %last, %i : index
+        %tailIdx = index_cast %j : index to i32
+        %obj = luac.pack_get_unsafe %tail[%tailIdx]
+        %packIdx = addi %idx, %tailIdx : i32
+        luac.pack_insert %pack[%packIdx] = %obj
+      }
+    } else {
+      scf.for %i = %zero to %upper step %step {
+        %tailIdx = index_cast %i : index to i32
+        %obj = luac.pack_get_unsafe %tail[%tailIdx]
+        %packIdx = addi %idx, %tailIdx : i32
+        luac.pack_insert %pack[%packIdx] = %obj
+      }
     }
     return
   }
@@ -312,10 +334,14 @@ module {
     return %ret : !lua.val
   }
 
-  func @lua_table_get_impl(!luallvm.impl, !luallvm.value) -> !luallvm.value
-  func @lua_table_set_impl(!luallvm.impl, !luallvm.value, !luallvm.value)
+  // Values are passed to the runtime as their type and union.
+  func @lua_table_get_impl(!luallvm.impl, !luallvm.type, !luallvm.u)
+      -> !luallvm.value
+  func @lua_table_set_impl(!luallvm.impl, !luallvm.type, !luallvm.u,
+                           !luallvm.type, !luallvm.u)
   func @lua_table_get_prealloc_impl(!luallvm.impl, i64) -> !luallvm.value
-  func @lua_table_set_prealloc_impl(!luallvm.impl, i64, !luallvm.value)
+  func @lua_table_set_prealloc_impl(!luallvm.impl, i64, !luallvm.type,
+                                    !luallvm.u)
   func @lua_make_fcn_impl(!luallvm.fcn, !luallvm.capture) -> !luallvm.impl
   func @lua_load_string_impl(!llvm.ptr<i8>, !llvm.i64) -> !luallvm.impl
   func @lua_new_table_impl() -> !luallvm.impl
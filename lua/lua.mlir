@@ -134,6 +134,7 @@ Dialect @lua {
 Dialect @luaopt {
   Op @const_number() -> (res: !lua.value) { value = #dmc.AnyOf<#dmc.F<64>, #dmc.I<64>> }
     traits [@NoSideEffects]
+    config { fold = "$value" }
 
   Alias @table_prealloc -> 16
   Op @table_get_prealloc(tbl: !lua.value, iv: i64) -> (val: !lua.value)
@@ -258,9 +259,19 @@ Dialect @luac {
   Op @get_capture(capture: !lua.capture_pack, idx: i32) -> (val: !lua.value)
     traits [@NoSideEffects]
 
+  /// Argument packs of constant size are allocated on the stack. Other
+  /// argument packs and return packs are bump allocated in the pack arena.
   Op @get_arg_pack(size: i32) -> (pack: !lua.value_pack)
   Op @get_ret_pack(size: i32) -> (pack: !lua.value_pack)
 
+  /// A function marks the top of the pack arena on entry, as an empty pack.
+  /// It resets the arena to the mark when it returns and once it has unpacked
+  /// the results of a call, releasing the packs allocated since.
+  Op @pack_arena_mark() -> (mark: !lua.value_pack)
+    config { fmt = "attr-dict" }
+  Op @pack_arena_reset(mark: !lua.value_pack) -> ()
+    config { fmt = "$mark attr-dict" }
+
   Op @pack_insert(pack: !lua.value_pack, val: !lua.value, idx: i32) -> ()
     traits [@WriteTo<"pack">]
     config { fmt = "$pack `[` $idx `]` `=` $val attr-dict" }
@@ -271,6 +282,8 @@ Dialect @luac {
     config { fmt = "$pack `[` $idx `]` attr-dict" }
   Op @pack_get_size(pack: !lua.value_pack) -> (size: i32)
     config { fmt = "$pack attr-dict" }
+  Op @pack_get_addr(pack: !lua.value_pack) -> (addr: i64)
+    traits [@NoSideEffects] config { fmt = "$pack attr-dict" }
 
   Op @global_string() -> () { sym = #dmc.String, value = #dmc.String }
     traits [@MemoryWrite] config { fmt = "symbol($sym) `=` $value attr-dict" }
@@ -281,6 +294,24 @@ Dialect @luac {
     config { fmt = "$val attr-dict" }
   Op @load_from(val: !lua.value) -> (res: !lua.value)
     config { fmt = "$val attr-dict" }
+
+  /// Canonicalization of values that are unwrapped right after being wrapped
+  Pattern @get_bool_of_wrap "(luac.get_bool_val (luac.wrap_bool $b))" -> "$b"
+  Pattern @convert_bool_of_wrap
+    "(luac.convert_bool_like (luac.wrap_bool $b))" -> "$b"
+  Pattern @get_int_of_wrap "(luac.get_int_val (luac.wrap_int $i))" -> "$i"
+  Pattern @get_double_of_wrap
+    "(luac.get_double_val (luac.wrap_real $d))" -> "$d"
+  Pattern @type_of_wrap_bool "(luac.get_type (luac.wrap_bool _))"
+    -> "(std.constant {value = #luac.type_bool})"
+  Pattern @type_of_wrap_int "(luac.get_type (luac.wrap_int _))"
+    -> "(std.constant {value = #luac.type_num})"
+  Pattern @type_of_wrap_real "(luac.get_type (luac.wrap_real _))"
+    -> "(std.constant {value = #luac.type_num})"
+  Pattern @is_int_of_wrap_int "(luac.is_int (luac.wrap_int _))"
+    -> "(std.constant {value = 1 : i1})"
+  Pattern @is_int_of_wrap_real "(luac.is_int (luac.wrap_real _))"
+    -> "(std.constant {value = 0 : i1})"
 }
 
 Dialect @luallvm {
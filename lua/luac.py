@@ -997,17 +997,21 @@ def lowerFunctionDef(module):
         return True
     return lowerFcn
 
+# Pattern sets that do not depend on the module are built once.
+cfLowerings = PatternSet([
+    Pattern(lua.numeric_for, lowerNumericFor),
+    Pattern(lua.generic_for, lowerGenericFor),
+    Pattern(lua.loop_while, lowerLoopWhile),
+    Pattern(lua.until, lowerRepeatUntil),
+    Pattern(lua.cond_if, lowerCondIf),
+])
+knownCallUnpacks = PatternSet([Pattern(lua.unpack, knownCallUnpack)])
+
 def cfExpand(module:ModuleOp, main:FuncOp):
     applyOptPatterns(module, [Pattern(lua.function_def_capture,
                                       argPackFunctionDef)])
-    applyOptPatterns(module, [
-        Pattern(lua.numeric_for, lowerNumericFor),
-        Pattern(lua.generic_for, lowerGenericFor),
-        Pattern(lua.loop_while, lowerLoopWhile),
-        Pattern(lua.until, lowerRepeatUntil),
-        Pattern(lua.cond_if, lowerCondIf),
-    ])
-    applyOptPatterns(module, [Pattern(lua.unpack, knownCallUnpack)])
+    applyOptPatterns(module, cfLowerings)
+    applyOptPatterns(module, knownCallUnpacks)
     applyOptPatterns(module, [Pattern(luaopt.pack_func,
                                       lowerFunctionDef(module))])
 
@@ -1050,11 +1054,13 @@ def tableSetPrealloc(op:lua.table_set, rewriter:Builder):
     rewriter.erase(op)
     return True
 
+tablePreallocs = PatternSet([
+    Pattern(lua.table_get, tableGetPrealloc),
+    Pattern(lua.table_set, tableSetPrealloc),
+])
+
 def applyOpts(module):
-    applyOptPatterns(module, [
-        Pattern(lua.table_get, tableGetPrealloc),
-        Pattern(lua.table_set, tableSetPrealloc),
-    ])
+    applyOptPatterns(module, tablePreallocs)
     #applyCSE(module, licmCanHoist)
 
 ################################################################################
@@ -1081,31 +1087,58 @@ def luaNumberWrap(op, rewriter):
     rewriter.replace(op, [val])
     return True
 
+# The operator is matched natively, so only the matching expander is called.
 def getExpanderFor(opStr, binOpCls):
     def expandFcn(op:lua.binary, rewriter:Builder):
-        if op.op().getValue() != opStr:
-            return False
         binOp = rewriter.create(binOpCls, lhs=op.lhs(), rhs=op.rhs(),
                                 loc=op.loc)
         rewriter.replace(op, [binOp.res()])
         return True
 
-    return expandFcn
+    return Pattern(lua.binary, expandFcn, attrs={"op": StringAttr(opStr)})
+
+def getUnaryExpander(opStr, unOpCls, generatedOps=None):
+    if generatedOps is None:
+        generatedOps = []
 
-def getUnaryExpander(opStr, unOpCls):
     def expandFcn(op:lua.unary, rewriter:Builder):
-        if op.op().getValue() != opStr:
-            return False
         unOp = rewriter.create(unOpCls, val=op.val(), loc=op.loc)
         rewriter.replace(op, [unOp.res()])
         return True
 
-    return expandFcn
+    return Pattern(lua.unary, expandFcn, generatedOps,
+                   attrs={"op": StringAttr(opStr)})
+
+def getEntryBlock(op):
+    region = op.parentRegion
+    while not isa(region.parentOp, FuncOp):
+        region = region.parentOp.parentRegion
+    return region.getBlock(0)
+
+def getArenaMark(op):
+    for entryOp in getEntryBlock(op):
+        if isa(entryOp, luac.pack_arena_mark):
+            return luac.pack_arena_mark(entryOp).mark()
+    assert False, "expected a pack arena mark in the function entry"
+
+def markPackArena(module):
+    b = Builder()
+    for func in module.getOps(FuncOp):
+        name = func.getAttr("sym_name").getValue()
+        if name != "lua_main" and not name.startswith("lua_anon_fcn_"):
+            continue
+        b.insertAtStart(func.getRegion(0).getBlock(0))
+        b.create(luac.pack_arena_mark, loc=func.loc)
+
+def releaseCallResults(op, pack, rewriter):
+    if isa(pack.definingOp, lua.call):
+        rewriter.create(luac.pack_arena_reset, mark=getArenaMark(op),
+                        loc=op.loc)
 
 def expandConcat(op:lua.concat, rewriter:Builder):
     assert op.pack().hasOneUse(), "value pack can only be used once"
-    getter = (luac.get_ret_pack if isa(op.pack().getOpUses()[0], ReturnOp) else
-              luac.get_arg_pack)
+    isRet = isa(op.pack().getOpUses()[0], ReturnOp)
+    getter = luac.get_ret_pack if isRet else luac.get_arg_pack
     szVar = rewriter.create(ConstantOp, value=I32Attr(len(op.vals())),
                             loc=op.loc).result()
     tail = None if len(op.tail()) == 0 else op.tail()[0]
@@ -1114,16 +1147,22 @@ def expandConcat(op:lua.concat, rewriter:Builder):
                                  loc=op.loc).size()
         szVar = rewriter.create(AddIOp, lhs=szVar, rhs=tailSz, ty=I32Type(),
                                 loc=op.loc).result()
-    pack = rewriter.create(getter, size=szVar, loc=op.loc).pack()
-    for i in range(0, len(op.vals())):
-        idx = rewriter.create(ConstantOp, value=I32Attr(i), loc=op.loc).result()
-        rewriter.create(luac.pack_insert, pack=pack, val=op.vals()[i], idx=idx,
+    # Values are returned at the mark, releasing the packs of the function.
+    if isRet:
+        rewriter.create(luac.pack_arena_reset, mark=getArenaMark(op),
                         loc=op.loc)
+    pack = rewriter.create(getter, size=szVar, loc=op.loc).pack()
+    # The tail may be in released memory that the pack reuses, so it is
+    # copied before the values overwrite it.
     if tail:
         idx = rewriter.create(ConstantOp, value=I32Attr(len(op.vals())),
                               loc=op.loc).result()
         rewriter.create(luac.pack_insert_all, pack=pack, tail=tail, idx=idx,
                         loc=op.loc)
+    for i in range(0, len(op.vals())):
+        idx = rewriter.create(ConstantOp, value=I32Attr(i), loc=op.loc).result()
+        rewriter.create(luac.pack_insert, pack=pack, val=op.vals()[i], idx=idx,
+                        loc=op.loc)
     rewriter.replace(op, [pack])
     return True
 
@@ -1134,6 +1173,7 @@ def expandUnpack(op:lua.unpack, rewriter:Builder):
         val = rewriter.create(luac.pack_get, pack=op.pack(), idx=idx,
                               loc=op.loc).res()
         newVals.append(val)
+    releaseCallResults(op, op.pack(), rewriter)
     rewriter.replace(op, newVals)
     return True
 
@@ -1144,6 +1184,7 @@ def expandUnpackUnsafe(op, rewriter):
         val = rewriter.create(luac.pack_get_unsafe, pack=op.pack(), idx=idx,
                               loc=op.loc).res()
         newVals.append(val)
+    releaseCallResults(op, op.pack(), rewriter)
     rewriter.replace(op, newVals)
     return True
 
@@ -1152,6 +1193,9 @@ def expandCall(op:lua.call, rewriter:Builder):
     getPack = rewriter.create(luac.get_capture_pack, val=op.fcn(), loc=op.loc)
     icall = rewriter.create(CallIndirectOp, callee=getAddr.addr(),
                             operands=[getPack.capture(), op.args()], loc=op.loc)
+    if len(op.rets().getOpUses()) == 0:
+        rewriter.create(luac.pack_arena_reset, mark=getArenaMark(op),
+                        loc=op.loc)
     rewriter.replace(op, icall.results())
     return True
 
@@ -1162,13 +1206,20 @@ def expandRet(op, rewriter):
     return True
 
 anon_string_counter = 0
+# Literals are interned at compile time: equal literals share one global,
+# whose address the runtime uses to load the interned string.
 def lowerGetString(module:ModuleOp):
+    globalNames = {}
     def lowerFcn(op:lua.get_string, rewriter:Builder):
         global anon_string_counter
-        strName = StringAttr("lua_anon_string_" + str(anon_string_counter))
-        anon_string_counter += 1
-        module.append(luac.global_string(loc=op.loc, sym=strName,
-                                         value=op.value()))
+        value = op.value().getValue()
+        if value not in globalNames:
+            strName = StringAttr("lua_anon_string_" + str(anon_string_counter))
+            anon_string_counter += 1
+            module.append(luac.global_string(loc=op.loc, sym=strName,
+                                             value=op.value()))
+            globalNames[value] = strName
+        strName = globalNames[value]
         loadStr = rewriter.create(luac.load_string, global_sym=strName,
                                   loc=op.loc)
         rewriter.replace(op, [loadStr.res()])
@@ -1212,6 +1263,7 @@ def raiseConstNumber(op, rewriter):
     return True
 
 def lowerToLuac(module:ModuleOp):
+    markPackArena(module)
     target = ConversionTarget()
     target.addLegalDialect(luac)
     target.addLegalDialect(luaopt)
@@ -1233,22 +1285,22 @@ def lowerToLuac(module:ModuleOp):
         Pattern(lua.boolean, luaBooleanWrap),
         Pattern(lua.number, luaNumberWrap),
 
-        Pattern(lua.binary, getExpanderFor("+", luac.add)),
-        Pattern(lua.binary, getExpanderFor("-", luac.sub)),
-        Pattern(lua.binary, getExpanderFor("*", luac.mul)),
-        Pattern(lua.binary, getExpanderFor("^", luac.pow)),
-        Pattern(lua.binary, getExpanderFor("..", luac.strcat)),
-        Pattern(lua.binary, getExpanderFor("<", luac.lt)),
-        Pattern(lua.binary, getExpanderFor(">", luac.gt)),
-        Pattern(lua.binary, getExpanderFor("<=", luac.le)),
-        Pattern(lua.binary, getExpanderFor(">=", luac.ge)),
-        Pattern(lua.binary, getExpanderFor("==", luac.eq)),
-        Pattern(lua.binary, getExpanderFor("~=", luac.ne)),
-        Pattern(lua.binary, getExpanderFor("and", luac.bool_and)),
-
-        Pattern(lua.unary, getUnaryExpander("not", luac.bool_not)),
-        Pattern(lua.unary, getUnaryExpander("#", luac.list_size)),
-        Pattern(lua.unary, getUnaryExpander("-", luac.neg), [luac.neg]),
+        getExpanderFor("+", luac.add),
+        getExpanderFor("-", luac.sub),
+        getExpanderFor("*", luac.mul),
+        getExpanderFor("^", luac.pow),
+        getExpanderFor("..", luac.strcat),
+        getExpanderFor("<", luac.lt),
+        getExpanderFor(">", luac.gt),
+        getExpanderFor("<=", luac.le),
+        getExpanderFor(">=", luac.ge),
+        getExpanderFor("==", luac.eq),
+        getExpanderFor("~=", luac.ne),
+        getExpanderFor("and", luac.bool_and),
+
+        getUnaryExpander("not", luac.bool_not),
+        getUnaryExpander("#", luac.list_size),
+        getUnaryExpander("-", luac.neg, [luac.neg]),
 
         Pattern(lua.concat, expandConcat),
         Pattern(lua.unpack, expandUnpack),
@@ -1350,45 +1402,21 @@ def convertLuaCopy(op, b):
     b.erase(op)
     return True
 
+# Keys that are not known to be in the preallocated slots go to the runtime
+# table, which has array and hash parts.
 def convertLuaTableGet(op, b):
-    keyU = b.create(luallvm.get_u_direct, ref=op.key(), loc=op.loc).u()
-    negOne = llvmI64Const(b, -1, op.loc)
-    iv = b.create(AddIOp, ty=I64Type(), lhs=keyU, rhs=negOne, loc=op.loc).result()
-
     impl = b.create(luallvm.get_impl_direct, ref=op.tbl(), loc=op.loc).impl()
-    arrPtr = b.create(LLVMBitcastOp, res=luallvm.ref(), arg=impl,
-                      loc=op.loc).res()
-    elPtr = b.create(LLVMGEPOp, res=luallvm.ref(), base=arrPtr,
-                     indices=[iv], loc=op.loc).res()
-    val = loadRef(b, elPtr, op.loc)
-
-    #impl = b.create(luallvm.get_impl_direct, ref=op.tbl(), loc=op.loc).impl()
-    #key = loadRef(b, op.key(), op.loc)
-    #val = b.create(luallvm.table_get_impl, impl=impl, key=key, loc=op.loc).val()
-
+    key = loadRef(b, op.key(), op.loc)
+    val = b.create(luallvm.table_get_impl, impl=impl, key=key, loc=op.loc).val()
     valPtr = b.create(luac.into_alloca, val=val, loc=op.loc).res()
     b.replace(op, [valPtr])
     return True
 
 def convertLuaTableSet(op, b):
-    keyU = b.create(luallvm.get_u_direct, ref=op.key(), loc=op.loc).u()
-    negOne = llvmI64Const(b, -1, op.loc)
-    iv = b.create(AddIOp, ty=I64Type(), lhs=keyU, rhs=negOne, loc=op.loc).result()
-
     impl = b.create(luallvm.get_impl_direct, ref=op.tbl(), loc=op.loc).impl()
-    arrPtr = b.create(LLVMBitcastOp, res=luallvm.ref(), arg=impl,
-                      loc=op.loc).res()
-    elPtr = b.create(LLVMGEPOp, res=luallvm.ref(), base=arrPtr,
-                     indices=[iv], loc=op.loc).res()
-    ty, u = unpackTyAndU(b, op.val(), op.loc)
-    b.create(luallvm.set_type_direct, ref=elPtr, type=ty, loc=op.loc)
-    b.create(luallvm.set_u_direct, ref=elPtr, u=u, loc=op.loc)
-
-    #impl = b.create(luallvm.get_impl_direct, ref=op.tbl(), loc=op.loc).impl()
-    #key = loadRef(b, op.key(), op.loc)
-    #val = loadRef(b, op.val(), op.loc)
-    #b.create(luallvm.table_set_impl, impl=impl, key=key, val=val, loc=op.loc)
-
+    key = loadRef(b, op.key(), op.loc)
+    val = loadRef(b, op.val(), op.loc)
+    b.create(luallvm.table_set_impl, impl=impl, key=key, val=val, loc=op.loc)
     b.erase(op)
     return True
 
@@ -1472,18 +1500,12 @@ def convertLuaBuiltin(op, b):
 
 malloc = None
 realloc = None
+newCaptureImpl = None
 
+# Capture packs are allocated by the runtime, which collects them.
 def convertLuacNewCapture(op, b):
-    # Assumes 64-bit pointers, sizeof(TObject *) == 8
-    ptrSz = b.create(ConstantOp, value=I32Attr(8), loc=op.loc).result()
-    memSz = b.create(MulIOp, ty=I32Type(), lhs=ptrSz, rhs=op.size(),
-                     loc=op.loc).result()
-    memSzI64 = b.create(IndexCastOp, source=memSz, type=IndexType(),
-                        loc=op.loc).result()
-    ptr = b.create(CallOp, callee=malloc, operands=[memSzI64],
-                   loc=op.loc).getResult(0)
-    capture = b.create(LLVMBitcastOp, res=luallvm.capture(), arg=ptr,
-                       loc=op.loc).res()
+    capture = b.create(CallOp, callee=newCaptureImpl, operands=[op.size()],
+                       loc=op.loc).getResult(0)
     b.replace(op, [capture])
     return True
 
@@ -1502,12 +1524,15 @@ def convertLuacGetCapture(op, b):
     return True
 
 def luaToLLVMFirstPass(module):
-    global malloc, realloc
+    global malloc, realloc, newCaptureImpl
     malloc = FuncOp("malloc", FunctionType([IndexType()], [LLVMType.Int8Ptr()]))
     realloc = FuncOp("realloc", FunctionType([LLVMType.Int8Ptr(), IndexType()],
                                              [LLVMType.Int8Ptr()]))
+    newCaptureImpl = FuncOp("lua_new_capture_impl",
+                            FunctionType([I32Type()], [luallvm.capture()]))
     module.append(malloc)
     module.append(realloc)
+    module.append(newCaptureImpl)
     applyOptPatterns(module, [
         Pattern(lua.nil, convertLuaNil),
         Pattern(lua.table, convertLuaTable),
@@ -1709,6 +1734,14 @@ def convertLuacPackGetSize(op, b):
     b.replace(op, [sz])
     return True
 
+def convertLuacPackGetAddr(op, b):
+    objs = b.create(LLVMExtractValueOp, res=luallvm.ref(), container=op.pack(),
+                    pos=I64ArrayAttr([1]), loc=op.loc).res()
+    addr = b.create(LLVMPtrToIntOp, res=LLVMType.Int64(), arg=objs,
+                    loc=op.loc).res()
+    b.replace(op, [addr])
+    return True
+
 def convertLuacGetFcnAddr(op, b):
     impl = b.create(luallvm.get_impl_direct, ref=op.val(), loc=op.loc).impl()
     cloPtr = b.create(LLVMBitcastOp, res=luallvm.closure_ptr(), arg=impl,
@@ -1751,42 +1784,68 @@ def convertLuaLLVMLoadBuiltin(module):
         b.replace(op, [val])
     return convert
 
-def convertLuacGetPack(packPtr):
+def makePack(b, size, objs, loc):
+    undef = b.create(LLVMUndefOp, ty=luallvm.pack(), loc=loc).res()
+    v0 = b.create(LLVMInsertValueOp, res=luallvm.pack(), container=undef,
+                  value=size, pos=I64ArrayAttr([0]), loc=loc).res()
+    return b.create(LLVMInsertValueOp, res=luallvm.pack(), container=v0,
+                    value=objs, pos=I64ArrayAttr([1]), loc=loc).res()
+
+def arenaAlloc(b, arenaTop, size, loc):
+    topPtr = b.create(LLVMAddressOfOp, value=arenaTop, loc=loc).res()
+    top = b.create(LLVMLoadOp, res=luallvm.ref(), addr=topPtr, loc=loc).res()
+    newTop = b.create(LLVMGEPOp, res=luallvm.ref(), base=top, indices=[size],
+                      loc=loc).res()
+    b.create(LLVMStoreOp, value=newTop, addr=topPtr, loc=loc)
+    return makePack(b, size, top, loc)
+
+def convertLuacGetArgPack(arenaTop):
     def convert(op, b):
-        base = b.create(LLVMAddressOfOp, value=packPtr, loc=op.loc).res()
-        basePtr = b.create(LLVMBitcastOp, res=LLVMType.Int8Ptr().ptr_to(),
-                           arg=base, loc=op.loc).res()
-        ptr = b.create(LLVMLoadOp, res=LLVMType.Int8Ptr(), addr=basePtr,
+        sizeOp = op.size().definingOp
+        if not isa(sizeOp, ConstantOp):
+            b.replace(op, [arenaAlloc(b, arenaTop, op.size(), op.loc)])
+            return True
+        # Hoist the alloca to the entry block so that it is static.
+        b.insertAtStart(getEntryBlock(op))
+        n = b.create(LLVMConstantOp, res=LLVMType.Int32(),
+                     value=sizeOp.getAttr("value"), loc=op.loc).res()
+        objs = b.create(LLVMAllocaOp, res=luallvm.ref(), arrSz=n,
+                        align=I64Attr(8), loc=op.loc).res()
+        b.insertBefore(op)
+        b.replace(op, [makePack(b, op.size(), objs, op.loc)])
+        return True
+    return convert
+
+def convertLuacGetRetPack(arenaTop):
+    def convert(op, b):
+        b.replace(op, [arenaAlloc(b, arenaTop, op.size(), op.loc)])
+        return True
+    return convert
+
+def convertLuacPackArenaMark(arenaTop):
+    def convert(op, b):
+        topPtr = b.create(LLVMAddressOfOp, value=arenaTop, loc=op.loc).res()
+        top = b.create(LLVMLoadOp, res=luallvm.ref(), addr=topPtr,
                        loc=op.loc).res()
-        undef = b.create(LLVMUndefOp, ty=luallvm.pack(), loc=op.loc).res()
-        objs = b.create(LLVMBitcastOp, res=luallvm.ref(), arg=ptr,
-                        loc=op.loc).res()
-        v0 = b.create(LLVMInsertValueOp, res=luallvm.pack(), container=undef,
-                      value=op.size(), pos=I64ArrayAttr([0]), loc=op.loc).res()
-        v1 = b.create(LLVMInsertValueOp, res=luallvm.pack(), container=v0,
-                      value=objs, pos=I64ArrayAttr([1]), loc=op.loc).res()
-        b.replace(op, [v1])
+        b.replace(op, [makePack(b, llvmI32Const(b, 0, op.loc), top, op.loc)])
+        return True
+    return convert
+
+def convertLuacPackArenaReset(arenaTop):
+    def convert(op, b):
+        top = b.create(LLVMExtractValueOp, res=luallvm.ref(),
+                       container=op.mark(), pos=I64ArrayAttr([1]),
+                       loc=op.loc).res()
+        topPtr = b.create(LLVMAddressOfOp, value=arenaTop, loc=op.loc).res()
+        b.create(LLVMStoreOp, value=top, addr=topPtr, loc=op.loc)
+        b.erase(op)
+        return True
     return convert
 
-def prepMain(module, argPackPtr, retPackPtr):
+def prepMain(module):
     b = Builder()
     main = FuncOp("main", FunctionType([], [I32Type()]))
     b.insertAtStart(main.getBody().addEntryBlock([]))
-    def giveMem(name, packPtr):
-        mem = LLVMGlobalOp(LLVMType.ArrayOf(luallvm.value(), 16), False,
-                           LLVMLinkage.Internal(), name, Attribute(),
-                           UnknownLoc())
-        module.append(mem)
-        base = b.create(LLVMAddressOfOp, value=mem, loc=main.loc).res()
-        zero = llvmI32Const(b, 0, main.loc)
-        ptr = b.create(LLVMGEPOp, res=luallvm.ref(), base=base,
-                       indices=[zero, zero], loc=main.loc).res()
-        memPtr = b.create(LLVMPtrToIntOp, res=LLVMType.Int64(), arg=ptr,
-                          loc=main.loc).res()
-        tgt = b.create(LLVMAddressOfOp, value=packPtr, loc=main.loc).res()
-        b.create(LLVMStoreOp, value=memPtr, addr=tgt, loc=main.loc)
-    giveMem("g_arg_pack_mem", argPackPtr)
-    giveMem("g_ret_pack_mem", retPackPtr)
     luaMain = module.lookup("lua_main")
     b.create(CallOp, callee=luaMain, operands=[], loc=main.loc)
     ok = b.create(ConstantOp, value=I32Attr(0), loc=main.loc).result()
@@ -1794,21 +1853,22 @@ def prepMain(module, argPackPtr, retPackPtr):
     module.append(main)
 
 def luaToLLVMSecondPass(module):
-    argPackPtr = LLVMGlobalOp(LLVMType.Int64(), False, LLVMLinkage.Internal(),
-                              "g_arg_pack_ptr", I64Attr(0), UnknownLoc())
-    retPackPtr = LLVMGlobalOp(LLVMType.Int64(), False, LLVMLinkage.Internal(),
-                              "g_ret_pack_ptr", I64Attr(0), UnknownLoc())
-    module.append(argPackPtr)
-    module.append(retPackPtr)
-    prepMain(module, argPackPtr, retPackPtr)
+    # The top of the pack arena is owned by the runtime.
+    arenaTop = LLVMGlobalOp(luallvm.ref(), False, LLVMLinkage.External(),
+                            "lua_pack_arena_top", Attribute(), UnknownLoc())
+    module.append(arenaTop)
+    prepMain(module)
     addBuiltins(module, list(lua_builtins))
 
     applyOptPatterns(module, [
         Pattern(luac.global_string, convertLuacGlobalString),
         Pattern(luallvm.get_string_data, convertLuaLLVMGetStringData(module)),
 
-        Pattern(luac.get_arg_pack, convertLuacGetPack(argPackPtr)),
-        Pattern(luac.get_ret_pack, convertLuacGetPack(retPackPtr)),
+        Pattern(luac.get_arg_pack, convertLuacGetArgPack(arenaTop)),
+        Pattern(luac.get_ret_pack, convertLuacGetRetPack(arenaTop)),
+        Pattern(luac.pack_arena_mark, convertLuacPackArenaMark(arenaTop)),
+        Pattern(luac.pack_arena_reset, convertLuacPackArenaReset(arenaTop)),
+        Pattern(luac.pack_get_addr, convertLuacPackGetAddr),
         Pattern(luac.pack_insert, convertLuacPackInsert),
         Pattern(luac.pack_get_unsafe, convertLuacPackGetUnsafe),
         Pattern(luac.pack_get_size, convertLuacPackGetSize),
@@ -1848,6 +1908,22 @@ def luaToLLVMLatePass(module):
 # IR: Lua to LLVMIR Pass 3
 ################################################################################
 
+# The C ABI passes a value to the runtime as its type and union, so calls are
+# made the same way, which lets the runtime be inlined when linked as bitcode.
+def splitValues(b, args, loc):
+    split = []
+    for arg in args:
+        if arg.type != luallvm.value():
+            split.append(arg)
+            continue
+        split.append(b.create(LLVMExtractValueOp, res=luallvm.type(),
+                              container=arg, pos=I64ArrayAttr([0]),
+                              loc=loc).res())
+        split.append(b.create(LLVMExtractValueOp, res=luallvm.u(),
+                              container=arg, pos=I64ArrayAttr([1]),
+                              loc=loc).res())
+    return split
+
 def convertToLibCall(module:ModuleOp, funcName:str, needWrap):
     def convertFcn(op:Operation, b:Builder):
         rawOp = module.lookup(funcName)
@@ -1861,7 +1937,7 @@ def convertToLibCall(module:ModuleOp, funcName:str, needWrap):
                 else:
                     args.append(arg)
         else:
-            args = op.getOperands()
+            args = splitValues(b, op.getOperands(), op.loc)
         call = b.create(CallOp, callee=rawOp, operands=args, loc=op.loc)
         if needWrap:
             results = []
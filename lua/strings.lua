@@ -0,0 +1,24 @@
+-- String-heavy benchmark: literals in loops, string keys, and
+-- concatenation of repeated strings.
+
+local N = 2000000
+
+local fields = {}
+for i=1,N do
+  fields["alpha"] = i
+  fields["beta"] = fields["alpha"] + 1
+  fields["gamma"] = fields["beta"] + fields["alpha"]
+end
+print("fields:", fields["gamma"])
+
+local counts = {}
+local words = {"the", "quick", "brown", "fox", "jumps"}
+for i=1,N do
+  local w = words[i % 5 + 1] .. " " .. words[(i + 1) % 5 + 1]
+  if counts[w] then
+    counts[w] = counts[w] + 1
+  else
+    counts[w] = 1
+  end
+end
+print("pairs:", counts["the quick"], counts["fox jumps"])
@@ -0,0 +1,26 @@
+-- Regression test for values assigned after the array part grows. Prints
+-- "ok" twice, e.g. `make main FILE=tablerehash.lua && ./main`.
+
+-- Key 33 is in the hash part when a rehash grows the array part to 32.
+local t = {}
+for i=1,16 do
+  t[i] = i
+end
+t[33] = "old"
+for i=18,32 do
+  t[i] = i
+end
+
+-- Assign the key that follows the array part, then grow again.
+t[33] = "new"
+for i=100,300 do
+  t[i * 1000] = i
+end
+if t[33] == "new" then print("ok") else print("FAIL: t[33] =", t[33]) end
+
+-- The same key must not be counted twice.
+local n = 0
+for i=1,40 do
+  if t[i] then n = n + 1 end
+end
+if n == 32 then print("ok") else print("FAIL: found", n, "keys") end
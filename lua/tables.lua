@@ -0,0 +1,37 @@
+-- Table-heavy benchmark: array growth, the length operator, sparse integer
+-- keys, and records with string keys.
+
+local N = 2000000
+
+local arr = {}
+for i=1,N do
+  arr[i] = i
+end
+local sum = 0
+for i=1,#arr do
+  sum = sum + arr[i]
+end
+print("array sum:", sum)
+
+local stack = {}
+for i=1,N do
+  stack[#stack + 1] = i
+end
+print("stack length:", #stack)
+
+local sparse = {}
+for i=1,N do
+  sparse[i * 7] = i
+end
+local sparsesum = 0
+for i=1,N do
+  sparsesum = sparsesum + sparse[i * 7]
+end
+print("sparse sum:", sparsesum)
+
+local acc = 0
+for i=1,N do
+  local p = {x = i, y = i + 1, z = i + 2}
+  acc = acc + p.x + p.y - p.z
+end
+print("records:", acc)
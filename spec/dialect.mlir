@@ -38,4 +38,14 @@ dmc.Dialect @test {
   dmc.Op @op_py(arg0 : !test.IsInteger) -> () { index = #test.ArraySize3 }
 
   dmc.Op @op_succ() -> () [s0 : Any, s1 : Any, Ss : Variadic<Any>] traits [@IsTerminator]
+
+  dmc.Op @constant() -> (ret0 : i64) { value = #dmc.I<64> }
+      traits [@NoSideEffects]
+      config { fold = "$value" }
+  dmc.Op @add_i64(lhs : i64, rhs : i64) -> (ret0 : i64)
+      traits [@NoSideEffects]
+      config { fold = ["$lhs if $rhs == 0", "$rhs if $lhs == 0", "$lhs + $rhs"] }
+  dmc.Pattern @add_add_zero
+      "(test.add_i64 $x (test.add_i64 $y (test.constant {value = 0 : i64})))"
+      -> "(test.add_i64 $x $y)" { benefit = 2 }
 }
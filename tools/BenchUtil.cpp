@@ -0,0 +1,51 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicContext.h"
+#include "dmc/Spec/SpecDialect.h"
+#include "dmc/Spec/DialectGen.h"
+#include "dmc/Traits/Registry.h"
+
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/Parser.h>
+#include <mlir/IR/Verifier.h>
+#include <mlir/Dialect/StandardOps/IR/Ops.h>
+#include <mlir/Dialect/LLVMIR/LLVMDialect.h>
+
+using namespace mlir;
+using namespace llvm;
+
+static DialectRegistration<dmc::SpecDialect> specDialectRegistration;
+static DialectRegistration<dmc::TraitRegistry> registerTraits;
+static DialectRegistration<StandardOpsDialect> registerStdOps;
+static DialectRegistration<LLVM::LLVMDialect> registerLlvmOps;
+
+namespace dmc {
+
+void reportPhase(StringRef name, std::int64_t ns, std::size_t count,
+                 StringRef unit) {
+  llvm::outs() << name << ": " << ns / 1000000 << " ms ("
+               << (double) ns / count << " ns/" << unit << ", "
+               << (std::size_t) (count * 1e9 / ns) << " " << unit << "s/s)\n";
+}
+
+BenchLoader::BenchLoader(MLIRContext *ctx)
+    : ctx{ctx}, diag{srcMgr, ctx} {}
+
+OwningModuleRef BenchLoader::loadSpec(StringRef filename,
+                                      DynamicContext *dynCtx) {
+  auto dialectModule = parseSourceFile(filename, srcMgr, ctx);
+  if (!dialectModule || failed(verify(*dialectModule)) ||
+      failed(registerAllDialects(*dialectModule, dynCtx))) {
+    llvm::errs() << "Failed to load dialect module: " << filename << "\n";
+    return {};
+  }
+  return dialectModule;
+}
+
+OwningModuleRef BenchLoader::loadModule(StringRef filename) {
+  auto module = parseSourceFile(filename, srcMgr, ctx);
+  if (!module)
+    llvm::errs() << "Failed to parse module: " << filename << "\n";
+  return module;
+}
+
+} // end namespace dmc
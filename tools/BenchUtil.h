@@ -0,0 +1,53 @@
+#pragma once
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/SourceMgr.h>
+#include <mlir/IR/Diagnostics.h>
+#include <mlir/IR/Module.h>
+
+#include <chrono>
+
+/// Shared pieces of the benchmark tools. Linking this also registers the
+/// spec, trait, standard, and LLVM dialects.
+namespace dmc {
+
+/// Forward declarations.
+class DynamicContext;
+
+/// Report a benchmark phase that took `ns` for `count` items.
+void reportPhase(llvm::StringRef name, std::int64_t ns, std::size_t count,
+                 llvm::StringRef unit);
+
+/// Time `iters` runs of a phase over `count` items and report the time per
+/// item and the throughput.
+template <typename FcnT>
+void timePhase(llvm::StringRef name, std::size_t count, FcnT fcn,
+               unsigned iters = 1, llvm::StringRef unit = "op") {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iters; ++i)
+    fcn();
+  auto end = std::chrono::steady_clock::now();
+  reportPhase(name, std::chrono::duration_cast<std::chrono::nanoseconds>(
+      end - start).count(), count * iters, unit);
+}
+
+/// Loads the files of a benchmark and reports their diagnostics.
+class BenchLoader {
+public:
+  explicit BenchLoader(mlir::MLIRContext *ctx);
+
+  /// Parse and verify a dialect spec and register its dialects. On failure,
+  /// an error is printed and null is returned.
+  mlir::OwningModuleRef loadSpec(llvm::StringRef filename,
+                                 DynamicContext *dynCtx);
+  /// Parse a module that uses the registered dialects. On failure, an error
+  /// is printed and null is returned.
+  mlir::OwningModuleRef loadModule(llvm::StringRef filename);
+
+private:
+  mlir::MLIRContext *ctx;
+  llvm::SourceMgr srcMgr;
+  mlir::SourceMgrDiagnosticHandler diag;
+};
+
+} // end namespace dmc
@@ -0,0 +1,191 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Spec/SpecOps.h"
+#include "dmc/IO/Bytecode.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/ErrorOr.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/Parser.h>
+#include <mlir/IR/Module.h>
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// Switch the ops with a native format to the native or Python backend.
+/// Returns the number of such ops.
+unsigned useNativeFormats(ModuleOp dialects, MLIRContext *ctx, bool native) {
+  unsigned numNative{};
+  for (auto dialectOp : dialects.getOps<DialectOp>()) {
+    auto *dialect = static_cast<DynamicDialect *>(
+        ctx->getRegisteredDialect(dialectOp.getName()));
+    for (auto *op : dialect->getOps()) {
+      if (!op->hasNativeOpFormat())
+        continue;
+      op->useNativeOpFormat(native);
+      ++numNative;
+    }
+  }
+  return numNative;
+}
+
+std::string printModule(ModuleOp module, OpPrintingFlags flags = {}) {
+  std::string out;
+  llvm::raw_string_ostream os{out};
+  module.print(os, flags);
+  return os.str();
+}
+
+/// Check that both backends print the same text, and that what each backend
+/// parses is the same op structure.
+bool checkBackends(ModuleOp dialects, ModuleOp module, StringRef source,
+                   MLIRContext *ctx) {
+  bool ok = true;
+  std::string texts[2], generic[2];
+  for (bool native : {false, true}) {
+    useNativeFormats(dialects, ctx, native);
+    texts[native] = printModule(module);
+    auto parsed = parseSourceString(source, ctx);
+    if (!parsed) {
+      llvm::errs() << (native ? "native" : "python")
+                   << " backend failed to parse the module\n";
+      return false;
+    }
+    generic[native] = printModule(*parsed,
+                                  OpPrintingFlags().printGenericOpForm());
+  }
+  if (texts[0] != texts[1]) {
+    llvm::errs() << "backends printed different text\n";
+    ok = false;
+  }
+  if (generic[0] != generic[1]) {
+    llvm::errs() << "backends parsed different modules\n";
+    ok = false;
+  }
+  return ok;
+}
+
+/// Check that the module reads back from bytecode as the same op structure.
+bool checkBytecode(ModuleOp module, StringRef bytecode, DynamicContext *ctx) {
+  auto parsed = parseBytecode(bytecode, ctx);
+  if (!parsed) {
+    llvm::errs() << "failed to read the module from bytecode\n";
+    return false;
+  }
+  auto flags = OpPrintingFlags().printGenericOpForm();
+  if (printModule(module, flags) != printModule(*parsed, flags)) {
+    llvm::errs() << "bytecode round trip changed the module\n";
+    return false;
+  }
+  return true;
+}
+
+} // end anonymous namespace
+
+/// Measure parse and print throughput of a module that uses dynamic dialects.
+/// Ops with a native format are checked against the Python backend and both
+/// backends are timed. E.g.
+///
+///   asmbench lua/lua.mlir lua/perf.mlir
+///   asmbench spec/stencil.mlir spec/laplace.mlir
+///
+/// The module is also round-tripped through bytecode, which is timed against
+/// the text formats.
+///
+/// Native formats are compiled for dialects with `format_backend = "native"`
+/// or when `DMC_FORMAT_BACKEND=native` is set.
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    llvm::errs() << "Usage: asmbench <dialect_mlir> <module_mlir> [iters]\n";
+    return -1;
+  }
+  unsigned iters = 100;
+  if (argc == 4 && StringRef{argv[3]}.getAsInteger(10, iters)) {
+    llvm::errs() << "Invalid number of iterations: " << argv[3] << "\n";
+    return -1;
+  }
+
+  MLIRContext ctx;
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+
+  BenchLoader loader{&ctx};
+  auto dialectModule = loader.loadSpec(argv[1], dynCtx);
+  if (!dialectModule)
+    return -1;
+
+  auto buf = MemoryBuffer::getFile(argv[2]);
+  if (!buf) {
+    llvm::errs() << "Failed to read module: " << argv[2] << "\n";
+    return -1;
+  }
+  auto source = (*buf)->getBuffer();
+
+  /// Parse once to validate the input and count the ops.
+  auto module = parseSourceString(source, &ctx);
+  if (!module) {
+    llvm::errs() << "Failed to parse module: " << argv[2] << "\n";
+    return -1;
+  }
+  std::size_t numOps{};
+  module->walk([&](Operation *) { ++numOps; });
+
+  /// Compare and time both backends if any op has a native format.
+  auto numNative = useNativeFormats(*dialectModule, &ctx, true);
+  if (numNative) {
+    llvm::outs() << numNative << " ops have a native format\n";
+    if (!checkBackends(*dialectModule, *module, source, &ctx))
+      return 1;
+  }
+  for (bool native : {false, true}) {
+    if (native && !numNative)
+      break;
+    useNativeFormats(*dialectModule, &ctx, native);
+    std::string prefix = numNative ? (native ? "native " : "python ") : "";
+    timePhase(prefix + "parse", numOps, [&] {
+      if (!parseSourceString(source, &ctx))
+        llvm::report_fatal_error("Failed to parse module");
+    }, iters);
+    timePhase(prefix + "print", numOps, [&] {
+      printModule(*module);
+    }, iters);
+  }
+
+  std::string bytecode;
+  llvm::raw_string_ostream bytecodeOs{bytecode};
+  writeBytecode(*module, bytecodeOs);
+  bytecodeOs.flush();
+  llvm::outs() << "bytecode: " << bytecode.size() << " bytes, text: "
+               << source.size() << " bytes\n";
+  if (!checkBytecode(*module, bytecode, dynCtx))
+    return 1;
+  timePhase("bytecode read", numOps, [&] {
+    if (!parseBytecode(bytecode, dynCtx))
+      llvm::report_fatal_error("Failed to read bytecode");
+  }, iters);
+  /// Loading lazily only reads the top level of the module.
+  std::string bytecodeFile = std::string{argv[2]} + ".dmcb";
+  if (failed(writeBytecodeFile(*module, bytecodeFile)))
+    return -1;
+  timePhase("bytecode load", numOps, [&] {
+    if (!LazyModule::load(bytecodeFile, dynCtx))
+      llvm::report_fatal_error("Failed to load bytecode");
+  }, iters);
+  timePhase("bytecode load all", numOps, [&] {
+    auto lazy = LazyModule::load(bytecodeFile, dynCtx);
+    if (!lazy || failed(lazy->materializeAll()))
+      llvm::report_fatal_error("Failed to load bytecode");
+  }, iters);
+  llvm::sys::fs::remove(bytecodeFile);
+  timePhase("bytecode write", numOps, [&] {
+    std::string out;
+    llvm::raw_string_ostream os{out};
+    writeBytecode(*module, os);
+  }, iters);
+  return 0;
+}
@@ -0,0 +1,74 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicOperation.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/IR/Builders.h>
+#include <mlir/IR/Module.h>
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// The lookup performed by every dynamic op hook before the dispatch table.
+DynamicOperation *lookupByDialect(Operation *op) {
+  auto *dialect = dynamic_cast<DynamicDialect *>(op->getDialect());
+  return dialect->lookupOp(op->getName());
+}
+
+} // end anonymous namespace
+
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    llvm::errs() << "Usage: bench <dialect_mlir> <op_name> [num_ops]\n";
+    return -1;
+  }
+  unsigned numOps = 1000000;
+  if (argc == 4 && StringRef{argv[3]}.getAsInteger(10, numOps)) {
+    llvm::errs() << "Invalid number of ops: " << argv[3] << "\n";
+    return -1;
+  }
+
+  MLIRContext ctx;
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+
+  BenchLoader loader{&ctx};
+  auto dialectModule = loader.loadSpec(argv[1], dynCtx);
+  if (!dialectModule)
+    return -1;
+
+  OperationName opName{argv[2], &ctx};
+  if (!opName.getAbstractOperation()) {
+    llvm::errs() << "Unknown operation: " << argv[2] << "\n";
+    return -1;
+  }
+
+  /// Build a flat module of `numOps` generic ops.
+  auto loc = UnknownLoc::get(&ctx);
+  auto module = ModuleOp::create(loc);
+  timePhase("build", numOps, [&] {
+    for (unsigned i = 0; i < numOps; ++i)
+      module.push_back(Operation::create(loc, opName, {}, {}, {}, {}, 0));
+  });
+
+  /// Compare dynamic op dispatch through the dialect and the TypeID slot.
+  std::size_t checksum{};
+  timePhase("dispatch (dialect lookup)", numOps, [&] {
+    for (auto &op : module.getBody()->without_terminator())
+      checksum += reinterpret_cast<std::uintptr_t>(lookupByDialect(&op));
+  });
+  timePhase("dispatch (TypeID slot)", numOps, [&] {
+    for (auto &op : module.getBody()->without_terminator())
+      checksum -= reinterpret_cast<std::uintptr_t>(DynamicOperation::of(&op));
+  });
+  if (checksum) {
+    llvm::errs() << "Dispatch mismatch\n";
+    return -1;
+  }
+
+  module.erase();
+  return 0;
+}
@@ -0,0 +1,151 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicContext.h"
+#include "dmc/Spec/SpecOps.h"
+#include "dmc/Spec/DialectGen.h"
+#include "dmc/Spec/SymbolResolver.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/Parser.h>
+#include <mlir/IR/Module.h>
+#include <mlir/IR/Verifier.h>
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// Generate a spec of one dialect with `numOps` ops. Every op refers to
+/// dynamic types, attributes, and aliases of the dialect, both directly and
+/// nested in type and attribute constraints.
+std::string generateSpec(unsigned numOps) {
+  std::string spec;
+  llvm::raw_string_ostream os{spec};
+  os << "Dialect @synth {\n"
+     << "  Type @val\n"
+     << "  Type @pair<first: #dmc.Any, second: #dmc.Any>\n"
+     << "  Attr @tag\n"
+     << "  Alias @value -> !dmc.Isa<@synth::@val>\n"
+     << "  Alias @Tags -> #dmc.AnyOf<#synth.tag, #dmc.String>\n";
+  for (unsigned i = 0; i < numOps; ++i) {
+    os << "  Op @op" << i << "(a: !synth.value, "
+       << "b: !dmc.AnyOf<!synth.val, i" << (i % 64 + 1) << ">, "
+       << "c: !dmc.Variadic<!synth.value>) -> ("
+       << "r: !synth.val, p: !synth.pair<" << i << ", \"p\">) "
+       << "{ tag = #dmc.Optional<#synth.Tags>, "
+       << "n = #dmc.Default<#dmc.I<32>, " << i << " : i32> }\n";
+  }
+  os << "}\n";
+  return std::move(os.str());
+}
+
+/// The unresolved types and attributes of a spec op.
+struct OpSymbols {
+  OperationOp opOp;
+  OpType opTy;
+  DictionaryAttr opAttrs;
+};
+
+/// Resolve the symbols of every op with a resolver or by reparsing. Returns
+/// the resolved types and attributes in order and counts the symbols that the
+/// resolvers had to reparse.
+template <typename ResolveTypeFn, typename ResolveAttrFn>
+std::vector<const void *> resolveAll(ArrayRef<OpSymbols> ops,
+                                     ResolveTypeFn resolveType,
+                                     ResolveAttrFn resolveAttr,
+                                     unsigned &numReparsed) {
+  std::vector<const void *> results;
+  for (auto &op : ops) {
+    SymbolResolver resolver{op.opOp.getLoc()};
+    for (auto &value : op.opTy.getOperands())
+      results.push_back(resolveType(resolver, value.type)
+                        .getAsOpaquePointer());
+    for (auto &value : op.opTy.getResults())
+      results.push_back(resolveType(resolver, value.type)
+                        .getAsOpaquePointer());
+    for (auto &attr : op.opAttrs.getValue())
+      results.push_back(resolveAttr(resolver, attr.second)
+                        .getAsOpaquePointer());
+    numReparsed += resolver.getNumReparsed();
+  }
+  return results;
+}
+
+} // end anonymous namespace
+
+/// Measure how long it takes to register a synthetic spec, e.g.
+///
+///   specbench 5000
+///
+/// The spec is parsed before its dialect exists, so every reference to a
+/// dialect symbol is a placeholder. After registration, the placeholders of
+/// the original spec are resolved again by symbol lookup and by printing and
+/// reparsing, and both are checked to produce the same types and attributes.
+int main(int argc, char *argv[]) {
+  if (argc > 2) {
+    llvm::errs() << "Usage: specbench [num_ops]\n";
+    return -1;
+  }
+  unsigned numOps = 5000;
+  if (argc == 2 && StringRef{argv[1]}.getAsInteger(10, numOps)) {
+    llvm::errs() << "Invalid number of ops: " << argv[1] << "\n";
+    return -1;
+  }
+
+  MLIRContext ctx;
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+
+  /// Only used to report the diagnostics of the generated spec.
+  BenchLoader loader{&ctx};
+  auto spec = generateSpec(numOps);
+  OwningModuleRef dialectModule;
+  timePhase("parse", numOps, [&] {
+    dialectModule = parseSourceString(spec, &ctx);
+  });
+  if (!dialectModule || failed(verify(*dialectModule))) {
+    llvm::errs() << "Failed to parse the generated spec\n";
+    return -1;
+  }
+
+  /// Keep the unresolved symbols. Registration replaces them on the ops.
+  std::vector<OpSymbols> ops;
+  for (auto dialectOp : dialectModule->getOps<DialectOp>())
+    for (auto opOp : dialectOp.getOps<OperationOp>())
+      ops.push_back({opOp, opOp.getOpType(), opOp.getOpAttrs()});
+
+  LogicalResult result = success();
+  timePhase("register", numOps, [&] {
+    result = registerAllDialects(*dialectModule, dynCtx);
+  });
+  if (failed(result)) {
+    llvm::errs() << "Failed to register the generated spec\n";
+    return -1;
+  }
+
+  std::vector<const void *> reparsed, resolved;
+  unsigned numReparsed{};
+  timePhase("reparse", numOps, [&] {
+    reparsed = resolveAll(
+        ops, [](SymbolResolver &, Type type)
+        { return impl::reparseType(type); },
+        [](SymbolResolver &, Attribute attr)
+        { return impl::reparseAttr(attr); }, numReparsed);
+  });
+  timePhase("resolve", numOps, [&] {
+    resolved = resolveAll(
+        ops, [](SymbolResolver &resolver, Type type)
+        { return resolver.resolve(type); },
+        [](SymbolResolver &resolver, Attribute attr)
+        { return resolver.resolve(attr); }, numReparsed);
+  });
+  llvm::outs() << "resolved " << resolved.size() << " symbols, "
+               << numReparsed << " by reparsing\n";
+
+  if (reparsed != resolved) {
+    llvm::errs() << "symbol lookup and reparsing resolved different "
+                 << "types or attributes\n";
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,91 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicContext.h"
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Program.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <chrono>
+
+extern char **environ;
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// Load and register a dialect spec, as a DMC process does on startup.
+int loadSpec(StringRef filename) {
+  MLIRContext ctx;
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+  BenchLoader loader{&ctx};
+  return loader.loadSpec(filename, dynCtx) ? 0 : -1;
+}
+
+/// Run this program to load the spec and return the wall time in ms, or a
+/// negative value if it failed.
+double timeStartup(StringRef self, StringRef filename,
+                   ArrayRef<StringRef> env) {
+  StringRef args[] = {self, "--load", filename};
+  auto start = std::chrono::steady_clock::now();
+  auto ret = sys::ExecuteAndWait(self, args, env);
+  auto end = std::chrono::steady_clock::now();
+  if (ret)
+    return -1;
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+} // end anonymous namespace
+
+/// Measure the startup time of loading a dialect spec with a cold and a warm
+/// spec cache, e.g.
+///
+///   startupbench lua/lua.mlir 10
+///
+/// Each startup is a separate process, since the Python interpreter is global.
+/// The cache is kept in a temporary directory.
+int main(int argc, char *argv[]) {
+  if (argc == 3 && StringRef{argv[1]} == "--load")
+    return loadSpec(argv[2]);
+  if (argc != 2 && argc != 3) {
+    llvm::errs() << "Usage: startupbench <dialect_mlir> [iters]\n";
+    return -1;
+  }
+  unsigned iters = 10;
+  if (argc == 3 && StringRef{argv[2]}.getAsInteger(10, iters)) {
+    llvm::errs() << "Invalid number of iterations: " << argv[2] << "\n";
+    return -1;
+  }
+
+  SmallString<128> cacheDir;
+  if (sys::fs::createUniqueDirectory("dmc-spec-cache", cacheDir)) {
+    llvm::errs() << "Failed to create a cache directory\n";
+    return -1;
+  }
+  std::vector<std::string> envStrs;
+  for (auto **var = environ; *var; ++var) {
+    if (!StringRef{*var}.startswith("DMC_SPEC_CACHE"))
+      envStrs.push_back(*var);
+  }
+  envStrs.push_back(("DMC_SPEC_CACHE_DIR=" + cacheDir.str()).str());
+  std::vector<StringRef> env{envStrs.begin(), envStrs.end()};
+
+  auto self = sys::fs::getMainExecutable(argv[0], (void *) &loadSpec);
+  auto cold = timeStartup(self, argv[1], env);
+  double warm{};
+  for (unsigned i = 0; i < iters && cold >= 0 && warm >= 0; ++i) {
+    auto time = timeStartup(self, argv[1], env);
+    warm = time < 0 ? time : warm + time / iters;
+  }
+  sys::fs::remove_directories(cacheDir);
+  if (cold < 0 || warm < 0) {
+    llvm::errs() << "Failed to load dialect spec: " << argv[1] << "\n";
+    return -1;
+  }
+  llvm::outs() << "cold: " << cold << " ms\n"
+               << "warm: " << warm << " ms (average of " << iters << ")\n";
+  return 0;
+}
@@ -0,0 +1,109 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicType.h"
+#include "dmc/Dynamic/DynamicAttribute.h"
+#include "dmc/Spec/SpecOps.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/Parser.h>
+#include <mlir/IR/Module.h>
+
+#include <cstdlib>
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// Switch the types and attributes with a native format to the native or
+/// Python backend. Returns the number of such types and attributes.
+unsigned useNativeFormats(ModuleOp dialects, MLIRContext *ctx, bool native) {
+  unsigned numNative{};
+  for (auto dialectOp : dialects.getOps<DialectOp>()) {
+    auto *dialect = static_cast<DynamicDialect *>(
+        ctx->getRegisteredDialect(dialectOp.getName()));
+    for (auto *type : dialect->getTypes()) {
+      type->useNativeFormat(native);
+      numNative += type->hasNativeFormat();
+    }
+    for (auto *attr : dialect->getAttributes()) {
+      attr->useNativeFormat(native);
+      numNative += attr->hasNativeFormat();
+    }
+  }
+  return numNative;
+}
+
+} // end anonymous namespace
+
+/// Measure print and parse throughput of a module with many values of a
+/// dynamic type, with the Python and native format backends, e.g.
+///
+///   typebench spec/stencil.mlir '!stencil.field<?x?x?xf64>'
+///
+/// Each value is the result of a generic unregistered op.
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    llvm::errs() << "Usage: typebench <dialect_mlir> <type> [num_values]\n";
+    return -1;
+  }
+  unsigned numValues = 1000000;
+  if (argc == 4 && StringRef{argv[3]}.getAsInteger(10, numValues)) {
+    llvm::errs() << "Invalid number of values: " << argv[3] << "\n";
+    return -1;
+  }
+
+  /// Compile native formats so that both backends can be compared.
+  setenv("DMC_FORMAT_BACKEND", "native", /*overwrite=*/1);
+
+  MLIRContext ctx;
+  ctx.allowUnregisteredDialects();
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+
+  BenchLoader loader{&ctx};
+  auto dialectModule = loader.loadSpec(argv[1], dynCtx);
+  if (!dialectModule)
+    return -1;
+
+  auto type = mlir::parseType(argv[2], &ctx);
+  if (!type || !type.isa<DynamicType>()) {
+    llvm::errs() << "Expected a dynamic type: " << argv[2] << "\n";
+    return -1;
+  }
+
+  /// Build a flat module of `numValues` values.
+  auto loc = UnknownLoc::get(&ctx);
+  auto module = ModuleOp::create(loc);
+  OperationName opName{"typebench.value", &ctx};
+  for (unsigned i = 0; i < numValues; ++i)
+    module.push_back(Operation::create(loc, opName, type, {}, {}, {}, 0));
+
+  auto numNative = useNativeFormats(*dialectModule, &ctx, true);
+  std::string texts[2];
+  for (bool native : {false, true}) {
+    if (native && !numNative)
+      break;
+    useNativeFormats(*dialectModule, &ctx, native);
+    std::string prefix = native ? "native " : "python ";
+    auto &text = texts[native];
+    timePhase(prefix + "print", numValues, [&] {
+      llvm::raw_string_ostream os{text};
+      module.print(os);
+    }, /*iters=*/1, "value");
+    timePhase(prefix + "parse", numValues, [&] {
+      if (!parseSourceString(text, &ctx))
+        llvm::report_fatal_error("Failed to parse module");
+    }, /*iters=*/1, "value");
+  }
+  module.erase();
+
+  if (!numNative) {
+    llvm::outs() << "no native formats were compiled\n";
+  } else if (texts[0] != texts[1]) {
+    llvm::errs() << "backends printed different text\n";
+    return 1;
+  }
+  return 0;
+}
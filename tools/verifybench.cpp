@@ -0,0 +1,97 @@
+#include "BenchUtil.h"
+#include "dmc/Dynamic/DynamicDialect.h"
+#include "dmc/Dynamic/DynamicOperation.h"
+#include "dmc/Dynamic/ParallelVerifier.h"
+
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/Format.h>
+#include <llvm/Support/raw_ostream.h>
+#include <mlir/IR/Module.h>
+#include <mlir/IR/Verifier.h>
+
+#include <chrono>
+
+using namespace mlir;
+using namespace llvm;
+using namespace dmc;
+
+namespace {
+
+/// Time `iters` runs of a verifier in ms per run. Returns a negative value
+/// if verification failed.
+template <typename FcnT>
+double timeVerify(unsigned iters, FcnT fcn) {
+  auto start = std::chrono::steady_clock::now();
+  for (unsigned i = 0; i < iters; ++i) {
+    if (failed(fcn()))
+      return -1;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::milli>(end - start).count() /
+      iters;
+}
+
+} // end anonymous namespace
+
+/// Measure how verification of a module with dynamic ops scales with the
+/// number of threads, e.g.
+///
+///   verifybench lua/lua.mlir lua/perf.mlir
+///
+/// Each top-level function is verified by one worker, so the module should
+/// have at least as many functions as threads. Times are compared against
+/// the serial verifier.
+int main(int argc, char *argv[]) {
+  if (argc != 3 && argc != 4) {
+    llvm::errs() << "Usage: verifybench <dialect_mlir> <module_mlir> [iters]\n";
+    return -1;
+  }
+  unsigned iters = 20;
+  if (argc == 4 && StringRef{argv[3]}.getAsInteger(10, iters)) {
+    llvm::errs() << "Invalid number of iterations: " << argv[3] << "\n";
+    return -1;
+  }
+
+  MLIRContext ctx;
+  auto *dynCtx = ctx.getOrCreateDialect<DynamicContext>();
+
+  BenchLoader loader{&ctx};
+  auto dialectModule = loader.loadSpec(argv[1], dynCtx);
+  if (!dialectModule)
+    return -1;
+  auto module = loader.loadModule(argv[2]);
+  if (!module)
+    return -1;
+
+  unsigned numDynamic{}, numPython{};
+  module->walk([&](Operation *op) {
+    if (!BaseOp::classof(op))
+      return;
+    ++numDynamic;
+    numPython += DynamicOperation::of(op)->verifiesInPython();
+  });
+  auto numFuncs = llvm::size(module->getBody()->without_terminator());
+  llvm::outs() << numFuncs << " top-level ops, " << numDynamic
+               << " dynamic ops, " << numPython << " verify in Python\n";
+
+  auto serial = timeVerify(iters, [&] { return verify(*module); });
+  if (serial < 0) {
+    llvm::errs() << "Module failed to verify\n";
+    return 1;
+  }
+  llvm::outs() << "serial: " << format("%.3f", serial) << " ms\n";
+  for (unsigned threads : {1, 2, 4, 8, 16}) {
+    auto time = timeVerify(iters, [&] {
+      return verifyParallel(*module, threads);
+    });
+    if (time < 0) {
+      llvm::errs() << "Parallel verifier failed with " << threads
+                   << " threads\n";
+      return 1;
+    }
+    llvm::outs() << format("%2u", threads) << " threads: "
+                 << format("%.3f", time) << " ms ("
+                 << format("%.2f", serial / time) << "x)\n";
+  }
+  return 0;
+}